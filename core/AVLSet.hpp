@@ -11,6 +11,14 @@
 // the AVL tree acts like a binary search tree (e.g., it will become
 // degenerate if elements are added in ascending order).
 //
+// Copying or destroying a large AVLSet is split across threads: the top
+// few levels of the tree are handled by one thread, and the subtrees
+// hanging below them are divided among all of them.
+//
+// In a set of strings, each node also keeps its string's prefix (see
+// KeyPrefix.hpp), which settles most comparisons on the way down the tree
+// without reading the strings themselves.
+//
 // You are not permitted to use the containers in the C++ Standard Library
 // (such as std::set, std::map, or std::vector) to store the information
 // in your data structure.  Instead, you'll need to implement your AVL tree
@@ -20,30 +28,127 @@
 #ifndef AVLSET_HPP
 #define AVLSET_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "Set.hpp"
-#include <queue>
+#include "KeyPrefix.hpp"
+#include "NodePool.hpp"
+#include "Parallel.hpp"
 #include <algorithm>
 #include <cmath>
 
 
+
+namespace impl_
+{
+    // AVLSet__hasCompare<Key, ElementType>::value is true if a Key has a
+    // compare() member function that compares it with an ElementType in
+    // one pass, returning a negative number, zero, or a positive number,
+    // as std::string and std::string_view do.
+    template <typename Key, typename ElementType, typename = void>
+    struct AVLSet__hasCompare : std::false_type
+    {
+    };
+
+
+    template <typename Key, typename ElementType>
+    struct AVLSet__hasCompare<
+        Key, ElementType,
+        std::void_t<decltype(std::declval<const Key&>().compare(std::declval<const ElementType&>()))>>
+        : std::true_type
+    {
+    };
+}
+
+
 template <typename ElementType>
 class AVLSet : public Set<ElementType>
 {
+private:
+    struct Node;
+
 public:
     // A VisitFunction is a function that takes a reference to a const
-    // ElementType and returns no value.
+    // ElementType and returns no value.  The traversals accept one, but
+    // they also accept any other callable object (such as a lambda) that
+    // can be called the same way, calling it directly rather than through
+    // a std::function.
     using VisitFunction = std::function<void(const ElementType&)>;
 
+    // The limit on the number of elements visited by forEachInRange() and
+    // forEachWithPrefix() when none is given, which is no limit at all.
+    static constexpr std::size_t NO_LIMIT = std::numeric_limits<std::size_t>::max();
+
+    // The fewest elements worth giving to each thread when copying or
+    // destroying a tree in parallel; smaller trees use fewer threads (or
+    // one).
+    static constexpr unsigned int PARALLEL_THRESHOLD = 16384;
+
+
+    // A ConstIterator steps through the elements of an AVLSet in ascending
+    // order.  It keeps track of the nodes it has yet to return to (at most
+    // one per level of the tree), so it needs no links from children to
+    // their parents.  Adding an element to the set invalidates every
+    // iterator into it.
+    class ConstIterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ElementType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ElementType*;
+        using reference = const ElementType&;
+
+    public:
+        // Initializes a ConstIterator that is past the end of every set.
+        ConstIterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        ConstIterator& operator++();
+        ConstIterator operator++(int);
+
+        bool operator==(const ConstIterator& other) const noexcept;
+        bool operator!=(const ConstIterator& other) const noexcept;
+
+    private:
+        friend class AVLSet;
+
+        // The nodes whose left subtrees have been (or are being) visited
+        // but which haven't been themselves, with the current one last.
+        std::vector<const Node*> pending;
+
+        // pushLeftmost() pushes n and every node along the path from it
+        // to the leftmost node in its subtree
+        void pushLeftmost(const Node* n);
+    };
+
+    using const_iterator = ConstIterator;
+
 public:
-    // Initializes an AVLSet to be empty, with or without balancing.
-    explicit AVLSet(bool shouldBalance = true);
+    // Initializes an AVLSet to be empty, with or without balancing, and
+    // allocating its nodes either individually (the default) or from a
+    // NodePool.
+    explicit AVLSet(bool shouldBalance = true, bool usePool = false);
 
     // Cleans up the AVLSet so that it leaks no memory.
     ~AVLSet() noexcept override;
 
-    // Initializes a new AVLSet to be a copy of an existing one.
+    // Initializes a new AVLSet to be a copy of an existing one, copying
+    // subtrees in parallel if it's large enough, using the given number of
+    // threads (or, by default, one per hardware thread).
     AVLSet(const AVLSet& s);
+    AVLSet(const AVLSet& s, unsigned int threadCount);
 
     // Initializes a new AVLSet whose contents are moved from an
     // expiring one.
@@ -63,18 +168,81 @@ public:
 
     // add() adds an element to the set.  If the element is already in the set,
     // this function has no effect.  This function always runs in O(log n) time
-    // when there are n elements in the AVL tree.
+    // when there are n elements in the AVL tree.  It compares the element
+    // with each node on its way down only once, and retraces its path back
+    // up (to update heights and rebalance) without recursion.
     void add(const ElementType& element) override;
 
 
+    // addAll() adds every element in a vector to the set.  If the set is
+    // empty and balances itself, it's the same as assignSorted(), so
+    // elements that are already in ascending order are built into a tree
+    // in linear time.  Otherwise, it adds them one at a time.
+    void addAll(const std::vector<ElementType>& elements) override;
+
+
+    // assignSorted() replaces the set's elements with the given ones.  If
+    // the set balances itself and they're in ascending order (as, e.g., a
+    // sorted word file's are), with or without duplicates, it builds a
+    // perfectly balanced tree from them in O(n) time, without comparing or
+    // rotating anything more than checking the order requires.  Otherwise,
+    // it adds them one at a time, so a set that doesn't balance itself
+    // takes the same shape it would have if they'd been added with add().
+    void assignSorted(const std::vector<ElementType>& elements);
+
+
     // contains() returns true if the given element is already in the set,
     // false otherwise.  This function always runs in O(log n) time when
-    // there are n elements in the AVL tree.
+    // there are n elements in the AVL tree, comparing the element with
+    // each node it visits only once.  It can also search for a key, such
+    // as a std::string_view in a set of strings, which is compared with
+    // the elements directly rather than copied into one.
+    using Set<ElementType>::contains;
     bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
 
 
     // size() returns the number of elements in the set.
-    unsigned int size() const noexcept override;
+    std::size_t size() const noexcept override;
+
+
+    // clear() removes every element from the set.  If there are enough
+    // elements, subtrees are destroyed in parallel, using the given number
+    // of threads (or, if it's zero, one per hardware thread), as they are
+    // when a large AVLSet is destroyed.
+    void clear(unsigned int threadCount = 0);
+
+
+    // lowerBound() returns a pointer to the smallest element that isn't
+    // less than the given key (an element, or anything that compares with
+    // the elements the way one would), or nullptr if there's no such
+    // element.  It runs in O(log n) time.
+    template <typename Key>
+    const ElementType* lowerBound(const Key& key) const;
+
+
+    // forEachInRange() calls the given "visit" function, in ascending
+    // order, for each element that is at least lo and less than hi, up to
+    // the given limit, and returns how many it visited.  It finds the first
+    // of them the way lowerBound() does and stops at the last one, so it
+    // runs in O(log n + k) time when it visits k elements.
+    template <typename Key, typename Visit>
+    std::size_t forEachInRange(
+        const Key& lo, const Key& hi, Visit&& visit,
+        std::size_t limit = NO_LIMIT) const;
+
+
+    // forEachWithPrefix() calls the given "visit" function, in ascending
+    // order, for each string in the set that begins with the given prefix,
+    // up to the given limit, and returns how many it visited.  Since those
+    // strings are consecutive in order, it runs in O(log n + k) time when
+    // it visits k of them.
+    template <
+        typename Visit, typename E = ElementType,
+        typename = std::enable_if_t<std::is_same_v<E, std::string>>>
+    std::size_t forEachWithPrefix(
+        std::string_view prefix, Visit&& visit,
+        std::size_t limit = NO_LIMIT) const;
 
 
     // height() returns the height of the AVL tree.  Note that, by definition,
@@ -84,67 +252,160 @@ public:
 
     // preorder() calls the given "visit" function for each of the elements
     // in the set, in the order determined by a preorder traversal of the AVL
-    // tree.
-    void preorder(VisitFunction visit) const;
+    // tree.  Like the other traversals, it keeps track of where it is with
+    // a stack on the heap rather than by recursing, so even a tree without
+    // balancing, however tall, can't overflow the call stack.
+    template <typename Visit>
+    void preorder(Visit&& visit) const;
 
 
     // inorder() calls the given "visit" function for each of the elements
     // in the set, in the order determined by an inorder traversal of the AVL
     // tree.
-    void inorder(VisitFunction visit) const;
+    template <typename Visit>
+    void inorder(Visit&& visit) const;
 
 
     // postorder() calls the given "visit" function for each of the elements
     // in the set, in the order determined by a postorder traversal of the AVL
     // tree.
-    void postorder(VisitFunction visit) const;
+    template <typename Visit>
+    void postorder(Visit&& visit) const;
+
+
+    // begin() and end() return iterators to the first element (in
+    // ascending order) and past the last one.
+    ConstIterator begin() const;
+    ConstIterator end() const;
+
+
+    // poolStats() returns a summary of the nodes allocated from the
+    // AVLSet's NodePool, which is empty unless it was asked to use one.
+    NodePoolStats poolStats() const noexcept;
 
 private:
-    struct Node
+    using Prefix = impl_::KeyPrefix<ElementType>;
+
+    // The nodes of a set of strings also hold each string's prefix (see
+    // KeyPrefix.hpp), so that most comparisons on the way down the tree
+    // are settled without reading the strings at all.  Other nodes have
+    // nothing more than an empty base.
+    struct NodePrefix
     {
+        std::uint64_t prefix;
+    };
+
+    struct NoNodePrefix
+    {
+    };
+
+    struct Node : std::conditional_t<Prefix::enabled, NodePrefix, NoNodePrefix>
+    {
+        Node(const ElementType& value, int height, Node* left, Node* right);
+
         ElementType value;
         int height;
         Node* left;
         Node* right;
     };
 
+private:
+    // The longest path add() keeps track of without allocating memory.  No
+    // balanced tree that fits in memory is nearly this tall, so only a
+    // tree without balancing can need more.
+    static constexpr std::size_t PATH_CAPACITY = 96;
+
+    // When a tree is copied or destroyed in parallel, it's split into about
+    // this many subtrees per thread, so that threads given small subtrees
+    // can move on to others.
+    static constexpr unsigned int SUBTREES_PER_THREAD = 4;
+
 private:
     // You'll no doubt want to add member variables and "helper" member
     // functions here.
-    unsigned int sz;
+    std::size_t sz;
     bool shouldBalance;
     Node* root;
 
+    // When usePool is true, every node is created in (and only released
+    // along with) the pool.
+    bool usePool;
+    NodePool<Node> pool;
+
 private:
-    // insert() follows nptr to recursively find an appropriate place to 
-    // add the element, and returns nptr
-    Node* insert(Node* nptr, const ElementType& element);
-    
     // maxHeight() calculates and returns the max height of the AVLTree
     // that nptr points to
     int maxHeight(Node* nptr) const noexcept;
 
-    // preorderT() recursively traverses the elements in preorder
-    // in the AVL Tree and calls the visit function on each element
-    void preorderT(Node* nptr, VisitFunction visit) const;
-    
-    // inorderT() recursively traverses the elements in inorder
-    // in the AVL Tree and calls the visit function on each element
-    void inorderT(Node* nptr, VisitFunction visit) const;
-
-    // postorderT() recursively traverses the elements in postorder
-    // in the AVL Tree and calls the visit function on each element
-    void postorderT(Node* nptr, VisitFunction visit) const;
-    
-    // copyNodes() copies the nodes in the source to the target
-    void copyNodes(Node*& target, const Node* source);
-    
-    // deallocateTree() deallocates the AVLTree that root points to
-    void deallocateTree() noexcept;
-
-    // difference() calculate the difference between the height of
-    // the current tree's left sub-tree and the height of its right sub-tree
-    int difference(Node* n) const noexcept;
+    // containsKey() searches for an element, or a key that compares with
+    // the elements the same way that element would
+    template <typename Key>
+    bool containsKey(const Key& element) const;
+
+    // compare() compares an element (or key) with a node's value, using
+    // one three-way comparison if the key has a compare() member function
+    // and at most two uses of < otherwise, and returns a negative number,
+    // zero, or a positive number, the way std::string::compare() does
+    template <typename Key>
+    static int compare(const Key& key, const ElementType& value);
+
+    // prefixOf() returns the prefix of an element (or key), or zero if the
+    // nodes have no prefixes
+    template <typename Key>
+    static std::uint64_t prefixOf(const Key& key) noexcept;
+
+    // compareWith() compares an element (or key), whose prefix is given,
+    // with a node's value the way compare() does, but if the node has a
+    // prefix that differs from the key's, compares only the prefixes
+    template <typename Key>
+    static int compareWith(const Key& key, std::uint64_t keyPrefix, const Node* n);
+
+    // seek() returns an iterator to the smallest element that isn't less
+    // than lo
+    template <typename Key>
+    ConstIterator seek(const Key& lo) const;
+
+    // visitFrom() visits the elements in ascending order, beginning with
+    // the smallest one that isn't less than lo, until limit of them have
+    // been visited or inRange() returns false for one, and returns how
+    // many it visited
+    template <typename Key, typename InRange, typename Visit>
+    std::size_t visitFrom(const Key& lo, InRange inRange, Visit& visit, std::size_t limit) const;
+
+    // updateHeight() recalculates a node's height from its children's
+    static void updateHeight(Node* n) noexcept;
+
+    // rebalance() rotates the subtree rooted at n, if its children's heights
+    // differ by more than one, and returns the root of the subtree
+    Node* rebalance(Node* n);
+
+    // makeNode() creates a new leaf node, in the given pool if the set
+    // uses one
+    Node* makeNode(const ElementType& value, int height, NodePool<Node>& nodePool);
+
+    // copyNodes() copies the nodes in the source to the target, without
+    // recursion, creating them in the given pool if the set uses one
+    void copyNodes(Node*& target, const Node* source, NodePool<Node>& nodePool);
+
+    // copyInParallel() copies the nodes in the source to root, copying
+    // subtrees on the given number of threads
+    void copyInParallel(const Node* source, unsigned int threadCount);
+
+    // deallocateTree() deallocates the AVLTree that root points to, using
+    // the given number of threads (or, if it's zero, one per hardware thread)
+    void deallocateTree(unsigned int threadCount = 0) noexcept;
+
+    // destroyInParallel() deletes every node in the tree, destroying
+    // subtrees on the given number of threads
+    void destroyInParallel(unsigned int threadCount);
+
+    // destroyNodes() deletes every node in the subtree n points to, unless
+    // they're in the pool (and so are released along with it)
+    void destroyNodes(Node* n) noexcept;
+
+    // buildBalanced() builds a perfectly balanced tree from count elements
+    // in ascending order, with the middle one at its root, and returns it
+    Node* buildBalanced(const ElementType* const* elements, std::size_t count);
 
     // LL() implements LL rotation on the current Node
     Node* LL(Node* n);
@@ -161,26 +422,106 @@ private:
 
 
 template <typename ElementType>
-AVLSet<ElementType>::AVLSet(bool shouldBalance)
-    :sz{0}, shouldBalance{shouldBalance}, root{nullptr}
+AVLSet<ElementType>::AVLSet(bool shouldBalance, bool usePool)
+    :sz{0}, shouldBalance{shouldBalance}, root{nullptr}, usePool{usePool}
+{
+}
+
+
+template <typename ElementType>
+void AVLSet<ElementType>::deallocateTree(unsigned int threadCount) noexcept
 {
+    if (usePool)
+    {
+        // every node lives in the pool, so release them all at once
+        pool.clear();
+        return;
+    }
+
+    threadCount = impl_::threadsToUse(threadCount, sz, PARALLEL_THRESHOLD);
+    if (threadCount > 1)
+    {
+        try
+        {
+            destroyInParallel(threadCount);
+            return;
+        }
+        catch (...)
+        {
+            // the work couldn't be split up, which happens before any node
+            // is destroyed, so they're all destroyed below instead
+        }
+    }
+
+    destroyNodes(root);
+}
+
+
+template <typename ElementType>
+void AVLSet<ElementType>::destroyInParallel(unsigned int threadCount)
+{
+    // gather the top levels of the tree, one level at a time, until enough
+    // subtrees hang below them to keep every thread busy
+    std::vector<Node*> top;
+    std::vector<Node*> subtrees;
+    if (root != nullptr) subtrees.push_back(root);
+
+    while (!subtrees.empty() && subtrees.size() < threadCount * SUBTREES_PER_THREAD)
+    {
+        std::vector<Node*> below;
+        for (Node* n : subtrees)
+        {
+            top.push_back(n);
+            if (n->left != nullptr) below.push_back(n->left);
+            if (n->right != nullptr) below.push_back(n->right);
+        }
+        subtrees = std::move(below);
+    }
+
+    // then each thread destroys subtrees, claiming the next one no thread
+    // has destroyed yet; nothing here can throw once the threads are running
+    std::atomic<std::size_t> next{0};
+
+    impl_::runInParallel(
+        threadCount,
+        [&](unsigned int)
+        {
+            for (std::size_t i = next++; i < subtrees.size(); i = next++)
+            {
+                destroyNodes(subtrees[i]);
+            }
+        });
+
+    for (Node* n : top)
+    {
+        delete n;
+    }
 }
 
 
 template <typename ElementType>
-void AVLSet<ElementType>::deallocateTree() noexcept
+void AVLSet<ElementType>::destroyNodes(Node* n) noexcept
 {
-    if (root != nullptr)
+    if (!usePool && n != nullptr)
     {
-        std::queue<Node*> Q;
-        Q.push(root);
-        while (!Q.empty())
+        // rotating each left child up until there's none left turns the
+        // tree into a chain of right children, deleting nodes as it goes,
+        // so this needs no extra memory (and can't fail for lack of it)
+        while (n != nullptr)
         {
-            Node* temp = Q.front();
-            Q.pop();
-            if (temp->left != nullptr) Q.push(temp->left);
-            if (temp->right != nullptr) Q.push(temp->right);
-            delete temp;
+            if (n->left != nullptr)
+            {
+                Node* left = n->left;
+                n->left = left->right;
+                left->right = n;
+                n = left;
+            }
+            else
+            {
+                Node* right = n->right;
+                delete n;
+                n = right;
+            }
         }
     }
 }
@@ -194,36 +535,161 @@ AVLSet<ElementType>::~AVLSet() noexcept
 
 
 template <typename ElementType>
-void AVLSet<ElementType>::copyNodes(Node*& target, const Node* source)
+void AVLSet<ElementType>::clear(unsigned int threadCount)
 {
-    if (source != nullptr)
+    deallocateTree(threadCount);
+    root = nullptr;
+    sz = 0;
+}
+
+
+template <typename ElementType>
+AVLSet<ElementType>::Node::Node(const ElementType& value, int height, Node* left, Node* right)
+    : value{value}, height{height}, left{left}, right{right}
+{
+    if constexpr (Prefix::enabled)
+    {
+        this->prefix = Prefix::of(this->value);
+    }
+}
+
+
+template <typename ElementType>
+typename AVLSet<ElementType>::Node* AVLSet<ElementType>::makeNode(
+    const ElementType& value, int height, NodePool<Node>& nodePool)
+{
+    if (usePool)
+    {
+        return nodePool.create(value, height, nullptr, nullptr);
+    }
+    else
+    {
+        return new Node{value, height, nullptr, nullptr};
+    }
+}
+
+
+template <typename ElementType>
+void AVLSet<ElementType>::copyNodes(Node*& target, const Node* source, NodePool<Node>& nodePool)
+{
+    // each copy is linked into its place as soon as it's made, so if making
+    // one fails, every copy made so far can still be found and destroyed
+    std::vector<std::pair<const Node*, Node**>> pending;
+    if (source != nullptr) pending.emplace_back(source, &target);
+
+    while (!pending.empty())
+    {
+        auto [from, to] = pending.back();
+        pending.pop_back();
+
+        *to = makeNode(from->value, from->height, nodePool);
+        if (from->right != nullptr) pending.emplace_back(from->right, &(*to)->right);
+        if (from->left != nullptr) pending.emplace_back(from->left, &(*to)->left);
+    }
+}
+
+
+template <typename ElementType>
+void AVLSet<ElementType>::copyInParallel(const Node* source, unsigned int threadCount)
+{
+    // copy the top levels of the tree, one level at a time, until enough
+    // subtrees hang below them to keep every thread busy
+    std::vector<std::pair<const Node*, Node**>> subtrees;
+    if (source != nullptr) subtrees.emplace_back(source, &root);
+
+    while (!subtrees.empty() && subtrees.size() < threadCount * SUBTREES_PER_THREAD)
+    {
+        std::vector<std::pair<const Node*, Node**>> below;
+        for (auto [from, to] : subtrees)
+        {
+            *to = makeNode(from->value, from->height, pool);
+            if (from->left != nullptr) below.emplace_back(from->left, &(*to)->left);
+            if (from->right != nullptr) below.emplace_back(from->right, &(*to)->right);
+        }
+        subtrees = std::move(below);
+    }
+
+    // then each thread copies subtrees, claiming the next one no thread has
+    // copied yet and creating nodes in a pool of its own if the set uses a
+    // pool; the pools are merged into the set's afterward, even if a thread
+    // failed, so that every node that was created can be released
+    std::vector<NodePool<Node>> pools(threadCount);
+    std::atomic<std::size_t> next{0};
+
+    auto mergePools = [&]()
+    {
+        for (NodePool<Node>& threadPool : pools)
+        {
+            pool.merge(std::move(threadPool));
+        }
+    };
+
+    try
+    {
+        impl_::runInParallel(
+            threadCount,
+            [&](unsigned int t)
+            {
+                for (std::size_t i = next++; i < subtrees.size(); i = next++)
+                {
+                    copyNodes(*subtrees[i].second, subtrees[i].first, pools[t]);
+                }
+            });
+    }
+    catch (...)
     {
-        target = new Node{source->value, source->height, nullptr, nullptr};
-        copyNodes(target->left, source->left);
-        copyNodes(target->right, source->right);
+        mergePools();
+        throw;
     }
+
+    mergePools();
 }
 
 
 template <typename ElementType>
 AVLSet<ElementType>::AVLSet(const AVLSet& s)
-    : sz{0}, shouldBalance{true}, root{nullptr}
+    : AVLSet{s, 0}
 {
-    Node* tempTree = nullptr;
-    copyNodes(tempTree, s.root);
+}
+
+
+template <typename ElementType>
+AVLSet<ElementType>::AVLSet(const AVLSet& s, unsigned int threadCount)
+    : sz{0}, shouldBalance{s.shouldBalance}, root{nullptr}, usePool{s.usePool}
+{
+    threadCount = impl_::threadsToUse(threadCount, s.sz, PARALLEL_THRESHOLD);
+
+    try
+    {
+        if (threadCount > 1)
+        {
+            copyInParallel(s.root, threadCount);
+        }
+        else
+        {
+            copyNodes(root, s.root, pool);
+        }
+    }
+    catch (...)
+    {
+        // every node copied so far is linked into the tree (or the pool)
+        deallocateTree(1);
+        throw;
+    }
+
     sz = s.sz;
-    shouldBalance = s.shouldBalance;
-    root = tempTree;
 }
 
 
 template <typename ElementType>
 AVLSet<ElementType>::AVLSet(AVLSet&& s) noexcept
-    : sz{0}, shouldBalance{true}, root{nullptr}
+    : sz{0}, shouldBalance{true}, root{nullptr}, usePool{false}
 {
     std::swap(sz, s.sz);
     std::swap(shouldBalance, s.shouldBalance);
     std::swap(root, s.root);
+    std::swap(usePool, s.usePool);
+    std::swap(pool, s.pool);
 }
 
 
@@ -232,12 +698,10 @@ AVLSet<ElementType>& AVLSet<ElementType>::operator=(const AVLSet& s)
 {
     if (this != &s)
     {
-        Node* tempTree = nullptr;
-        copyNodes(tempTree, s.root);
-        sz = s.sz;
-        shouldBalance = s.shouldBalance;
-        deallocateTree();  // deallocate the old AVLTree
-        root = tempTree;
+        // copy into a separate AVLSet (and, so, a separate pool) first,
+        // so the old nodes can all be released together afterward
+        AVLSet copy{s};
+        *this = std::move(copy);
     }
     return *this;
 }
@@ -249,6 +713,8 @@ AVLSet<ElementType>& AVLSet<ElementType>::operator=(AVLSet&& s) noexcept
     std::swap(sz, s.sz);
     std::swap(shouldBalance, s.shouldBalance);
     std::swap(root, s.root);
+    std::swap(usePool, s.usePool);
+    std::swap(pool, s.pool);
     return *this;
 }
 
@@ -260,14 +726,6 @@ bool AVLSet<ElementType>::isImplemented() const noexcept
 }
 
 
-template <typename ElementType>
-int AVLSet<ElementType>::difference(Node* n) const noexcept
-{
-    return std::abs(((n->left != nullptr) ? n->left->height : -1) - 
-        ((n->right != nullptr) ? n->right->height : -1));
-}
-
-
 template <typename ElementType>
 typename AVLSet<ElementType>::Node* AVLSet<ElementType>::LL(Node* n)
 {
@@ -349,70 +807,377 @@ typename AVLSet<ElementType>::Node* AVLSet<ElementType>::RL(Node* n)
 
 
 template <typename ElementType>
-typename AVLSet<ElementType>::Node* AVLSet<ElementType>::insert(Node* n, const ElementType& element)
+void AVLSet<ElementType>::add(const ElementType& element)
 {
-    if (n == nullptr)
+    // path[i] is the link (root, or a node's left or right) followed at
+    // depth i on the way down, so the path can be retraced on the way up;
+    // any of it beyond PATH_CAPACITY (which only a tree without balancing
+    // can reach) goes in overflow instead
+    Node** path[PATH_CAPACITY];
+    std::vector<Node**> overflow;
+    std::size_t length = 0;
+
+    std::uint64_t elementPrefix = prefixOf(element);
+
+    Node** link = &root;
+    while (*link != nullptr)
     {
-        n = new Node{element, 0, nullptr, nullptr};
-        sz++;
-        return n;
+        int order = compareWith(element, elementPrefix, *link);
+        if (order == 0) return;
+
+        if (length < PATH_CAPACITY)
+        {
+            path[length] = link;
+        }
+        else
+        {
+            overflow.push_back(link);
+        }
+        length++;
+
+        link = (order < 0) ? &(*link)->left : &(*link)->right;
+    }
+
+    *link = makeNode(element, 0, pool);
+    sz++;
+
+    // once a subtree's height is the same as it was before (which, after a
+    // rotation, it always is), nothing above it can have changed
+    while (length > 0)
+    {
+        length--;
+        link = (length < PATH_CAPACITY) ? path[length] : overflow[length - PATH_CAPACITY];
+
+        int oldHeight = (*link)->height;
+        updateHeight(*link);
+        *link = rebalance(*link);
+
+        if ((*link)->height == oldHeight) break;
+    }
+}
+
+
+template <typename ElementType>
+void AVLSet<ElementType>::addAll(const std::vector<ElementType>& elements)
+{
+    if (sz == 0 && shouldBalance)
+    {
+        assignSorted(elements);
     }
     else
     {
-        if (element < n->value)
+        for (const ElementType& element : elements)
         {
-            n->left = insert(n->left, element);
+            add(element);
         }
-        else if (element > n->value)
+    }
+}
+
+
+template <typename ElementType>
+void AVLSet<ElementType>::assignSorted(const std::vector<ElementType>& elements)
+{
+    // the distinct elements, in order, or as many as were found before
+    // finding that they aren't in order
+    std::vector<const ElementType*> distinct;
+    bool ascending = shouldBalance;
+
+    if (shouldBalance)
+    {
+        distinct.reserve(elements.size());
+
+        for (const ElementType& element : elements)
         {
-            n->right = insert(n->right, element);
+            int order = distinct.empty() ? -1 : compare(*distinct.back(), element);
+            if (order < 0)
+            {
+                distinct.push_back(&element);
+            }
+            else if (order > 0)
+            {
+                ascending = false;
+                break;
+            }
         }
-        n->height++;
-        if (shouldBalance && difference(n) > 1)
+    }
+
+    // the new tree is built separately, so that the old one (and its pool,
+    // if it has one) is released only once the new one is finished
+    AVLSet built{shouldBalance, usePool};
+
+    if (ascending)
+    {
+        built.root = built.buildBalanced(distinct.data(), distinct.size());
+        built.sz = distinct.size();
+    }
+    else
+    {
+        for (const ElementType& element : elements)
         {
-            if (element < n->value && element < n->left->value) n = LL(n);
-            else if (element > n->value &&element >n->right->value) n = RR(n);
-            else if (element < n->value &&element >n->left->value) n = LR(n);
-            else if (element > n->value &&element <n->right->value) n = RL(n);
+            built.add(element);
         }
-        n->height = std::max(((n->left != nullptr) ? n->left->height : -1), 
-            ((n->right != nullptr) ? n->right->height : -1)) + 1;
     }
+
+    *this = std::move(built);
+}
+
+
+template <typename ElementType>
+typename AVLSet<ElementType>::Node* AVLSet<ElementType>::buildBalanced(
+    const ElementType* const* elements, std::size_t count)
+{
+    if (count == 0)
+    {
+        return nullptr;
+    }
+
+    // the two halves' sizes differ by at most one, so their heights do too,
+    // which is all an AVL tree requires
+    std::size_t middle = count / 2;
+    Node* left = buildBalanced(elements, middle);
+    Node* right = nullptr;
+    Node* n = nullptr;
+
+    try
+    {
+        right = buildBalanced(elements + middle + 1, count - middle - 1);
+        n = makeNode(*elements[middle], 0, pool);
+    }
+    catch (...)
+    {
+        destroyNodes(left);
+        destroyNodes(right);
+        throw;
+    }
+
+    n->left = left;
+    n->right = right;
+    updateHeight(n);
     return n;
 }
 
 
 template <typename ElementType>
-void AVLSet<ElementType>::add(const ElementType& element)
+void AVLSet<ElementType>::updateHeight(Node* n) noexcept
 {
-    root = insert(root, element);
+    n->height = std::max(((n->left != nullptr) ? n->left->height : -1),
+        ((n->right != nullptr) ? n->right->height : -1)) + 1;
+}
+
+
+template <typename ElementType>
+typename AVLSet<ElementType>::Node* AVLSet<ElementType>::rebalance(Node* n)
+{
+    if (!shouldBalance)
+    {
+        return n;
+    }
+
+    // after adding one element, the taller child of an unbalanced node is
+    // itself leaning one way or the other, never balanced, so its heights
+    // choose the rotation without comparing any more elements
+    int balance = maxHeight(n->left) - maxHeight(n->right);
+
+    if (balance > 1)
+    {
+        return (maxHeight(n->left->left) > maxHeight(n->left->right)) ? LL(n) : LR(n);
+    }
+    else if (balance < -1)
+    {
+        return (maxHeight(n->right->right) > maxHeight(n->right->left)) ? RR(n) : RL(n);
+    }
+    else
+    {
+        return n;
+    }
 }
 
 
 template <typename ElementType>
 bool AVLSet<ElementType>::contains(const ElementType& element) const
 {
-    Node* current = root;
-    while(current != nullptr)
+    return containsKey(element);
+}
+
+
+template <typename ElementType>
+bool AVLSet<ElementType>::contains(SetKeyType<ElementType> key) const
+{
+    return containsKey(impl_::SetKey<ElementType>::get(key));
+}
+
+
+template <typename ElementType>
+template <typename Key>
+bool AVLSet<ElementType>::containsKey(const Key& element) const
+{
+    std::uint64_t elementPrefix = prefixOf(element);
+
+    const Node* current = root;
+    while (current != nullptr)
+    {
+        int order = compareWith(element, elementPrefix, current);
+        if (order == 0) return true;
+
+        current = (order < 0) ? current->left : current->right;
+    }
+    return false;
+}
+
+
+template <typename ElementType>
+template <typename Key>
+int AVLSet<ElementType>::compare(const Key& key, const ElementType& value)
+{
+    if constexpr (impl_::AVLSet__hasCompare<Key, ElementType>::value)
+    {
+        return key.compare(value);
+    }
+    else if (key < value)
+    {
+        return -1;
+    }
+    else
+    {
+        return (value < key) ? 1 : 0;
+    }
+}
+
+
+template <typename ElementType>
+template <typename Key>
+std::uint64_t AVLSet<ElementType>::prefixOf(const Key& key) noexcept
+{
+    if constexpr (Prefix::enabled)
+    {
+        return Prefix::of(std::string_view{key});
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+
+template <typename ElementType>
+template <typename Key>
+int AVLSet<ElementType>::compareWith(const Key& key, std::uint64_t keyPrefix, const Node* n)
+{
+    if constexpr (Prefix::enabled)
+    {
+        if (keyPrefix != n->prefix)
+        {
+            return (keyPrefix < n->prefix) ? -1 : 1;
+        }
+    }
+
+    return compare(key, n->value);
+}
+
+
+template <typename ElementType>
+std::size_t AVLSet<ElementType>::size() const noexcept
+{
+    return sz;
+}
+
+
+template <typename ElementType>
+template <typename Key>
+const ElementType* AVLSet<ElementType>::lowerBound(const Key& key) const
+{
+    // the last node where the search went left is the smallest one seen
+    // that isn't less than the key
+    const ElementType* bound = nullptr;
+    std::uint64_t keyPrefix = prefixOf(key);
+
+    const Node* current = root;
+    while (current != nullptr)
     {
-        if (current->value == element) return true;
-        if (element < current->value)
+        int order = compareWith(key, keyPrefix, current);
+        if (order == 0) return &current->value;
+
+        if (order < 0)
         {
+            bound = &current->value;
             current = current->left;
         }
-        else if (element > current->value)
+        else
         {
             current = current->right;
         }
     }
-    return false;
+
+    return bound;
 }
 
 
 template <typename ElementType>
-unsigned int AVLSet<ElementType>::size() const noexcept
+template <typename Key, typename Visit>
+std::size_t AVLSet<ElementType>::forEachInRange(
+    const Key& lo, const Key& hi, Visit&& visit, std::size_t limit) const
 {
-    return sz;
+    return visitFrom(
+        lo, [&](const ElementType& value) { return compare(hi, value) > 0; },
+        visit, limit);
+}
+
+
+template <typename ElementType>
+template <typename Visit, typename E, typename>
+std::size_t AVLSet<ElementType>::forEachWithPrefix(
+    std::string_view prefix, Visit&& visit, std::size_t limit) const
+{
+    return visitFrom(
+        prefix,
+        [&](const ElementType& value) { return value.compare(0, prefix.length(), prefix) == 0; },
+        visit, limit);
+}
+
+
+template <typename ElementType>
+template <typename Key>
+typename AVLSet<ElementType>::ConstIterator AVLSet<ElementType>::seek(const Key& lo) const
+{
+    // the nodes where the search for lo goes left are the ones that come
+    // after it in order, nearest last, which is just what an iterator
+    // would have pending if it had stepped there from the beginning
+    ConstIterator i;
+    std::uint64_t loPrefix = prefixOf(lo);
+
+    for (const Node* current = root; current != nullptr; )
+    {
+        if (compareWith(lo, loPrefix, current) <= 0)
+        {
+            i.pending.push_back(current);
+            current = current->left;
+        }
+        else
+        {
+            current = current->right;
+        }
+    }
+
+    return i;
+}
+
+
+template <typename ElementType>
+template <typename Key, typename InRange, typename Visit>
+std::size_t AVLSet<ElementType>::visitFrom(
+    const Key& lo, InRange inRange, Visit& visit, std::size_t limit) const
+{
+    std::size_t visited = 0;
+
+    for (ConstIterator i = seek(lo), last = end(); i != last && visited < limit; ++i)
+    {
+        if (!inRange(*i)) break;
+
+        visit(*i);
+        visited++;
+    }
+
+    return visited;
 }
 
 
@@ -438,57 +1203,162 @@ int AVLSet<ElementType>::height() const noexcept
 
 
 template <typename ElementType>
-void AVLSet<ElementType>::preorderT(Node* nptr, VisitFunction visit) const
+template <typename Visit>
+void AVLSet<ElementType>::preorder(Visit&& visit) const
 {
-    if (nptr != nullptr)
+    std::vector<const Node*> pending;
+    if (root != nullptr) pending.push_back(root);
+
+    while (!pending.empty())
     {
-        visit(nptr->value);
-        preorderT(nptr->left, visit);
-        preorderT(nptr->right, visit);
+        const Node* n = pending.back();
+        pending.pop_back();
+
+        visit(n->value);
+
+        // the left subtree goes on top, so it's visited first
+        if (n->right != nullptr) pending.push_back(n->right);
+        if (n->left != nullptr) pending.push_back(n->left);
     }
 }
 
 
 template <typename ElementType>
-void AVLSet<ElementType>::preorder(VisitFunction visit) const
+template <typename Visit>
+void AVLSet<ElementType>::inorder(Visit&& visit) const
 {
-    preorderT(root, visit);
+    for (const ElementType& element : *this)
+    {
+        visit(element);
+    }
 }
 
 
 template <typename ElementType>
-void AVLSet<ElementType>::inorderT(Node* nptr, VisitFunction visit) const
+template <typename Visit>
+void AVLSet<ElementType>::postorder(Visit&& visit) const
 {
-    if (nptr != nullptr)
+    // a node on the stack is visited once its right subtree is finished,
+    // which is when the node visited just before it is its right child
+    // (or it has none)
+    std::vector<const Node*> pending;
+    const Node* current = root;
+    const Node* lastVisited = nullptr;
+
+    while (current != nullptr || !pending.empty())
     {
-        inorderT(nptr->left, visit);
-        visit(nptr->value);
-        inorderT(nptr->right, visit);
+        if (current != nullptr)
+        {
+            pending.push_back(current);
+            current = current->left;
+        }
+        else
+        {
+            const Node* n = pending.back();
+
+            if (n->right != nullptr && n->right != lastVisited)
+            {
+                current = n->right;
+            }
+            else
+            {
+                visit(n->value);
+                lastVisited = n;
+                pending.pop_back();
+            }
+        }
     }
 }
 
+
+template <typename ElementType>
+typename AVLSet<ElementType>::ConstIterator AVLSet<ElementType>::begin() const
+{
+    ConstIterator i;
+    i.pushLeftmost(root);
+    return i;
+}
+
+
+template <typename ElementType>
+typename AVLSet<ElementType>::ConstIterator AVLSet<ElementType>::end() const
+{
+    return ConstIterator{};
+}
+
+
+template <typename ElementType>
+typename AVLSet<ElementType>::ConstIterator::reference
+AVLSet<ElementType>::ConstIterator::operator*() const
+{
+    return pending.back()->value;
+}
+
+
 template <typename ElementType>
-void AVLSet<ElementType>::inorder(VisitFunction visit) const
+typename AVLSet<ElementType>::ConstIterator::pointer
+AVLSet<ElementType>::ConstIterator::operator->() const
 {
-    inorderT(root, visit);
+    return &pending.back()->value;
 }
 
 
 template <typename ElementType>
-void AVLSet<ElementType>::postorderT(Node* nptr, VisitFunction visit) const
+typename AVLSet<ElementType>::ConstIterator& AVLSet<ElementType>::ConstIterator::operator++()
 {
-    if (nptr != nullptr)
+    // the next element is the leftmost one in the current node's right
+    // subtree or, if it has none, the nearest node still pending
+    const Node* n = pending.back();
+    pending.pop_back();
+    pushLeftmost(n->right);
+    return *this;
+}
+
+
+template <typename ElementType>
+typename AVLSet<ElementType>::ConstIterator AVLSet<ElementType>::ConstIterator::operator++(int)
+{
+    ConstIterator old = *this;
+    ++*this;
+    return old;
+}
+
+
+template <typename ElementType>
+bool AVLSet<ElementType>::ConstIterator::operator==(const ConstIterator& other) const noexcept
+{
+    if (pending.empty() || other.pending.empty())
+    {
+        return pending.empty() && other.pending.empty();
+    }
+    else
     {
-        postorderT(nptr->left, visit);
-        postorderT(nptr->right, visit);
-        visit(nptr->value);
+        return pending.back() == other.pending.back();
     }
 }
 
+
+template <typename ElementType>
+bool AVLSet<ElementType>::ConstIterator::operator!=(const ConstIterator& other) const noexcept
+{
+    return !(*this == other);
+}
+
+
+template <typename ElementType>
+void AVLSet<ElementType>::ConstIterator::pushLeftmost(const Node* n)
+{
+    for (; n != nullptr; n = n->left)
+    {
+        pending.push_back(n);
+    }
+}
+
+
 template <typename ElementType>
-void AVLSet<ElementType>::postorder(VisitFunction visit) const
+NodePoolStats AVLSet<ElementType>::poolStats() const noexcept
 {
-    postorderT(root, visit);
+    return pool.stats();
 }
 
 
@@ -0,0 +1,963 @@
+// BTreeSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A BTreeSet is an implementation of a Set that is a B-tree.  Where each
+// node of an AVLSet holds one element, so a search takes about log2 n
+// steps, each of them a cache miss, each node of a BTreeSet holds up to
+// MAX_KEYS of them, in ascending order, with a child between each pair, so
+// a search visits only about log(n) / log(MAX_KEYS) nodes (four or five,
+// rather than twenty-odd, for a few hundred thousand words).
+//
+// MAX_KEYS is chosen so that the part of a node a search scans fits in two
+// cache lines (which are typically fetched together), and nodes are
+// allocated on cache-line boundaries.  For sets of strings, that part
+// isn't the strings themselves, whose characters are usually elsewhere in
+// memory, but each one's prefix (see KeyPrefix.hpp).  A search compares
+// prefixes first and looks at a string only when its prefix is the same as
+// the one being searched for, which, for most words, happens once, at the
+// very end.  For other element types, the elements are scanned directly.
+//
+// Elements are moved within and between nodes as they fill up and split,
+// so an ElementType must be default-constructible and movable without
+// throwing an exception, as std::string is.
+
+#ifndef BTREESET_HPP
+#define BTREESET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "AVLSet.hpp"
+#include "KeyPrefix.hpp"
+#include "Set.hpp"
+
+
+
+namespace impl_
+{
+    // BTreeSet__maxKeys<ElementType>() returns the odd number of elements
+    // (at least 3) whose prefixes (or, without prefixes, the elements
+    // themselves), following a node's 8-byte header, fit in searchBytes.
+    template <typename ElementType>
+    constexpr unsigned int BTreeSet__maxKeys(std::size_t searchBytes)
+    {
+        std::size_t keyBytes =
+            KeyPrefix<ElementType>::enabled ? sizeof(std::uint64_t) : sizeof(ElementType);
+
+        std::size_t keys = std::max<std::size_t>(3, (searchBytes - 8) / keyBytes);
+        keys = std::min<std::size_t>(keys, 255);
+
+        return static_cast<unsigned int>(keys % 2 == 0 ? keys - 1 : keys);
+    }
+}
+
+
+template <typename ElementType>
+class BTreeSet : public Set<ElementType>
+{
+private:
+    struct Node;
+
+public:
+    // A VisitFunction is a function that takes a reference to a const
+    // ElementType and returns no value.  inorder() accepts one, but it
+    // also accepts any other callable object that can be called the same
+    // way, as the other traversals do.
+    using VisitFunction = std::function<void(const ElementType&)>;
+
+    // The limit on the number of elements visited by forEachInRange() and
+    // forEachWithPrefix() when none is given, which is no limit at all.
+    static constexpr std::size_t NO_LIMIT = std::numeric_limits<std::size_t>::max();
+
+    // The size of a cache line, to which nodes are aligned.
+    static constexpr std::size_t CACHE_LINE_BYTES = 64;
+
+    // The most elements a node can hold.  A node that is split gives half
+    // of them (less one, which moves up to its parent) to a new sibling.
+    static constexpr unsigned int MAX_KEYS =
+        impl_::BTreeSet__maxKeys<ElementType>(2 * CACHE_LINE_BYTES);
+
+
+    // A ConstIterator steps through the elements of a BTreeSet in ascending
+    // order.  It keeps track of a position in each node whose elements it
+    // has yet to finish (at most one per level of the tree), so it needs
+    // no links from children to their parents.  Adding an element to the
+    // set invalidates every iterator into it.
+    class ConstIterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ElementType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ElementType*;
+        using reference = const ElementType&;
+
+    public:
+        // Initializes a ConstIterator that is past the end of every set.
+        ConstIterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        ConstIterator& operator++();
+        ConstIterator operator++(int);
+
+        bool operator==(const ConstIterator& other) const noexcept;
+        bool operator!=(const ConstIterator& other) const noexcept;
+
+    private:
+        friend class BTreeSet;
+
+        // A node and the index of the next of its elements to be visited.
+        struct Position
+        {
+            const Node* node;
+            unsigned int index;
+        };
+
+        // The nodes with elements yet to be visited, with the current
+        // element's node last.
+        std::vector<Position> pending;
+
+        // pushLeftmost() pushes n and every node along the path from it
+        // to the leftmost leaf in its subtree
+        void pushLeftmost(const Node* n);
+    };
+
+    using const_iterator = ConstIterator;
+
+public:
+    // Initializes a BTreeSet to be empty.  No node is allocated until the
+    // first element is added.
+    BTreeSet();
+
+    // Cleans up the BTreeSet so that it leaks no memory.
+    ~BTreeSet() noexcept override;
+
+    // Initializes a new BTreeSet to be a copy of an existing one, with the
+    // same shape.
+    BTreeSet(const BTreeSet& s);
+
+    // Initializes a new BTreeSet whose contents are moved from an expiring
+    // one, leaving it empty.
+    BTreeSet(BTreeSet&& s) noexcept;
+
+    // Assigns an existing BTreeSet into another.
+    BTreeSet& operator=(const BTreeSet& s);
+
+    // Assigns an expiring BTreeSet into another.
+    BTreeSet& operator=(BTreeSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  It runs in O(log n) time, making
+    // one pass down the tree and splitting any full node it passes through
+    // on the way, so that there's always room for whatever moves up into it.
+    void add(const ElementType& element) override;
+
+
+    // contains() returns true if the given element (or a key that compares
+    // with the elements the same way) is in the set, false otherwise.  It
+    // runs in O(log n) time.
+    using Set<ElementType>::contains;
+    bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
+
+
+    // size() returns the number of elements in the set.
+    std::size_t size() const noexcept override;
+
+
+    // height() returns the height of the B-tree, which is the number of
+    // levels below its root (and, by definition, -1 when it's empty).
+    int height() const noexcept;
+
+
+    // lowerBound() returns a pointer to the smallest element that isn't
+    // less than the given key (an element, or anything that compares with
+    // the elements the way one would), or nullptr if there's no such
+    // element.  It runs in O(log n) time.
+    template <typename Key>
+    const ElementType* lowerBound(const Key& key) const;
+
+
+    // forEachInRange() calls the given "visit" function, in ascending
+    // order, for each element that is at least lo and less than hi, up to
+    // the given limit, and returns how many it visited.  It runs in
+    // O(log n + k) time when it visits k elements.
+    template <typename Key, typename Visit>
+    std::size_t forEachInRange(
+        const Key& lo, const Key& hi, Visit&& visit,
+        std::size_t limit = NO_LIMIT) const;
+
+
+    // forEachWithPrefix() calls the given "visit" function, in ascending
+    // order, for each string in the set that begins with the given prefix,
+    // up to the given limit, and returns how many it visited.  It runs in
+    // O(log n + k) time when it visits k of them.
+    template <
+        typename Visit, typename E = ElementType,
+        typename = std::enable_if_t<std::is_same_v<E, std::string>>>
+    std::size_t forEachWithPrefix(
+        std::string_view prefix, Visit&& visit,
+        std::size_t limit = NO_LIMIT) const;
+
+
+    // inorder() calls the given "visit" function for each of the elements
+    // in the set, in ascending order.
+    template <typename Visit>
+    void inorder(Visit&& visit) const;
+
+
+    // begin() and end() return iterators to the first element (in
+    // ascending order) and past the last one.
+    ConstIterator begin() const;
+    ConstIterator end() const;
+
+
+    // nodeCount() returns the number of nodes in the tree, and byteCount()
+    // returns their total size in bytes (not counting anything the
+    // elements themselves allocate, such as a long string's characters).
+    std::size_t nodeCount() const noexcept;
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    using Prefix = impl_::KeyPrefix<ElementType>;
+
+    // Every node begins with the number of elements it holds and whether
+    // it's a leaf, followed by the elements' prefixes (if they have them)
+    // and then the elements, so a search reads the start of a node first.
+    struct alignas(CACHE_LINE_BYTES) Node
+    {
+        std::uint16_t count;
+        bool leaf;
+        std::uint64_t prefixes[Prefix::enabled ? MAX_KEYS : 1];
+        ElementType values[MAX_KEYS];
+    };
+
+    // Nodes that aren't leaves have a child before, between, and after
+    // their elements; leaves, which are most of the nodes, leave them out.
+    struct Branch : Node
+    {
+        Node* children[MAX_KEYS + 1];
+    };
+
+private:
+    Node* root;
+    std::size_t sz;
+    std::size_t leafCount;
+    std::size_t branchCount;
+
+private:
+    // makeLeaf() and makeBranch() create an empty node of either kind
+    static Node* makeLeaf();
+    static Branch* makeBranch();
+
+    // childOf() returns the child of a branch at the given index
+    static Node* childOf(const Node* n, unsigned int index) noexcept;
+
+    // prefixOf() returns the prefix of an element (or key), or zero if the
+    // elements have no prefixes
+    template <typename Key>
+    static std::uint64_t prefixOf(const Key& key) noexcept;
+
+    // compare() compares an element (or key) with an element the same way
+    // AVLSet does, returning a negative number, zero, or a positive one
+    template <typename Key>
+    static int compare(const Key& key, const ElementType& value);
+
+    // find() returns the index of the first element in a node that isn't
+    // less than the given key (whose prefix is given, too), or the node's
+    // count if there's none, and sets found to whether it's equal.  For
+    // as long as the prefixes are less than the key's, it needn't look at
+    // the elements at all.
+    template <typename Key>
+    static unsigned int find(
+        const Node* n, const Key& key, std::uint64_t keyPrefix, bool& found);
+
+    // containsKey() searches for an element, or a key that compares with
+    // the elements the same way that element would
+    template <typename Key>
+    bool containsKey(const Key& key) const;
+
+    // shiftRight() moves the elements (and prefixes) of a node, from the
+    // given index onward, one place to the right, making room at the index
+    static void shiftRight(Node* n, unsigned int index) noexcept;
+
+    // insertAt() adds an element, whose prefix is given, to a node that
+    // isn't full, at the given index
+    static void insertAt(
+        Node* n, unsigned int index, const ElementType& element, std::uint64_t prefix);
+
+    // splitChild() splits the full child of a branch at the given index
+    // into two, moving its middle element up into the branch (which must
+    // not be full) at that index
+    void splitChild(Branch* parent, unsigned int index);
+
+    // seek() returns an iterator to the smallest element that isn't less
+    // than lo
+    template <typename Key>
+    ConstIterator seek(const Key& lo) const;
+
+    // visitFrom() visits the elements in ascending order, beginning with
+    // the smallest one that isn't less than lo, until limit of them have
+    // been visited or inRange() returns false for one, and returns how
+    // many it visited
+    template <typename Key, typename InRange, typename Visit>
+    std::size_t visitFrom(const Key& lo, InRange inRange, Visit& visit, std::size_t limit) const;
+
+    // copyNodes() returns a copy of the subtree the source points to.  A
+    // B-tree is so shallow that recursing once per level is no concern.
+    static Node* copyNodes(const Node* source);
+
+    // destroyNodes() deletes every node in the subtree n points to
+    static void destroyNodes(Node* n) noexcept;
+};
+
+
+
+template <typename ElementType>
+BTreeSet<ElementType>::BTreeSet()
+    : root{nullptr}, sz{0}, leafCount{0}, branchCount{0}
+{
+}
+
+
+template <typename ElementType>
+BTreeSet<ElementType>::~BTreeSet() noexcept
+{
+    destroyNodes(root);
+}
+
+
+template <typename ElementType>
+BTreeSet<ElementType>::BTreeSet(const BTreeSet& s)
+    : root{copyNodes(s.root)}, sz{s.sz}, leafCount{s.leafCount}, branchCount{s.branchCount}
+{
+}
+
+
+template <typename ElementType>
+BTreeSet<ElementType>::BTreeSet(BTreeSet&& s) noexcept
+    : root{nullptr}, sz{0}, leafCount{0}, branchCount{0}
+{
+    std::swap(root, s.root);
+    std::swap(sz, s.sz);
+    std::swap(leafCount, s.leafCount);
+    std::swap(branchCount, s.branchCount);
+}
+
+
+template <typename ElementType>
+BTreeSet<ElementType>& BTreeSet<ElementType>::operator=(const BTreeSet& s)
+{
+    if (this != &s)
+    {
+        BTreeSet copy{s};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+template <typename ElementType>
+BTreeSet<ElementType>& BTreeSet<ElementType>::operator=(BTreeSet&& s) noexcept
+{
+    std::swap(root, s.root);
+    std::swap(sz, s.sz);
+    std::swap(leafCount, s.leafCount);
+    std::swap(branchCount, s.branchCount);
+    return *this;
+}
+
+
+template <typename ElementType>
+bool BTreeSet<ElementType>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType>
+void BTreeSet<ElementType>::add(const ElementType& element)
+{
+    std::uint64_t elementPrefix = prefixOf(element);
+
+    if (root == nullptr)
+    {
+        Node* leaf = makeLeaf();
+
+        try
+        {
+            insertAt(leaf, 0, element, elementPrefix);
+        }
+        catch (...)
+        {
+            delete leaf;
+            throw;
+        }
+
+        root = leaf;
+        leafCount++;
+        sz++;
+        return;
+    }
+
+    // a full root is split under a new one, which is the only way the
+    // tree grows taller
+    if (root->count == MAX_KEYS)
+    {
+        Branch* newRoot = makeBranch();
+        newRoot->children[0] = root;
+
+        try
+        {
+            splitChild(newRoot, 0);
+        }
+        catch (...)
+        {
+            delete newRoot;
+            throw;
+        }
+
+        root = newRoot;
+        branchCount++;
+    }
+
+    for (Node* current = root; ; )
+    {
+        bool found;
+        unsigned int index = find(current, element, elementPrefix, found);
+        if (found) return;
+
+        if (current->leaf)
+        {
+            insertAt(current, index, element, elementPrefix);
+            sz++;
+            return;
+        }
+
+        Branch* branch = static_cast<Branch*>(current);
+
+        if (branch->children[index]->count == MAX_KEYS)
+        {
+            splitChild(branch, index);
+
+            // the child's middle element is now at the index, between the
+            // child and its new sibling
+            int order = compare(element, branch->values[index]);
+            if (order == 0) return;
+            if (order > 0) index++;
+        }
+
+        current = branch->children[index];
+    }
+}
+
+
+template <typename ElementType>
+bool BTreeSet<ElementType>::contains(const ElementType& element) const
+{
+    return containsKey(element);
+}
+
+
+template <typename ElementType>
+bool BTreeSet<ElementType>::contains(SetKeyType<ElementType> key) const
+{
+    return containsKey(impl_::SetKey<ElementType>::get(key));
+}
+
+
+template <typename ElementType>
+std::size_t BTreeSet<ElementType>::size() const noexcept
+{
+    return sz;
+}
+
+
+template <typename ElementType>
+int BTreeSet<ElementType>::height() const noexcept
+{
+    int levels = -1;
+
+    for (const Node* current = root; current != nullptr; )
+    {
+        levels++;
+        current = current->leaf ? nullptr : childOf(current, 0);
+    }
+
+    return levels;
+}
+
+
+template <typename ElementType>
+template <typename Key>
+const ElementType* BTreeSet<ElementType>::lowerBound(const Key& key) const
+{
+    ConstIterator i = seek(key);
+    return (i == end()) ? nullptr : &*i;
+}
+
+
+template <typename ElementType>
+template <typename Key, typename Visit>
+std::size_t BTreeSet<ElementType>::forEachInRange(
+    const Key& lo, const Key& hi, Visit&& visit, std::size_t limit) const
+{
+    return visitFrom(
+        lo, [&](const ElementType& value) { return compare(hi, value) > 0; },
+        visit, limit);
+}
+
+
+template <typename ElementType>
+template <typename Visit, typename E, typename>
+std::size_t BTreeSet<ElementType>::forEachWithPrefix(
+    std::string_view prefix, Visit&& visit, std::size_t limit) const
+{
+    return visitFrom(
+        prefix,
+        [&](const ElementType& value) { return value.compare(0, prefix.length(), prefix) == 0; },
+        visit, limit);
+}
+
+
+template <typename ElementType>
+template <typename Visit>
+void BTreeSet<ElementType>::inorder(Visit&& visit) const
+{
+    for (const ElementType& value : *this)
+    {
+        visit(value);
+    }
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::ConstIterator BTreeSet<ElementType>::begin() const
+{
+    ConstIterator i;
+    i.pushLeftmost(root);
+    return i;
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::ConstIterator BTreeSet<ElementType>::end() const
+{
+    return ConstIterator{};
+}
+
+
+template <typename ElementType>
+std::size_t BTreeSet<ElementType>::nodeCount() const noexcept
+{
+    return leafCount + branchCount;
+}
+
+
+template <typename ElementType>
+std::size_t BTreeSet<ElementType>::byteCount() const noexcept
+{
+    return leafCount * sizeof(Node) + branchCount * sizeof(Branch);
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::Node* BTreeSet<ElementType>::makeLeaf()
+{
+    Node* n = new Node{};
+    n->leaf = true;
+    return n;
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::Branch* BTreeSet<ElementType>::makeBranch()
+{
+    Branch* n = new Branch{};
+    n->leaf = false;
+    return n;
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::Node* BTreeSet<ElementType>::childOf(
+    const Node* n, unsigned int index) noexcept
+{
+    return static_cast<const Branch*>(n)->children[index];
+}
+
+
+template <typename ElementType>
+template <typename Key>
+std::uint64_t BTreeSet<ElementType>::prefixOf(const Key& key) noexcept
+{
+    if constexpr (Prefix::enabled)
+    {
+        return Prefix::of(std::string_view{key});
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+
+template <typename ElementType>
+template <typename Key>
+int BTreeSet<ElementType>::compare(const Key& key, const ElementType& value)
+{
+    if constexpr (impl_::AVLSet__hasCompare<Key, ElementType>::value)
+    {
+        return key.compare(value);
+    }
+    else if (key < value)
+    {
+        return -1;
+    }
+    else
+    {
+        return (value < key) ? 1 : 0;
+    }
+}
+
+
+template <typename ElementType>
+template <typename Key>
+unsigned int BTreeSet<ElementType>::find(
+    const Node* n, const Key& key, std::uint64_t keyPrefix, bool& found)
+{
+    for (unsigned int i = 0; i < n->count; i++)
+    {
+        if constexpr (Prefix::enabled)
+        {
+            if (n->prefixes[i] < keyPrefix)
+            {
+                continue;
+            }
+            else if (n->prefixes[i] > keyPrefix)
+            {
+                found = false;
+                return i;
+            }
+        }
+
+        int order = compare(key, n->values[i]);
+        if (order <= 0)
+        {
+            found = (order == 0);
+            return i;
+        }
+    }
+
+    found = false;
+    return n->count;
+}
+
+
+template <typename ElementType>
+template <typename Key>
+bool BTreeSet<ElementType>::containsKey(const Key& key) const
+{
+    std::uint64_t keyPrefix = prefixOf(key);
+
+    for (const Node* current = root; current != nullptr; )
+    {
+        bool found;
+        unsigned int index = find(current, key, keyPrefix, found);
+        if (found) return true;
+
+        current = current->leaf ? nullptr : childOf(current, index);
+    }
+
+    return false;
+}
+
+
+template <typename ElementType>
+void BTreeSet<ElementType>::shiftRight(Node* n, unsigned int index) noexcept
+{
+    std::move_backward(n->values + index, n->values + n->count, n->values + n->count + 1);
+
+    if constexpr (Prefix::enabled)
+    {
+        std::copy_backward(
+            n->prefixes + index, n->prefixes + n->count, n->prefixes + n->count + 1);
+    }
+}
+
+
+template <typename ElementType>
+void BTreeSet<ElementType>::insertAt(
+    Node* n, unsigned int index, const ElementType& element, std::uint64_t prefix)
+{
+    // copying the element is the only thing that can fail, so it's done
+    // before anything is moved
+    ElementType value{element};
+
+    shiftRight(n, index);
+    n->values[index] = std::move(value);
+
+    if constexpr (Prefix::enabled)
+    {
+        n->prefixes[index] = prefix;
+    }
+
+    n->count++;
+}
+
+
+template <typename ElementType>
+void BTreeSet<ElementType>::splitChild(Branch* parent, unsigned int index)
+{
+    constexpr unsigned int HALF = MAX_KEYS / 2;
+
+    Node* child = parent->children[index];
+
+    // the sibling is created before anything is moved, so that nothing
+    // has changed if it can't be
+    Node* sibling = child->leaf ? makeLeaf() : makeBranch();
+
+    // the child keeps the elements before the middle one, and the sibling
+    // takes the ones after it
+    std::move(child->values + HALF + 1, child->values + MAX_KEYS, sibling->values);
+
+    if constexpr (Prefix::enabled)
+    {
+        std::copy(child->prefixes + HALF + 1, child->prefixes + MAX_KEYS, sibling->prefixes);
+    }
+
+    if (!child->leaf)
+    {
+        Branch* from = static_cast<Branch*>(child);
+        Branch* to = static_cast<Branch*>(sibling);
+        std::copy(from->children + HALF + 1, from->children + MAX_KEYS + 1, to->children);
+    }
+
+    sibling->count = MAX_KEYS - HALF - 1;
+    child->count = HALF;
+
+    shiftRight(parent, index);
+    std::copy_backward(
+        parent->children + index + 1, parent->children + parent->count + 1,
+        parent->children + parent->count + 2);
+
+    parent->values[index] = std::move(child->values[HALF]);
+
+    if constexpr (Prefix::enabled)
+    {
+        parent->prefixes[index] = child->prefixes[HALF];
+    }
+
+    parent->children[index + 1] = sibling;
+    parent->count++;
+
+    if (sibling->leaf)
+    {
+        leafCount++;
+    }
+    else
+    {
+        branchCount++;
+    }
+}
+
+
+template <typename ElementType>
+template <typename Key>
+typename BTreeSet<ElementType>::ConstIterator BTreeSet<ElementType>::seek(const Key& lo) const
+{
+    // the positions where the search for lo stops in each node, but only
+    // those with elements left to visit, are just what an iterator would
+    // have pending if it had stepped there from the beginning
+    ConstIterator i;
+    std::uint64_t loPrefix = prefixOf(lo);
+
+    for (const Node* current = root; current != nullptr; )
+    {
+        bool found;
+        unsigned int index = find(current, lo, loPrefix, found);
+
+        if (index < current->count)
+        {
+            i.pending.push_back({current, index});
+        }
+
+        current = (found || current->leaf) ? nullptr : childOf(current, index);
+    }
+
+    return i;
+}
+
+
+template <typename ElementType>
+template <typename Key, typename InRange, typename Visit>
+std::size_t BTreeSet<ElementType>::visitFrom(
+    const Key& lo, InRange inRange, Visit& visit, std::size_t limit) const
+{
+    std::size_t visited = 0;
+
+    for (ConstIterator i = seek(lo), last = end(); i != last && visited < limit; ++i)
+    {
+        if (!inRange(*i)) break;
+
+        visit(*i);
+        visited++;
+    }
+
+    return visited;
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::Node* BTreeSet<ElementType>::copyNodes(const Node* source)
+{
+    if (source == nullptr)
+    {
+        return nullptr;
+    }
+    else if (source->leaf)
+    {
+        return new Node{*source};
+    }
+
+    const Branch* from = static_cast<const Branch*>(source);
+    Branch* to = new Branch{*from};
+    std::fill(to->children, to->children + MAX_KEYS + 1, nullptr);
+
+    try
+    {
+        for (unsigned int i = 0; i <= to->count; i++)
+        {
+            to->children[i] = copyNodes(from->children[i]);
+        }
+    }
+    catch (...)
+    {
+        destroyNodes(to);
+        throw;
+    }
+
+    return to;
+}
+
+
+template <typename ElementType>
+void BTreeSet<ElementType>::destroyNodes(Node* n) noexcept
+{
+    if (n == nullptr)
+    {
+        return;
+    }
+    else if (n->leaf)
+    {
+        delete n;
+        return;
+    }
+
+    Branch* branch = static_cast<Branch*>(n);
+    for (unsigned int i = 0; i <= branch->count; i++)
+    {
+        destroyNodes(branch->children[i]);
+    }
+
+    delete branch;
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::ConstIterator::reference
+BTreeSet<ElementType>::ConstIterator::operator*() const
+{
+    const Position& current = pending.back();
+    return current.node->values[current.index];
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::ConstIterator::pointer
+BTreeSet<ElementType>::ConstIterator::operator->() const
+{
+    return &**this;
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::ConstIterator& BTreeSet<ElementType>::ConstIterator::operator++()
+{
+    // the next element is the leftmost one in the subtree after the
+    // current element or, if there's none, the next one in its node or,
+    // if that's finished, the nearest position still pending
+    Position& current = pending.back();
+    const Node* after = current.node->leaf ? nullptr : childOf(current.node, current.index + 1);
+
+    if (++current.index == current.node->count)
+    {
+        pending.pop_back();
+    }
+
+    pushLeftmost(after);
+    return *this;
+}
+
+
+template <typename ElementType>
+typename BTreeSet<ElementType>::ConstIterator BTreeSet<ElementType>::ConstIterator::operator++(int)
+{
+    ConstIterator old = *this;
+    ++*this;
+    return old;
+}
+
+
+template <typename ElementType>
+bool BTreeSet<ElementType>::ConstIterator::operator==(const ConstIterator& other) const noexcept
+{
+    if (pending.empty() || other.pending.empty())
+    {
+        return pending.empty() && other.pending.empty();
+    }
+    else
+    {
+        return pending.back().node == other.pending.back().node
+            && pending.back().index == other.pending.back().index;
+    }
+}
+
+
+template <typename ElementType>
+bool BTreeSet<ElementType>::ConstIterator::operator!=(const ConstIterator& other) const noexcept
+{
+    return !(*this == other);
+}
+
+
+template <typename ElementType>
+void BTreeSet<ElementType>::ConstIterator::pushLeftmost(const Node* n)
+{
+    while (n != nullptr)
+    {
+        pending.push_back({n, 0});
+        n = n->leaf ? nullptr : childOf(n, 0);
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,642 @@
+// CompactAVLSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A CompactAVLSet is an implementation of a Set that is an AVL tree, like
+// an AVLSet, but whose nodes are stored differently.  Rather than being
+// allocated individually and linked by pointers, the nodes all live in one
+// contiguous array, in the order their elements were added, and link to
+// one another by their 32-bit indexes in it.  Each node holds only its
+// element and two 32-bit links; the low-order 29 bits of each link are the
+// child's index, and the high-order 3 bits of the two links, together, are
+// the node's height.
+//
+// A node is therefore the size of its element plus 8 bytes, with no
+// allocator overhead.  An AVLSet's node follows its element with an int
+// and two 64-bit pointers, in a block of its own, so a CompactAVLSet's
+// node is about half the size for small elements, and about a third
+// smaller for strings (43.4 bytes per word in the memory experiment,
+// against an AVLSet's 64.0).  Either way, walking down the tree touches
+// fewer, nearer cache lines.
+//
+// In return, a CompactAVLSet is always balanced (a 6-bit height is plenty
+// for any balanced tree that fits, but not for a degenerate one) and can
+// hold at most MAX_SIZE elements.  When the array is full, it doubles in
+// size and every node is moved into the new one; since links are indexes,
+// not addresses, they stay valid without being changed.  (If moving an
+// element might throw, the nodes are copied instead, so that a failure
+// partway leaves the set as it was.)
+
+#ifndef COMPACTAVLSET_HPP
+#define COMPACTAVLSET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "AVLSet.hpp"
+#include "Set.hpp"
+
+
+
+template <typename ElementType>
+class CompactAVLSet : public Set<ElementType>
+{
+public:
+    // A VisitFunction is a function that takes a reference to a const
+    // ElementType and returns no value.
+    using VisitFunction = std::function<void(const ElementType&)>;
+
+    // The most elements a CompactAVLSet can hold, since a link has 29 bits
+    // for an index, and the largest 29-bit index marks a missing child.
+    static constexpr std::size_t MAX_SIZE = (std::size_t{1} << 29) - 1;
+
+    // The number of nodes the array has room for when the first element
+    // is added (unless reserve() has been called).
+    static constexpr std::size_t DEFAULT_CAPACITY = 16;
+
+public:
+    // Initializes a CompactAVLSet to be empty.  No array is allocated until
+    // the first element is added.
+    CompactAVLSet();
+
+    // Cleans up the CompactAVLSet so that it leaks no memory.
+    ~CompactAVLSet() noexcept override;
+
+    // Initializes a new CompactAVLSet to be a copy of an existing one,
+    // with its nodes at the same indexes.
+    CompactAVLSet(const CompactAVLSet& s);
+
+    // Initializes a new CompactAVLSet whose contents are moved from an
+    // expiring one, leaving it empty.
+    CompactAVLSet(CompactAVLSet&& s) noexcept;
+
+    // Assigns an existing CompactAVLSet into another.
+    CompactAVLSet& operator=(const CompactAVLSet& s);
+
+    // Assigns an expiring CompactAVLSet into another.
+    CompactAVLSet& operator=(CompactAVLSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  It runs in O(log n) time, plus the
+    // time to double the array when it's full.  Adding an element to a set
+    // that already has MAX_SIZE of them throws a std::length_error.
+    void add(const ElementType& element) override;
+
+
+    // reserve() makes room in the array for at least n nodes (but no more
+    // than MAX_SIZE), so that adding that many never moves any of them.
+    void reserve(std::size_t n) override;
+
+
+    // contains() returns true if the given element (or a key that compares
+    // with the elements the same way) is in the set, false otherwise.  It
+    // runs in O(log n) time.
+    using Set<ElementType>::contains;
+    bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
+
+
+    // size() returns the number of elements in the set.
+    std::size_t size() const noexcept override;
+
+
+    // height() returns the height of the AVL tree, which is -1 when the
+    // tree is empty.
+    int height() const noexcept;
+
+
+    // inorder() calls the given "visit" function for each of the elements
+    // in the set, in ascending order.
+    void inorder(VisitFunction visit) const;
+
+
+    // capacity() returns the number of nodes the array has room for, and
+    // byteCount() returns the size of the array in bytes.
+    std::size_t capacity() const noexcept;
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    struct Node
+    {
+        ElementType value;
+        std::uint32_t left;
+        std::uint32_t right;
+    };
+
+private:
+    static constexpr unsigned int INDEX_BITS = 29;
+    static constexpr std::uint32_t INDEX_MASK = (std::uint32_t{1} << INDEX_BITS) - 1;
+
+    // The index that marks a missing child (or an empty tree's root).
+    static constexpr std::uint32_t NONE = INDEX_MASK;
+
+    // No balanced tree with MAX_SIZE nodes is more than 43 levels deep, so
+    // a path down the tree always fits in this many indexes.
+    static constexpr unsigned int PATH_CAPACITY = 64;
+
+private:
+    std::size_t sz;
+    std::size_t cap;
+    Node* nodes;
+    std::uint32_t root;
+
+private:
+    // leftOf() and rightOf() return the index of a node's child, and
+    // setLeft() and setRight() change it, leaving the height bits alone
+    std::uint32_t leftOf(std::uint32_t n) const noexcept;
+    std::uint32_t rightOf(std::uint32_t n) const noexcept;
+    void setLeft(std::uint32_t n, std::uint32_t child) noexcept;
+    void setRight(std::uint32_t n, std::uint32_t child) noexcept;
+
+    // heightOf() returns a node's height (or -1 for NONE), and setHeight()
+    // changes it, leaving the indexes alone
+    int heightOf(std::uint32_t n) const noexcept;
+    void setHeight(std::uint32_t n, int height) noexcept;
+
+    // updateHeight() recalculates a node's height from its children's
+    void updateHeight(std::uint32_t n) noexcept;
+
+    // rebalance() rotates the subtree rooted at n, if its children's heights
+    // differ by more than one, and returns the index of its root
+    std::uint32_t rebalance(std::uint32_t n) noexcept;
+
+    // LL(), RR(), LR(), and RL() implement the four rotations on the
+    // subtree rooted at n, returning the index of its new root
+    std::uint32_t LL(std::uint32_t n) noexcept;
+    std::uint32_t RR(std::uint32_t n) noexcept;
+    std::uint32_t LR(std::uint32_t n) noexcept;
+    std::uint32_t RL(std::uint32_t n) noexcept;
+
+    // containsKey() searches for an element, or a key that compares with
+    // the elements the same way that element would
+    template <typename Key>
+    bool containsKey(const Key& key) const;
+
+    // compare() compares an element (or key) with a node's value the same
+    // way AVLSet does, returning a negative number, zero, or a positive one
+    template <typename Key>
+    static int compare(const Key& key, const ElementType& value);
+
+    // inorderT() recursively traverses the subtree rooted at n in order
+    void inorderT(std::uint32_t n, const VisitFunction& visit) const;
+
+    // resize() moves every node into a new array with room for newCap,
+    // copying them instead if moving one could throw
+    void resize(std::size_t newCap);
+
+    // destroyNodes() destroys every node and releases the array
+    void destroyNodes() noexcept;
+};
+
+
+
+template <typename ElementType>
+CompactAVLSet<ElementType>::CompactAVLSet()
+    : sz{0}, cap{0}, nodes{nullptr}, root{NONE}
+{
+}
+
+
+template <typename ElementType>
+CompactAVLSet<ElementType>::~CompactAVLSet() noexcept
+{
+    destroyNodes();
+}
+
+
+template <typename ElementType>
+CompactAVLSet<ElementType>::CompactAVLSet(const CompactAVLSet& s)
+    : sz{0}, cap{0}, nodes{nullptr}, root{NONE}
+{
+    if (s.sz > 0)
+    {
+        nodes = static_cast<Node*>(::operator new(sizeof(Node) * s.sz));
+        cap = s.sz;
+
+        try
+        {
+            for (; sz < s.sz; sz++)
+            {
+                new (nodes + sz) Node{s.nodes[sz]};
+            }
+        }
+        catch (...)
+        {
+            destroyNodes();
+            throw;
+        }
+
+        root = s.root;
+    }
+}
+
+
+template <typename ElementType>
+CompactAVLSet<ElementType>::CompactAVLSet(CompactAVLSet&& s) noexcept
+    : sz{0}, cap{0}, nodes{nullptr}, root{NONE}
+{
+    std::swap(sz, s.sz);
+    std::swap(cap, s.cap);
+    std::swap(nodes, s.nodes);
+    std::swap(root, s.root);
+}
+
+
+template <typename ElementType>
+CompactAVLSet<ElementType>& CompactAVLSet<ElementType>::operator=(const CompactAVLSet& s)
+{
+    if (this != &s)
+    {
+        CompactAVLSet copy{s};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+template <typename ElementType>
+CompactAVLSet<ElementType>& CompactAVLSet<ElementType>::operator=(CompactAVLSet&& s) noexcept
+{
+    std::swap(sz, s.sz);
+    std::swap(cap, s.cap);
+    std::swap(nodes, s.nodes);
+    std::swap(root, s.root);
+    return *this;
+}
+
+
+template <typename ElementType>
+bool CompactAVLSet<ElementType>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::add(const ElementType& element)
+{
+    // the indexes of the nodes on the way down, so the path can be
+    // retraced on the way up
+    std::uint32_t path[PATH_CAPACITY];
+    unsigned int length = 0;
+    int order = 0;
+
+    for (std::uint32_t current = root; current != NONE; )
+    {
+        order = compare(element, nodes[current].value);
+        if (order == 0) return;
+
+        path[length++] = current;
+        current = (order < 0) ? leftOf(current) : rightOf(current);
+    }
+
+    if (sz == MAX_SIZE)
+    {
+        throw std::length_error{"CompactAVLSet cannot hold any more elements"};
+    }
+    else if (sz == cap)
+    {
+        resize(std::min(MAX_SIZE, std::max(DEFAULT_CAPACITY, cap * 2)));
+    }
+
+    // a new node's links are both NONE, whose height bits are all zero
+    std::uint32_t added = static_cast<std::uint32_t>(sz);
+    new (nodes + added) Node{element, NONE, NONE};
+    sz++;
+
+    if (length == 0)
+    {
+        root = added;
+    }
+    else if (order < 0)
+    {
+        setLeft(path[length - 1], added);
+    }
+    else
+    {
+        setRight(path[length - 1], added);
+    }
+
+    // once a subtree's height is the same as it was before (which, after a
+    // rotation, it always is), nothing above it can have changed
+    while (length > 0)
+    {
+        length--;
+        std::uint32_t n = path[length];
+
+        int oldHeight = heightOf(n);
+        updateHeight(n);
+        std::uint32_t subtree = rebalance(n);
+
+        if (length == 0)
+        {
+            root = subtree;
+        }
+        else if (leftOf(path[length - 1]) == n)
+        {
+            setLeft(path[length - 1], subtree);
+        }
+        else
+        {
+            setRight(path[length - 1], subtree);
+        }
+
+        if (heightOf(subtree) == oldHeight) break;
+    }
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::reserve(std::size_t n)
+{
+    n = std::min(n, MAX_SIZE);
+
+    if (n > cap)
+    {
+        resize(n);
+    }
+}
+
+
+template <typename ElementType>
+bool CompactAVLSet<ElementType>::contains(const ElementType& element) const
+{
+    return containsKey(element);
+}
+
+
+template <typename ElementType>
+bool CompactAVLSet<ElementType>::contains(SetKeyType<ElementType> key) const
+{
+    return containsKey(impl_::SetKey<ElementType>::get(key));
+}
+
+
+template <typename ElementType>
+std::size_t CompactAVLSet<ElementType>::size() const noexcept
+{
+    return sz;
+}
+
+
+template <typename ElementType>
+int CompactAVLSet<ElementType>::height() const noexcept
+{
+    return heightOf(root);
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::inorder(VisitFunction visit) const
+{
+    inorderT(root, visit);
+}
+
+
+template <typename ElementType>
+std::size_t CompactAVLSet<ElementType>::capacity() const noexcept
+{
+    return cap;
+}
+
+
+template <typename ElementType>
+std::size_t CompactAVLSet<ElementType>::byteCount() const noexcept
+{
+    return cap * sizeof(Node);
+}
+
+
+template <typename ElementType>
+std::uint32_t CompactAVLSet<ElementType>::leftOf(std::uint32_t n) const noexcept
+{
+    return nodes[n].left & INDEX_MASK;
+}
+
+
+template <typename ElementType>
+std::uint32_t CompactAVLSet<ElementType>::rightOf(std::uint32_t n) const noexcept
+{
+    return nodes[n].right & INDEX_MASK;
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::setLeft(std::uint32_t n, std::uint32_t child) noexcept
+{
+    nodes[n].left = (nodes[n].left & ~INDEX_MASK) | child;
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::setRight(std::uint32_t n, std::uint32_t child) noexcept
+{
+    nodes[n].right = (nodes[n].right & ~INDEX_MASK) | child;
+}
+
+
+template <typename ElementType>
+int CompactAVLSet<ElementType>::heightOf(std::uint32_t n) const noexcept
+{
+    if (n == NONE)
+    {
+        return -1;
+    }
+
+    // the left link holds the low-order 3 bits, the right the high-order 3
+    return static_cast<int>((nodes[n].left >> INDEX_BITS) | ((nodes[n].right >> INDEX_BITS) << 3));
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::setHeight(std::uint32_t n, int height) noexcept
+{
+    std::uint32_t bits = static_cast<std::uint32_t>(height);
+    nodes[n].left = (nodes[n].left & INDEX_MASK) | ((bits & 7) << INDEX_BITS);
+    nodes[n].right = (nodes[n].right & INDEX_MASK) | (((bits >> 3) & 7) << INDEX_BITS);
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::updateHeight(std::uint32_t n) noexcept
+{
+    setHeight(n, std::max(heightOf(leftOf(n)), heightOf(rightOf(n))) + 1);
+}
+
+
+template <typename ElementType>
+std::uint32_t CompactAVLSet<ElementType>::rebalance(std::uint32_t n) noexcept
+{
+    int balance = heightOf(leftOf(n)) - heightOf(rightOf(n));
+
+    if (balance > 1)
+    {
+        std::uint32_t l = leftOf(n);
+        return (heightOf(leftOf(l)) > heightOf(rightOf(l))) ? LL(n) : LR(n);
+    }
+    else if (balance < -1)
+    {
+        std::uint32_t r = rightOf(n);
+        return (heightOf(rightOf(r)) > heightOf(leftOf(r))) ? RR(n) : RL(n);
+    }
+    else
+    {
+        return n;
+    }
+}
+
+
+template <typename ElementType>
+std::uint32_t CompactAVLSet<ElementType>::LL(std::uint32_t n) noexcept
+{
+    std::uint32_t l = leftOf(n);
+    setLeft(n, rightOf(l));
+    setRight(l, n);
+    updateHeight(n);
+    updateHeight(l);
+    return l;
+}
+
+
+template <typename ElementType>
+std::uint32_t CompactAVLSet<ElementType>::RR(std::uint32_t n) noexcept
+{
+    std::uint32_t r = rightOf(n);
+    setRight(n, leftOf(r));
+    setLeft(r, n);
+    updateHeight(n);
+    updateHeight(r);
+    return r;
+}
+
+
+template <typename ElementType>
+std::uint32_t CompactAVLSet<ElementType>::LR(std::uint32_t n) noexcept
+{
+    setLeft(n, RR(leftOf(n)));
+    return LL(n);
+}
+
+
+template <typename ElementType>
+std::uint32_t CompactAVLSet<ElementType>::RL(std::uint32_t n) noexcept
+{
+    setRight(n, LL(rightOf(n)));
+    return RR(n);
+}
+
+
+template <typename ElementType>
+template <typename Key>
+bool CompactAVLSet<ElementType>::containsKey(const Key& key) const
+{
+    std::uint32_t current = root;
+    while (current != NONE)
+    {
+        int order = compare(key, nodes[current].value);
+        if (order == 0) return true;
+
+        current = (order < 0) ? leftOf(current) : rightOf(current);
+    }
+    return false;
+}
+
+
+template <typename ElementType>
+template <typename Key>
+int CompactAVLSet<ElementType>::compare(const Key& key, const ElementType& value)
+{
+    if constexpr (impl_::AVLSet__hasCompare<Key, ElementType>::value)
+    {
+        return key.compare(value);
+    }
+    else if (key < value)
+    {
+        return -1;
+    }
+    else
+    {
+        return (value < key) ? 1 : 0;
+    }
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::inorderT(std::uint32_t n, const VisitFunction& visit) const
+{
+    if (n != NONE)
+    {
+        inorderT(leftOf(n), visit);
+        visit(nodes[n].value);
+        inorderT(rightOf(n), visit);
+    }
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::resize(std::size_t newCap)
+{
+    Node* newNodes = static_cast<Node*>(::operator new(sizeof(Node) * newCap));
+
+    // the links are indexes, so each node moves to the same index; the old
+    // nodes are left alone until every new one has been built, so a copy
+    // that throws partway doesn't damage them
+    std::size_t built = 0;
+
+    try
+    {
+        for (; built < sz; built++)
+        {
+            new (newNodes + built) Node{std::move_if_noexcept(nodes[built])};
+        }
+    }
+    catch (...)
+    {
+        for (std::size_t i = 0; i < built; i++)
+        {
+            newNodes[i].~Node();
+        }
+
+        ::operator delete(newNodes);
+        throw;
+    }
+
+    for (std::size_t i = 0; i < sz; i++)
+    {
+        nodes[i].~Node();
+    }
+
+    ::operator delete(nodes);
+    nodes = newNodes;
+    cap = newCap;
+}
+
+
+template <typename ElementType>
+void CompactAVLSet<ElementType>::destroyNodes() noexcept
+{
+    for (std::size_t i = 0; i < sz; i++)
+    {
+        nodes[i].~Node();
+    }
+
+    ::operator delete(nodes);
+    nodes = nullptr;
+    sz = 0;
+    cap = 0;
+    root = NONE;
+}
+
+
+
+#endif
@@ -0,0 +1,542 @@
+// ConcurrentHashSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A ConcurrentHashSet is an implementation of a Set that is a separately-
+// chained hash table, like HashSet, but that can safely be used by many
+// threads at once: any number of threads can call contains() while other
+// threads call add().
+//
+// Lookups take no locks at all.  Each bucket's chain is a singly-linked
+// list of "links" that are never modified once they're published; a new
+// element's link is pushed onto the front of its bucket with an atomic
+// compare-and-swap, so a reader walking a chain always sees a consistent
+// list, either with or without the new link.
+//
+// Writers are serialized per "stripe" (a fixed set of mutexes, chosen by
+// hash value), which both prevents two threads from adding the same element
+// at once and lets writers to different stripes proceed in parallel.  The
+// stripes don't line up with the buckets, though, so two writers holding
+// different stripes can push onto the same bucket at once; the
+// compare-and-swap is what keeps either of their links from being lost.
+//
+// When the ratio of size to capacity exceeds 0.8, the writer that noticed
+// it locks every stripe and builds a new, larger table of links pointing
+// to the same elements, then publishes it atomically.  Readers carry on
+// using the old table in the meantime, so they are never blocked by
+// resizing.  Since a reader might still be walking an old table at any
+// time, old tables are retired rather than freed, and released only when
+// the ConcurrentHashSet is destroyed; their links total less than one per
+// element.
+//
+// Copying, moving, and assigning ConcurrentHashSets (and destroying them)
+// are not safe while other threads are using them.
+
+#ifndef CONCURRENTHASHSET_HPP
+#define CONCURRENTHASHSET_HPP
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include "Set.hpp"
+
+
+
+template <
+    typename ElementType,
+    typename Hash = std::function<unsigned int(const ElementType&)>>
+class ConcurrentHashSet : public Set<ElementType>
+{
+public:
+    // The default capacity of the ConcurrentHashSet before anything has
+    // been added to it.
+    static constexpr unsigned int DEFAULT_CAPACITY = 10;
+
+    // The number of mutexes that writers are spread across.
+    static constexpr unsigned int STRIPE_COUNT = 64;
+
+    // A HashFunction is a function that takes a reference to a const
+    // ElementType and returns an unsigned int.  It will be called by many
+    // threads at once, so it must be safe to do so.  By default, it is a
+    // std::function; a functor type can be given instead, so calls to it
+    // are inlined, and so (if it can hash a key directly) searching for a
+    // key never has to make an element out of it.
+    using HashFunction = Hash;
+
+public:
+    // Initializes a ConcurrentHashSet to be empty, so that it will use the
+    // given hash function whenever it needs to hash an element.
+    explicit ConcurrentHashSet(HashFunction hashFunction);
+
+    // Cleans up the ConcurrentHashSet so that it leaks no memory.
+    ~ConcurrentHashSet() noexcept override;
+
+    // Initializes a new ConcurrentHashSet to be a copy of an existing one.
+    ConcurrentHashSet(const ConcurrentHashSet& s);
+
+    // Initializes a new ConcurrentHashSet whose table and stripes are moved
+    // from an expiring one, leaving it empty with neither; it can only be
+    // destroyed, assigned to, or searched (finding nothing).
+    ConcurrentHashSet(ConcurrentHashSet&& s) noexcept;
+
+    // Assigns an existing ConcurrentHashSet into another.
+    ConcurrentHashSet& operator=(const ConcurrentHashSet& s);
+
+    // Assigns an expiring ConcurrentHashSet into another.
+    ConcurrentHashSet& operator=(ConcurrentHashSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  It can safely be called by many
+    // threads at once, and alongside contains().  It locks one stripe,
+    // unless the table needs to be resized, in which case it locks every
+    // stripe and runs in linear time.
+    void add(const ElementType& element) override;
+
+
+    // reserve() resizes the table, if needed, so that n elements can be
+    // added without it having to be resized again.
+    void reserve(std::size_t n) override;
+
+
+    // contains() returns true if the given element (or a key that compares
+    // equal to one) is already in the set, false otherwise.  It never waits
+    // for a lock, and it can safely be called by many threads at once, and
+    // alongside add().
+    using Set<ElementType>::contains;
+    bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
+
+
+    // size() returns the number of elements in the set.
+    std::size_t size() const noexcept override;
+
+
+    // capacity() returns the number of buckets in the current table.
+    unsigned int capacity() const noexcept;
+
+
+private:
+    // A Link is one entry in a bucket's chain.  Its fields never change
+    // once it's been published, so it can be read without locking.  Every
+    // table has its own links, but they all point to the same elements.
+    struct Link
+    {
+        unsigned int hashValue;
+        const ElementType* value;
+        Link* next;
+    };
+
+    struct Table
+    {
+        unsigned int cap;
+        std::atomic<Link*>* buckets;
+
+        // The table this one replaced, retired until destruction.
+        Table* previous;
+    };
+
+private:
+    HashFunction hashFunction;
+    std::atomic<unsigned int> sz;
+    std::atomic<Table*> table;
+    std::mutex* stripes;
+
+private:
+    // makeTable() allocates a table with the given capacity and no links.
+    static Table* makeTable(unsigned int cap, Table* previous);
+
+    // lockAll() and unlockAll() lock and unlock every stripe, in order.
+    void lockAll() const;
+    void unlockAll() const noexcept;
+
+    // An AllStripesLock locks every stripe of a set for as long as it
+    // exists, the way a std::lock_guard locks one mutex.
+    class AllStripesLock
+    {
+    public:
+        explicit AllStripesLock(const ConcurrentHashSet& s)
+            : s{s}
+        {
+            s.lockAll();
+        }
+
+        ~AllStripesLock() noexcept
+        {
+            s.unlockAll();
+        }
+
+        AllStripesLock(const AllStripesLock&) = delete;
+        AllStripesLock& operator=(const AllStripesLock&) = delete;
+
+    private:
+        const ConcurrentHashSet& s;
+    };
+
+    // find() returns true if the element (or a key that compares equal to
+    // one), with the given hash value, is in the given table.
+    template <typename Key>
+    static bool find(const Table* t, const Key& element, unsigned int hashValue);
+
+    // hashKey() hashes a key, calling the hash function on it directly if
+    // it can, or on an element made from it otherwise
+    template <typename Key>
+    unsigned int hashKey(const Key& key) const;
+
+    // resize() builds and publishes a new table with the given capacity.
+    // Every stripe must be locked when this is called.
+    void resize(unsigned int newCap);
+
+    // destroy() releases every element, link, and table.
+    void destroy() noexcept;
+
+    // copyFrom() adds every element of another set (whose stripes are
+    // all locked) to this one.
+    void copyFrom(const ConcurrentHashSet& s);
+};
+
+
+
+template <typename ElementType, typename Hash>
+ConcurrentHashSet<ElementType, Hash>::ConcurrentHashSet(HashFunction hashFunction)
+    : hashFunction{hashFunction}, sz{0},
+      table{makeTable(DEFAULT_CAPACITY, nullptr)},
+      stripes{new std::mutex[STRIPE_COUNT]}
+{
+}
+
+
+template <typename ElementType, typename Hash>
+ConcurrentHashSet<ElementType, Hash>::~ConcurrentHashSet() noexcept
+{
+    destroy();
+    delete[] stripes;
+}
+
+
+template <typename ElementType, typename Hash>
+ConcurrentHashSet<ElementType, Hash>::ConcurrentHashSet(const ConcurrentHashSet& s)
+    : hashFunction{s.hashFunction}, sz{0},
+      table{makeTable(DEFAULT_CAPACITY, nullptr)},
+      stripes{new std::mutex[STRIPE_COUNT]}
+{
+    try
+    {
+        AllStripesLock lock{s};
+        copyFrom(s);
+    }
+    catch (...)
+    {
+        destroy();
+        delete[] stripes;
+        throw;
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+ConcurrentHashSet<ElementType, Hash>::ConcurrentHashSet(ConcurrentHashSet&& s) noexcept
+    : hashFunction{std::move(s.hashFunction)}, sz{s.sz.load()},
+      table{s.table.load()}, stripes{s.stripes}
+{
+    // the expiring set is left with no table and no stripes, rather than
+    // allocating new ones here
+    s.sz.store(0);
+    s.table.store(nullptr);
+    s.stripes = nullptr;
+}
+
+
+template <typename ElementType, typename Hash>
+ConcurrentHashSet<ElementType, Hash>& ConcurrentHashSet<ElementType, Hash>::operator=(const ConcurrentHashSet& s)
+{
+    if (this != &s)
+    {
+        ConcurrentHashSet copy{s};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename Hash>
+ConcurrentHashSet<ElementType, Hash>& ConcurrentHashSet<ElementType, Hash>::operator=(ConcurrentHashSet&& s) noexcept
+{
+    if (this != &s)
+    {
+        std::swap(hashFunction, s.hashFunction);
+
+        unsigned int tempSz = sz.load();
+        sz.store(s.sz.load());
+        s.sz.store(tempSz);
+
+        Table* tempTable = table.load();
+        table.store(s.table.load());
+        s.table.store(tempTable);
+
+        std::swap(stripes, s.stripes);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename Hash>
+bool ConcurrentHashSet<ElementType, Hash>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType, typename Hash>
+typename ConcurrentHashSet<ElementType, Hash>::Table* ConcurrentHashSet<ElementType, Hash>::makeTable(
+    unsigned int cap, Table* previous)
+{
+    std::atomic<Link*>* buckets = new std::atomic<Link*>[cap];
+    for (unsigned int i = 0; i < cap; i++)
+    {
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+    }
+    return new Table{cap, buckets, previous};
+}
+
+
+template <typename ElementType, typename Hash>
+void ConcurrentHashSet<ElementType, Hash>::lockAll() const
+{
+    for (unsigned int i = 0; i < STRIPE_COUNT; i++)
+    {
+        stripes[i].lock();
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+void ConcurrentHashSet<ElementType, Hash>::unlockAll() const noexcept
+{
+    for (unsigned int i = STRIPE_COUNT; i > 0; i--)
+    {
+        stripes[i - 1].unlock();
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+template <typename Key>
+bool ConcurrentHashSet<ElementType, Hash>::find(
+    const Table* t, const Key& element, unsigned int hashValue)
+{
+    const Link* current = t->buckets[hashValue % t->cap].load(std::memory_order_acquire);
+    while (current != nullptr)
+    {
+        if (current->hashValue == hashValue && *current->value == element) return true;
+        current = current->next;
+    }
+    return false;
+}
+
+
+template <typename ElementType, typename Hash>
+void ConcurrentHashSet<ElementType, Hash>::resize(unsigned int newCap)
+{
+    Table* oldTable = table.load(std::memory_order_relaxed);
+    Table* newTable = makeTable(newCap, oldTable);
+
+    // every stripe is locked, so the old table can't change underneath us;
+    // readers can keep using it until the new one is published
+    for (unsigned int i = 0; i < oldTable->cap; i++)
+    {
+        for (const Link* current = oldTable->buckets[i].load(std::memory_order_relaxed);
+             current != nullptr; current = current->next)
+        {
+            std::atomic<Link*>& bucket = newTable->buckets[current->hashValue % newCap];
+            Link* link = new Link{
+                current->hashValue, current->value, bucket.load(std::memory_order_relaxed)};
+            bucket.store(link, std::memory_order_relaxed);
+        }
+    }
+
+    table.store(newTable, std::memory_order_release);
+}
+
+
+template <typename ElementType, typename Hash>
+void ConcurrentHashSet<ElementType, Hash>::add(const ElementType& element)
+{
+    unsigned int hashValue = hashFunction(element);
+    bool needsResize = false;
+
+    {
+        std::lock_guard<std::mutex> lock{stripes[hashValue % STRIPE_COUNT]};
+
+        // while this stripe is locked, the table can't be replaced, and
+        // no other thread can add an element with this hash value
+        Table* t = table.load(std::memory_order_acquire);
+        if (find(t, element, hashValue)) return;
+
+        // writers holding other stripes may be pushing onto the same
+        // bucket, so the push only succeeds if the front of the chain is
+        // still the one our link points to
+        std::atomic<Link*>& bucket = t->buckets[hashValue % t->cap];
+        ElementType* value = new ElementType{element};
+        Link* link;
+
+        try
+        {
+            link = new Link{hashValue, value, bucket.load(std::memory_order_relaxed)};
+        }
+        catch (...)
+        {
+            delete value;
+            throw;
+        }
+
+        while (!bucket.compare_exchange_weak(
+            link->next, link, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+
+        unsigned int newSz = sz.fetch_add(1, std::memory_order_relaxed) + 1;
+        needsResize = static_cast<float>(newSz) / t->cap > 0.8;
+    }
+
+    if (needsResize)
+    {
+        AllStripesLock lock{*this};
+
+        // another writer may have resized while we waited for the locks
+        Table* t = table.load(std::memory_order_relaxed);
+        if (static_cast<float>(sz.load(std::memory_order_relaxed)) / t->cap > 0.8)
+        {
+            resize(t->cap * 2 + 1);
+        }
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+void ConcurrentHashSet<ElementType, Hash>::reserve(std::size_t n)
+{
+    AllStripesLock lock{*this};
+
+    Table* t = table.load(std::memory_order_relaxed);
+    unsigned int newCap = t->cap;
+    while (static_cast<float>(n) / newCap > 0.8)
+    {
+        newCap = newCap * 2 + 1;
+    }
+
+    if (newCap != t->cap)
+    {
+        resize(newCap);
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+bool ConcurrentHashSet<ElementType, Hash>::contains(const ElementType& element) const
+{
+    const Table* t = table.load(std::memory_order_acquire);
+    return t != nullptr && find(t, element, hashFunction(element));
+}
+
+
+template <typename ElementType, typename Hash>
+bool ConcurrentHashSet<ElementType, Hash>::contains(SetKeyType<ElementType> key) const
+{
+    const Table* t = table.load(std::memory_order_acquire);
+    if (t == nullptr) return false;
+
+    const auto& element = impl_::SetKey<ElementType>::get(key);
+    return find(t, element, hashKey(element));
+}
+
+
+template <typename ElementType, typename Hash>
+template <typename Key>
+unsigned int ConcurrentHashSet<ElementType, Hash>::hashKey(const Key& key) const
+{
+    if constexpr (std::is_invocable_r_v<unsigned int, const Hash&, const Key&>)
+    {
+        return hashFunction(key);
+    }
+    else
+    {
+        return hashFunction(ElementType{key});
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+std::size_t ConcurrentHashSet<ElementType, Hash>::size() const noexcept
+{
+    return sz.load(std::memory_order_relaxed);
+}
+
+
+template <typename ElementType, typename Hash>
+unsigned int ConcurrentHashSet<ElementType, Hash>::capacity() const noexcept
+{
+    const Table* t = table.load(std::memory_order_acquire);
+    return t != nullptr ? t->cap : 0;
+}
+
+
+template <typename ElementType, typename Hash>
+void ConcurrentHashSet<ElementType, Hash>::destroy() noexcept
+{
+    Table* t = table.load();
+    bool ownsValues = true;
+
+    while (t != nullptr)
+    {
+        for (unsigned int i = 0; i < t->cap; i++)
+        {
+            Link* current = t->buckets[i].load(std::memory_order_relaxed);
+            while (current != nullptr)
+            {
+                Link* next = current->next;
+
+                // every element is linked from the newest table, so that's
+                // the one that releases them
+                if (ownsValues) delete current->value;
+                delete current;
+                current = next;
+            }
+        }
+
+        Table* previous = t->previous;
+        delete[] t->buckets;
+        delete t;
+        t = previous;
+        ownsValues = false;
+    }
+
+    table.store(nullptr);
+}
+
+
+template <typename ElementType, typename Hash>
+void ConcurrentHashSet<ElementType, Hash>::copyFrom(const ConcurrentHashSet& s)
+{
+    const Table* t = s.table.load();
+
+    reserve(s.sz.load());
+    for (unsigned int i = 0; i < t->cap; i++)
+    {
+        for (const Link* current = t->buckets[i].load(); current != nullptr;
+             current = current->next)
+        {
+            add(*current->value);
+        }
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,548 @@
+// CuckooHashSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A CuckooHashSet is an implementation of a Set that uses bucketized
+// cuckoo hashing, which puts a hard limit on the work done by contains():
+// every element lives in one of exactly two buckets, chosen by its hash
+// value, and each bucket has four slots.  So contains() examines at most
+// eight slots, no matter how poorly the elements' hash values would have
+// been distributed by a chained HashSet.
+//
+// Each slot has a one-byte "tag" taken from its element's hash value (or
+// zero if it's empty), stored apart from the elements themselves, with the
+// four tags of a bucket side by side.  A lookup reads the tags of its two
+// buckets (usually two cache lines, since the buckets are rarely near one
+// another), and compares itself only with the elements whose tags match,
+// which is rarely more than one, and usually none when the element isn't
+// there.  So a miss usually reads two cache lines, but a hit reads at least
+// three, since the matching element is in a separate array from the tags.
+//
+// When add() finds both of an element's buckets full, it "kicks out" an
+// element from one of them to make room, which then moves to its other
+// bucket, possibly kicking out another, and so on.  If that goes on too
+// long, or the table gets more than 90% full, every element is rehashed
+// into a table twice as large.
+//
+// The hash function must be a seeded one, taking an element and a 64-bit
+// seed and returning a 64-bit hash value, since rehashing picks a new
+// seed.  That way, a set of elements that can't be placed under one seed
+// (or that a weak hash function would pile into the same buckets) can't
+// defeat it forever.
+
+#ifndef CUCKOOHASHSET_HPP
+#define CUCKOOHASHSET_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Set.hpp"
+#include "StringHashing.hpp"
+
+
+
+template <typename ElementType, typename SeededHash = HashStringSeeded>
+class CuckooHashSet : public Set<ElementType>
+{
+public:
+    // The number of slots in each bucket.
+    static constexpr unsigned int SLOTS_PER_BUCKET = 4;
+
+    // The number of buckets before anything has been added.  This must be
+    // a power of two, and the bucket count always stays one.
+    static constexpr unsigned int DEFAULT_BUCKET_COUNT = 4;
+
+    // The most elements add() will kick out of their slots, one after
+    // another, before giving up and rehashing.
+    static constexpr unsigned int MAX_KICKS = 500;
+
+public:
+    // Initializes a CuckooHashSet to be empty, using the given seeded hash
+    // function whenever it needs to hash an element.
+    explicit CuckooHashSet(SeededHash hash = SeededHash{});
+
+    // Cleans up the CuckooHashSet so that it leaks no memory.
+    ~CuckooHashSet() noexcept override;
+
+    // Initializes a new CuckooHashSet to be a copy of an existing one.
+    CuckooHashSet(const CuckooHashSet& s);
+
+    // Initializes a new CuckooHashSet whose contents are moved from an
+    // expiring one, which is left empty, with no table until something is
+    // added to it.
+    CuckooHashSet(CuckooHashSet&& s) noexcept;
+
+    // Assigns an existing CuckooHashSet into another.
+    CuckooHashSet& operator=(const CuckooHashSet& s);
+
+    // Assigns an expiring CuckooHashSet into another.
+    CuckooHashSet& operator=(CuckooHashSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  This function runs in amortized
+    // constant time; an add() that has to rehash runs in linear time.
+    void add(const ElementType& element) override;
+
+
+    // reserve() makes room for at least n elements, so that adding them
+    // won't rehash because the table is too full.  (A rehash is still
+    // possible if too many elements are kicked out in a row, though with
+    // a good hash function that's very unlikely.)
+    void reserve(std::size_t n) override;
+
+
+    // contains() returns true if the given element is already in the set,
+    // false otherwise.  This function runs in constant time in the worst
+    // case: it hashes the element once and examines two buckets.  It can
+    // also search for a key, such as a std::string_view in a set of
+    // strings; the key is hashed without being copied into an element as
+    // long as the hash function can be called with it directly (as
+    // HashStringSeeded can).
+    using Set<ElementType>::contains;
+    bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
+
+
+    // size() returns the number of elements in the set.
+    std::size_t size() const noexcept override;
+
+
+    // capacity() returns the number of slots in the table.
+    unsigned int capacity() const noexcept;
+
+
+private:
+    SeededHash hash;
+    std::uint64_t seed;
+    unsigned int sz;
+    unsigned int bucketCount;
+    std::uint8_t* tags;
+    ElementType* slots;
+
+private:
+    // firstBucket() and secondBucket() return the two buckets that an
+    // element with the given hash value can be stored in; tagOf() returns
+    // its (non-zero) tag.
+    unsigned int firstBucket(std::uint64_t hashValue) const noexcept;
+    unsigned int secondBucket(std::uint64_t hashValue) const noexcept;
+    static std::uint8_t tagOf(std::uint64_t hashValue) noexcept;
+
+    // hashKey() hashes a key with the current seed, calling the hash
+    // function on it directly if it can, or on an element made from it
+    // otherwise.
+    template <typename Key>
+    std::uint64_t hashKey(const Key& key) const;
+
+    // containsHashed() is contains() for an element (or a key that compares
+    // equal to one) whose hash value has already been computed.
+    template <typename Key>
+    bool containsHashed(const Key& element, std::uint64_t hashValue) const;
+
+    // placeInBucket() moves the given element into an empty slot of the
+    // given bucket, returning false if the bucket is full.
+    bool placeInBucket(unsigned int bucket, ElementType& element, std::uint8_t tag);
+
+    // place() moves the given element into the table, kicking out other
+    // elements as needed.  If it gives up, it returns false, and whichever
+    // element was left without a slot is moved into "element".
+    bool place(ElementType& element);
+
+    // maxSize() returns the most elements a table with the given number of
+    // buckets may hold before it's grown.
+    static unsigned long long maxSize(unsigned int buckets) noexcept;
+
+    // rehash() moves every element into a new table with (at least) the
+    // given number of buckets, and a new seed.
+    void rehash(unsigned int newBucketCount);
+
+    // allocateTable() allocates an empty table with the given number of
+    // buckets (which a set that was moved from has none of until then);
+    // takeAll() moves every element out of the table into the
+    // given vector, then releases the table.
+    void allocateTable(unsigned int newBucketCount);
+    void takeAll(std::vector<ElementType>& elements);
+};
+
+
+
+template <typename ElementType, typename SeededHash>
+CuckooHashSet<ElementType, SeededHash>::CuckooHashSet(SeededHash hash)
+    : hash{hash}, seed{0}, sz{0}, bucketCount{0}, tags{nullptr}, slots{nullptr}
+{
+    allocateTable(DEFAULT_BUCKET_COUNT);
+}
+
+
+template <typename ElementType, typename SeededHash>
+CuckooHashSet<ElementType, SeededHash>::~CuckooHashSet() noexcept
+{
+    delete[] tags;
+    delete[] slots;
+}
+
+
+template <typename ElementType, typename SeededHash>
+CuckooHashSet<ElementType, SeededHash>::CuckooHashSet(const CuckooHashSet& s)
+    : hash{s.hash}, seed{s.seed}, sz{s.sz}, bucketCount{s.bucketCount},
+      tags{nullptr}, slots{nullptr}
+{
+    unsigned int slotCount = bucketCount * SLOTS_PER_BUCKET;
+
+    tags = new std::uint8_t[slotCount];
+    std::copy(s.tags, s.tags + slotCount, tags);
+
+    try
+    {
+        slots = new ElementType[slotCount];
+        std::copy(s.slots, s.slots + slotCount, slots);
+    }
+    catch (...)
+    {
+        delete[] tags;
+        delete[] slots;
+        throw;
+    }
+}
+
+
+template <typename ElementType, typename SeededHash>
+CuckooHashSet<ElementType, SeededHash>::CuckooHashSet(CuckooHashSet&& s) noexcept
+    : hash{s.hash}, seed{0}, sz{0}, bucketCount{0}, tags{nullptr}, slots{nullptr}
+{
+    // leave the expiring set empty, with no table, but still usable; it
+    // allocates one the next time something is added to it
+    std::swap(seed, s.seed);
+    std::swap(sz, s.sz);
+    std::swap(bucketCount, s.bucketCount);
+    std::swap(tags, s.tags);
+    std::swap(slots, s.slots);
+}
+
+
+template <typename ElementType, typename SeededHash>
+CuckooHashSet<ElementType, SeededHash>& CuckooHashSet<ElementType, SeededHash>::operator=(
+    const CuckooHashSet& s)
+{
+    if (this != &s)
+    {
+        CuckooHashSet copy{s};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename SeededHash>
+CuckooHashSet<ElementType, SeededHash>& CuckooHashSet<ElementType, SeededHash>::operator=(
+    CuckooHashSet&& s) noexcept
+{
+    if (this != &s)
+    {
+        std::swap(hash, s.hash);
+        std::swap(seed, s.seed);
+        std::swap(sz, s.sz);
+        std::swap(bucketCount, s.bucketCount);
+        std::swap(tags, s.tags);
+        std::swap(slots, s.slots);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool CuckooHashSet<ElementType, SeededHash>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType, typename SeededHash>
+unsigned int CuckooHashSet<ElementType, SeededHash>::firstBucket(
+    std::uint64_t hashValue) const noexcept
+{
+    return static_cast<unsigned int>(hashValue) & (bucketCount - 1);
+}
+
+
+template <typename ElementType, typename SeededHash>
+unsigned int CuckooHashSet<ElementType, SeededHash>::secondBucket(
+    std::uint64_t hashValue) const noexcept
+{
+    // the second bucket is the first one with some of its bits flipped
+    // (always at least one, so the two buckets are never the same)
+    unsigned int flip = static_cast<unsigned int>(hashValue >> 32) & (bucketCount - 1);
+    return firstBucket(hashValue) ^ (flip == 0 ? 1 : flip);
+}
+
+
+template <typename ElementType, typename SeededHash>
+std::uint8_t CuckooHashSet<ElementType, SeededHash>::tagOf(std::uint64_t hashValue) noexcept
+{
+    std::uint8_t tag = static_cast<std::uint8_t>(hashValue >> 56);
+    return tag == 0 ? 1 : tag;
+}
+
+
+template <typename ElementType, typename SeededHash>
+template <typename Key>
+std::uint64_t CuckooHashSet<ElementType, SeededHash>::hashKey(const Key& key) const
+{
+    if constexpr (std::is_invocable_r_v<std::uint64_t, const SeededHash&, const Key&, std::uint64_t>)
+    {
+        return hash(key, seed);
+    }
+    else
+    {
+        return hash(ElementType{key}, seed);
+    }
+}
+
+
+template <typename ElementType, typename SeededHash>
+template <typename Key>
+bool CuckooHashSet<ElementType, SeededHash>::containsHashed(
+    const Key& element, std::uint64_t hashValue) const
+{
+    if (bucketCount == 0) return false;
+
+    std::uint8_t tag = tagOf(hashValue);
+
+    for (unsigned int bucket : {firstBucket(hashValue), secondBucket(hashValue)})
+    {
+        unsigned int first = bucket * SLOTS_PER_BUCKET;
+        for (unsigned int i = first; i < first + SLOTS_PER_BUCKET; i++)
+        {
+            if (tags[i] == tag && slots[i] == element)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool CuckooHashSet<ElementType, SeededHash>::contains(const ElementType& element) const
+{
+    return containsHashed(element, hashKey(element));
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool CuckooHashSet<ElementType, SeededHash>::contains(SetKeyType<ElementType> key) const
+{
+    const auto& element = impl_::SetKey<ElementType>::get(key);
+    return containsHashed(element, hashKey(element));
+}
+
+
+template <typename ElementType, typename SeededHash>
+void CuckooHashSet<ElementType, SeededHash>::add(const ElementType& element)
+{
+    if (containsHashed(element, hashKey(element))) return;
+
+    if (bucketCount == 0)
+    {
+        allocateTable(DEFAULT_BUCKET_COUNT);
+    }
+
+    if (sz + 1 > maxSize(bucketCount))
+    {
+        rehash(bucketCount * 2);
+    }
+
+    ElementType homeless = element;
+    while (!place(homeless))
+    {
+        rehash(bucketCount * 2);
+    }
+    sz++;
+}
+
+
+template <typename ElementType, typename SeededHash>
+void CuckooHashSet<ElementType, SeededHash>::reserve(std::size_t n)
+{
+    unsigned int newBucketCount = std::max(bucketCount, DEFAULT_BUCKET_COUNT);
+    while (n > maxSize(newBucketCount))
+    {
+        newBucketCount *= 2;
+    }
+
+    if (newBucketCount != bucketCount)
+    {
+        rehash(newBucketCount);
+    }
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool CuckooHashSet<ElementType, SeededHash>::placeInBucket(
+    unsigned int bucket, ElementType& element, std::uint8_t tag)
+{
+    unsigned int first = bucket * SLOTS_PER_BUCKET;
+    for (unsigned int i = first; i < first + SLOTS_PER_BUCKET; i++)
+    {
+        if (tags[i] == 0)
+        {
+            tags[i] = tag;
+            slots[i] = std::move(element);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool CuckooHashSet<ElementType, SeededHash>::place(ElementType& element)
+{
+    // the bucket the element was just kicked out of, if any, which it
+    // mustn't be put straight back into
+    unsigned int kickedFrom = bucketCount;
+
+    for (unsigned int kicks = 0; kicks <= MAX_KICKS; kicks++)
+    {
+        std::uint64_t hashValue = hashKey(element);
+        std::uint8_t tag = tagOf(hashValue);
+        unsigned int first = firstBucket(hashValue);
+        unsigned int second = secondBucket(hashValue);
+
+        if (placeInBucket(first, element, tag) || placeInBucket(second, element, tag))
+        {
+            return true;
+        }
+
+        // both buckets are full, so swap the element with one in the
+        // bucket it didn't come from, picking the slot by its hash value
+        // so different elements don't keep kicking out the same one
+        unsigned int bucket = (first != kickedFrom) ? first : second;
+        unsigned int victim =
+            bucket * SLOTS_PER_BUCKET + static_cast<unsigned int>(hashValue >> 16) % SLOTS_PER_BUCKET;
+
+        std::swap(slots[victim], element);
+        tags[victim] = tag;
+        kickedFrom = bucket;
+    }
+
+    return false;
+}
+
+
+template <typename ElementType, typename SeededHash>
+unsigned long long CuckooHashSet<ElementType, SeededHash>::maxSize(unsigned int buckets) noexcept
+{
+    return static_cast<unsigned long long>(buckets) * SLOTS_PER_BUCKET * 9 / 10;
+}
+
+
+template <typename ElementType, typename SeededHash>
+void CuckooHashSet<ElementType, SeededHash>::rehash(unsigned int newBucketCount)
+{
+    std::vector<ElementType> elements;
+    elements.reserve(sz + 1);
+    takeAll(elements);
+
+    while (true)
+    {
+        allocateTable(newBucketCount);
+        seed++;
+
+        unsigned int placed = 0;
+        while (placed < elements.size() && place(elements[placed]))
+        {
+            placed++;
+        }
+
+        if (placed == elements.size())
+        {
+            sz = elements.size();
+            return;
+        }
+
+        // elements[placed] now holds whichever element was left without a
+        // slot, so gather it, the rest, and the ones already placed, and
+        // start over with a new seed and a larger table
+        std::vector<ElementType> remaining;
+        remaining.reserve(elements.size());
+        takeAll(remaining);
+        for (unsigned int i = placed; i < elements.size(); i++)
+        {
+            remaining.push_back(std::move(elements[i]));
+        }
+
+        elements = std::move(remaining);
+        newBucketCount *= 2;
+    }
+}
+
+
+template <typename ElementType, typename SeededHash>
+void CuckooHashSet<ElementType, SeededHash>::allocateTable(unsigned int newBucketCount)
+{
+    unsigned int slotCount = newBucketCount * SLOTS_PER_BUCKET;
+
+    std::uint8_t* newTags = new std::uint8_t[slotCount];
+    std::fill(newTags, newTags + slotCount, 0);
+
+    try
+    {
+        slots = new ElementType[slotCount];
+    }
+    catch (...)
+    {
+        delete[] newTags;
+        throw;
+    }
+
+    tags = newTags;
+    bucketCount = newBucketCount;
+    sz = 0;
+}
+
+
+template <typename ElementType, typename SeededHash>
+void CuckooHashSet<ElementType, SeededHash>::takeAll(std::vector<ElementType>& elements)
+{
+    for (unsigned int i = 0; i < bucketCount * SLOTS_PER_BUCKET; i++)
+    {
+        if (tags[i] != 0)
+        {
+            elements.push_back(std::move(slots[i]));
+        }
+    }
+
+    delete[] tags;
+    delete[] slots;
+    tags = nullptr;
+    slots = nullptr;
+    bucketCount = 0;
+    sz = 0;
+}
+
+
+template <typename ElementType, typename SeededHash>
+std::size_t CuckooHashSet<ElementType, SeededHash>::size() const noexcept
+{
+    return sz;
+}
+
+
+template <typename ElementType, typename SeededHash>
+unsigned int CuckooHashSet<ElementType, SeededHash>::capacity() const noexcept
+{
+    return bucketCount * SLOTS_PER_BUCKET;
+}
+
+
+
+#endif
@@ -0,0 +1,555 @@
+// FlatHashSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A FlatHashSet is an implementation of a Set that is an open-addressing
+// hash table in the style of a "Swiss table."  Rather than an array of
+// linked lists, the elements are stored directly in one contiguous array
+// of slots, alongside a parallel array of one-byte "control" values, one
+// per slot.  A control byte is either EMPTY or holds the low 7 bits of
+// the element's (mixed) hash value.
+//
+// The slots are divided into groups of 16.  A lookup hashes the element
+// once, then examines an entire group of control bytes at a time (using
+// a single SSE2 compare where it's available), so that only slots whose
+// 7-bit tag matches ever have their elements compared.  Groups are probed
+// in a triangular sequence until a group containing an EMPTY byte is
+// found, at which point the element is known not to be present.
+//
+// The capacity is always a power of two and a multiple of the group size.
+// When adding an element would make the table more than 7/8 full, the
+// table doubles in size and every element is moved into the new one.
+//
+// The hash function is shared (never copied) between a FlatHashSet and
+// the sets copied or moved from it, so that moving one never allocates.
+// A set that's been moved from is left with no table at all (a capacity
+// of zero), and allocates one again the first time something is added.
+
+#ifndef FLATHASHSET_HPP
+#define FLATHASHSET_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Set.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+template <
+    typename ElementType,
+    typename Hash = std::function<unsigned int(const ElementType&)>>
+class FlatHashSet : public Set<ElementType>
+{
+public:
+    // The number of slots whose control bytes are examined together.
+    static constexpr unsigned int GROUP_SIZE = 16;
+
+    // The default capacity of the FlatHashSet before anything has been
+    // added to it.
+    static constexpr unsigned int DEFAULT_CAPACITY = GROUP_SIZE;
+
+    // A HashFunction is a function that takes a reference to a const
+    // ElementType and returns an unsigned int.  By default, it is a
+    // std::function; a functor type can be given instead, so calls to it
+    // are inlined, and so (if it can hash a key directly) searching for a
+    // key never has to make an element out of it.
+    using HashFunction = Hash;
+
+public:
+    // Initializes a FlatHashSet to be empty, so that it will use the given
+    // hash function whenever it needs to hash an element.
+    explicit FlatHashSet(HashFunction hashFunction);
+
+    // Cleans up the FlatHashSet so that it leaks no memory.
+    ~FlatHashSet() noexcept override;
+
+    // Initializes a new FlatHashSet to be a copy of an existing one.
+    FlatHashSet(const FlatHashSet& s);
+
+    // Initializes a new FlatHashSet whose contents are moved from an
+    // expiring one, which is left empty, with no table until something is
+    // added to it.
+    FlatHashSet(FlatHashSet&& s) noexcept;
+
+    // Assigns an existing FlatHashSet into another.
+    FlatHashSet& operator=(const FlatHashSet& s);
+
+    // Assigns an expiring FlatHashSet into another.
+    FlatHashSet& operator=(FlatHashSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  If adding the element would make
+    // the table more than 7/8 full, the capacity is doubled first, which
+    // takes linear time; otherwise, this function runs in constant time
+    // (assuming a good hash function).
+    void add(const ElementType& element) override;
+
+
+    // reserve() doubles the capacity until n elements would fit without
+    // exceeding the 7/8 limit, so that adding them triggers no growth.
+    void reserve(std::size_t n) override;
+
+
+    // contains() returns true if the given element (or a key that compares
+    // equal to one) is already in the set, false otherwise.  This function
+    // runs in constant time (assuming a good hash function), and usually
+    // examines only one group of control bytes and compares against at
+    // most one element.
+    using Set<ElementType>::contains;
+    bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
+
+
+    // size() returns the number of elements in the set.
+    std::size_t size() const noexcept override;
+
+
+    // capacity() returns the number of slots in the table.
+    unsigned int capacity() const noexcept;
+
+
+private:
+    // Control byte values.  A full slot's control byte holds a 7-bit tag
+    // taken from its element's hash, so its high bit is always clear.
+    static constexpr std::int8_t EMPTY = -128;
+
+    // A GroupMask has one bit set for each matching slot in a group.
+    using GroupMask = std::uint32_t;
+
+private:
+    std::shared_ptr<const HashFunction> hashFunction;
+    unsigned int sz;
+    unsigned int cap;
+    std::int8_t* control;
+    ElementType* slots;
+
+private:
+    // mix() spreads the bits of a (possibly weak) hash value, so that both
+    // the group index and the 7-bit tag depend on all of its bits.
+    static std::uint64_t mix(unsigned int hashValue) noexcept;
+
+    // tagOf() returns the 7-bit tag stored in the control byte of a slot
+    // whose element has the given mixed hash.
+    static std::int8_t tagOf(std::uint64_t mixed) noexcept;
+
+    // matchTag() returns a mask of the slots in the group beginning at
+    // the given control byte whose tag equals the given one.
+    static GroupMask matchTag(const std::int8_t* group, std::int8_t tag) noexcept;
+
+    // matchEmpty() returns a mask of the empty slots in the group beginning
+    // at the given control byte.
+    static GroupMask matchEmpty(const std::int8_t* group) noexcept;
+
+    // lowestBit() returns the index of the lowest set bit in a non-zero mask.
+    static unsigned int lowestBit(GroupMask mask) noexcept;
+
+    // allocateTable() allocates (but does not construct) slots and control
+    // bytes for a table with the given capacity, marking every slot empty.
+    static void allocateTable(
+        unsigned int cap, std::int8_t*& control, ElementType*& slots);
+
+    // deallocateTable() destroys every element and releases the table.
+    void deallocateTable() noexcept;
+
+    // findEmptySlot() returns the index of the first empty slot along the
+    // probe sequence of the given mixed hash.
+    unsigned int findEmptySlot(std::uint64_t mixed) const noexcept;
+
+    // hashKey() hashes a key, calling the hash function on it directly if
+    // it can, or on an element made from it otherwise
+    template <typename Key>
+    unsigned int hashKey(const Key& key) const;
+
+    // containsHashed() is contains() for an element (or a key that compares
+    // equal to one) whose mixed hash has already been computed
+    template <typename Key>
+    bool containsHashed(const Key& element, std::uint64_t mixed) const;
+
+    // fits() returns true if n elements fit in a table with the given
+    // capacity without exceeding the 7/8 limit.
+    static bool fits(unsigned long long n, unsigned int cap) noexcept;
+
+    // rehash() moves every element into a new table with the given capacity.
+    void rehash(unsigned int newCap);
+
+    // copyFrom() fills this (empty, unallocated) set with copies of the
+    // elements in another, keeping the same layout.
+    void copyFrom(const FlatHashSet& s);
+};
+
+
+
+template <typename ElementType, typename Hash>
+FlatHashSet<ElementType, Hash>::FlatHashSet(HashFunction hashFunction)
+    : hashFunction{std::make_shared<const HashFunction>(std::move(hashFunction))},
+      sz{0}, cap{DEFAULT_CAPACITY},
+      control{nullptr}, slots{nullptr}
+{
+    allocateTable(cap, control, slots);
+}
+
+
+template <typename ElementType, typename Hash>
+FlatHashSet<ElementType, Hash>::~FlatHashSet() noexcept
+{
+    deallocateTable();
+}
+
+
+template <typename ElementType, typename Hash>
+FlatHashSet<ElementType, Hash>::FlatHashSet(const FlatHashSet& s)
+    : hashFunction{s.hashFunction}, sz{0}, cap{0},
+      control{nullptr}, slots{nullptr}
+{
+    try
+    {
+        copyFrom(s);
+    }
+    catch (...)
+    {
+        // only the elements copied so far are marked as full
+        deallocateTable();
+        throw;
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+FlatHashSet<ElementType, Hash>::FlatHashSet(FlatHashSet&& s) noexcept
+    : hashFunction{s.hashFunction}, sz{0}, cap{0},
+      control{nullptr}, slots{nullptr}
+{
+    // leave the expiring set empty, with no table, but still usable; it
+    // allocates one the next time something is added to it
+    std::swap(sz, s.sz);
+    std::swap(cap, s.cap);
+    std::swap(control, s.control);
+    std::swap(slots, s.slots);
+}
+
+
+template <typename ElementType, typename Hash>
+FlatHashSet<ElementType, Hash>& FlatHashSet<ElementType, Hash>::operator=(const FlatHashSet& s)
+{
+    if (this != &s)
+    {
+        FlatHashSet copy{s};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename Hash>
+FlatHashSet<ElementType, Hash>& FlatHashSet<ElementType, Hash>::operator=(FlatHashSet&& s) noexcept
+{
+    if (this != &s)
+    {
+        std::swap(hashFunction, s.hashFunction);
+        std::swap(sz, s.sz);
+        std::swap(cap, s.cap);
+        std::swap(control, s.control);
+        std::swap(slots, s.slots);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename Hash>
+bool FlatHashSet<ElementType, Hash>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType, typename Hash>
+std::uint64_t FlatHashSet<ElementType, Hash>::mix(unsigned int hashValue) noexcept
+{
+    // multiply by 2^64 / golden ratio, then fold the high half back in
+    std::uint64_t mixed = static_cast<std::uint64_t>(hashValue) * 0x9E3779B97F4A7C15ULL;
+    return mixed ^ (mixed >> 32);
+}
+
+
+template <typename ElementType, typename Hash>
+std::int8_t FlatHashSet<ElementType, Hash>::tagOf(std::uint64_t mixed) noexcept
+{
+    return static_cast<std::int8_t>(mixed & 0x7F);
+}
+
+
+template <typename ElementType, typename Hash>
+typename FlatHashSet<ElementType, Hash>::GroupMask FlatHashSet<ElementType, Hash>::matchTag(
+    const std::int8_t* group, std::int8_t tag) noexcept
+{
+#ifdef __SSE2__
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    __m128i matches = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(tag));
+    return static_cast<GroupMask>(_mm_movemask_epi8(matches));
+#else
+    GroupMask mask = 0;
+    for (unsigned int i = 0; i < GROUP_SIZE; i++)
+    {
+        if (group[i] == tag) mask |= GroupMask{1} << i;
+    }
+    return mask;
+#endif
+}
+
+
+template <typename ElementType, typename Hash>
+typename FlatHashSet<ElementType, Hash>::GroupMask FlatHashSet<ElementType, Hash>::matchEmpty(
+    const std::int8_t* group) noexcept
+{
+    return matchTag(group, EMPTY);
+}
+
+
+template <typename ElementType, typename Hash>
+unsigned int FlatHashSet<ElementType, Hash>::lowestBit(GroupMask mask) noexcept
+{
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+}
+
+
+template <typename ElementType, typename Hash>
+void FlatHashSet<ElementType, Hash>::allocateTable(
+    unsigned int cap, std::int8_t*& control, ElementType*& slots)
+{
+    ElementType* newSlots = static_cast<ElementType*>(::operator new(sizeof(ElementType) * cap));
+
+    try
+    {
+        control = new std::int8_t[cap];
+    }
+    catch (...)
+    {
+        ::operator delete(newSlots);
+        throw;
+    }
+
+    slots = newSlots;
+    for (unsigned int i = 0; i < cap; i++)
+    {
+        control[i] = EMPTY;
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+void FlatHashSet<ElementType, Hash>::deallocateTable() noexcept
+{
+    if (control != nullptr)
+    {
+        for (unsigned int i = 0; i < cap; i++)
+        {
+            if (control[i] != EMPTY) slots[i].~ElementType();
+        }
+    }
+    delete[] control;
+    ::operator delete(slots);
+}
+
+
+template <typename ElementType, typename Hash>
+unsigned int FlatHashSet<ElementType, Hash>::findEmptySlot(std::uint64_t mixed) const noexcept
+{
+    unsigned int groupMask = cap / GROUP_SIZE - 1;
+    unsigned int group = static_cast<unsigned int>(mixed >> 7) & groupMask;
+
+    for (unsigned int step = 1; ; step++)
+    {
+        GroupMask empties = matchEmpty(control + group * GROUP_SIZE);
+        if (empties != 0)
+        {
+            return group * GROUP_SIZE + lowestBit(empties);
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+bool FlatHashSet<ElementType, Hash>::fits(unsigned long long n, unsigned int cap) noexcept
+{
+    return n * 8 <= static_cast<unsigned long long>(cap) * 7;
+}
+
+
+template <typename ElementType, typename Hash>
+void FlatHashSet<ElementType, Hash>::rehash(unsigned int newCap)
+{
+    std::int8_t* newControl = nullptr;
+    ElementType* newSlots = nullptr;
+    allocateTable(newCap, newControl, newSlots);
+
+    std::int8_t* oldControl = control;
+    ElementType* oldSlots = slots;
+    unsigned int oldCap = cap;
+
+    control = newControl;
+    slots = newSlots;
+    cap = newCap;
+
+    // move every element into the new table; since no element can already
+    // be there, each only needs an empty slot along its probe sequence
+    for (unsigned int i = 0; i < oldCap; i++)
+    {
+        if (oldControl[i] != EMPTY)
+        {
+            std::uint64_t mixed = mix((*hashFunction)(oldSlots[i]));
+            unsigned int index = findEmptySlot(mixed);
+            new (slots + index) ElementType{std::move(oldSlots[i])};
+            control[index] = tagOf(mixed);
+            oldSlots[i].~ElementType();
+        }
+    }
+
+    delete[] oldControl;
+    ::operator delete(oldSlots);
+}
+
+
+template <typename ElementType, typename Hash>
+void FlatHashSet<ElementType, Hash>::copyFrom(const FlatHashSet& s)
+{
+    allocateTable(s.cap, control, slots);
+    cap = s.cap;
+
+    for (unsigned int i = 0; i < cap; i++)
+    {
+        if (s.control[i] != EMPTY)
+        {
+            new (slots + i) ElementType{s.slots[i]};
+            control[i] = s.control[i];
+            sz++;
+        }
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+void FlatHashSet<ElementType, Hash>::add(const ElementType& element)
+{
+    if (!contains(element))
+    {
+        if (!fits(static_cast<unsigned long long>(sz) + 1, cap))
+        {
+            rehash(std::max(cap * 2, DEFAULT_CAPACITY));
+        }
+
+        std::uint64_t mixed = mix((*hashFunction)(element));
+        unsigned int index = findEmptySlot(mixed);
+        new (slots + index) ElementType{element};
+        control[index] = tagOf(mixed);
+        sz++;
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+void FlatHashSet<ElementType, Hash>::reserve(std::size_t n)
+{
+    unsigned int newCap = std::max(cap, DEFAULT_CAPACITY);
+    while (!fits(n, newCap))
+    {
+        newCap *= 2;
+    }
+
+    if (newCap != cap)
+    {
+        rehash(newCap);
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+bool FlatHashSet<ElementType, Hash>::contains(const ElementType& element) const
+{
+    if (cap == 0) return false;
+
+    return containsHashed(element, mix((*hashFunction)(element)));
+}
+
+
+template <typename ElementType, typename Hash>
+bool FlatHashSet<ElementType, Hash>::contains(SetKeyType<ElementType> key) const
+{
+    if (cap == 0) return false;
+
+    const auto& element = impl_::SetKey<ElementType>::get(key);
+    return containsHashed(element, mix(hashKey(element)));
+}
+
+
+template <typename ElementType, typename Hash>
+template <typename Key>
+unsigned int FlatHashSet<ElementType, Hash>::hashKey(const Key& key) const
+{
+    if constexpr (std::is_invocable_r_v<unsigned int, const Hash&, const Key&>)
+    {
+        return (*hashFunction)(key);
+    }
+    else
+    {
+        return (*hashFunction)(ElementType{key});
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+template <typename Key>
+bool FlatHashSet<ElementType, Hash>::containsHashed(
+    const Key& element, std::uint64_t mixed) const
+{
+    std::int8_t tag = tagOf(mixed);
+    unsigned int groupMask = cap / GROUP_SIZE - 1;
+    unsigned int group = static_cast<unsigned int>(mixed >> 7) & groupMask;
+
+    for (unsigned int step = 1; ; step++)
+    {
+        const std::int8_t* groupControl = control + group * GROUP_SIZE;
+
+        for (GroupMask matches = matchTag(groupControl, tag); matches != 0;
+             matches &= matches - 1)
+        {
+            if (slots[group * GROUP_SIZE + lowestBit(matches)] == element) return true;
+        }
+
+        // an empty slot ends the probe sequence, because add() would have
+        // placed the element there (or earlier) if it had been added
+        if (matchEmpty(groupControl) != 0) return false;
+
+        group = (group + step) & groupMask;
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+std::size_t FlatHashSet<ElementType, Hash>::size() const noexcept
+{
+    return sz;
+}
+
+
+template <typename ElementType, typename Hash>
+unsigned int FlatHashSet<ElementType, Hash>::capacity() const noexcept
+{
+    return cap;
+}
+
+
+
+#endif
@@ -0,0 +1,127 @@
+// HashRangePolicies.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A range policy decides how a HashSet maps a hash value onto an index
+// in its array, along with the capacities the array is allowed to have
+// (since some mappings only work for particular capacities).  Each policy
+// provides:
+//
+//     DEFAULT_CAPACITY          the capacity of an empty HashSet
+//     nextCapacity(cap)         the capacity to grow to from cap
+//     index(hashValue, cap)     the index in [0, cap) for a hash value
+//
+// All of these are static, so a HashSet pays nothing to store its policy,
+// and the compiler is free to inline the mapping into every probe.
+
+#ifndef HASHRANGEPOLICIES_HPP
+#define HASHRANGEPOLICIES_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+
+
+// ModuloRange takes the hash value modulo the capacity, and grows to
+// capacity * 2 + 1.  This is the HashSet's original behavior, and works
+// for any capacity, but each index costs an integer division.
+
+struct ModuloRange
+{
+    static constexpr std::size_t DEFAULT_CAPACITY = 10;
+
+    static std::size_t nextCapacity(std::size_t cap) noexcept
+    {
+        return cap * 2 + 1;
+    }
+
+    static std::size_t index(std::size_t hashValue, std::size_t cap) noexcept
+    {
+        return hashValue % cap;
+    }
+};
+
+
+
+// PrimeModuloRange takes the hash value modulo a prime capacity, roughly
+// doubling each time it grows.  A prime modulus uses every bit of the hash
+// value, which makes up for weaker hash functions.
+
+struct PrimeModuloRange
+{
+    static constexpr std::size_t DEFAULT_CAPACITY = 11;
+
+    static std::size_t nextCapacity(std::size_t cap) noexcept
+    {
+        static constexpr std::uint64_t primes[] = {
+            11, 23, 47, 97, 197, 397, 797, 1597, 3203, 6421, 12853, 25717,
+            51437, 102877, 205759, 411527, 823117, 1646237, 3292489, 6584983,
+            13169977, 26339969, 52679969, 105359939, 210719881, 421439783,
+            842879579, 1685759167, 3371518343ULL, 6743036717ULL,
+            13486073473ULL, 26972146961ULL, 53944293929ULL, 107888587883ULL,
+            215777175787ULL, 431554351609ULL, 863108703229ULL,
+            1726217406467ULL, 3452434812973ULL};
+
+        for (std::uint64_t prime : primes)
+        {
+            if (prime > cap) return prime;
+        }
+        return cap * 2 + 1;
+    }
+
+    static std::size_t index(std::size_t hashValue, std::size_t cap) noexcept
+    {
+        return hashValue % cap;
+    }
+};
+
+
+
+// PowerOfTwoRange keeps the capacity a power of two, so an index is just
+// the low bits of the hash value.  This is the cheapest mapping, but it
+// ignores the high bits entirely, so it needs a hash function whose low
+// bits are well-distributed.
+
+struct PowerOfTwoRange
+{
+    static constexpr std::size_t DEFAULT_CAPACITY = 16;
+
+    static std::size_t nextCapacity(std::size_t cap) noexcept
+    {
+        return cap * 2;
+    }
+
+    static std::size_t index(std::size_t hashValue, std::size_t cap) noexcept
+    {
+        return hashValue & (cap - 1);
+    }
+};
+
+
+
+// FibonacciRange keeps the capacity a power of two, multiplies the hash
+// value by 2^64 divided by the golden ratio, and takes the high bits of
+// the product.  That's nearly as cheap as masking, but every bit of the
+// hash value influences the index.
+
+struct FibonacciRange
+{
+    static constexpr std::size_t DEFAULT_CAPACITY = 16;
+
+    static std::size_t nextCapacity(std::size_t cap) noexcept
+    {
+        return cap * 2;
+    }
+
+    static std::size_t index(std::size_t hashValue, std::size_t cap) noexcept
+    {
+        unsigned int shift = 64 - static_cast<unsigned int>(__builtin_ctzll(cap));
+        std::uint64_t product = static_cast<std::uint64_t>(hashValue) * 11400714819323198485ULL;
+        return static_cast<std::size_t>(product >> shift);
+    }
+};
+
+
+
+#endif
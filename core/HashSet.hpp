@@ -19,37 +19,140 @@
 // in your data structure.  Instead, you'll need to use a dynamically-
 // allocated array and your own linked list implemenation; the linked list
 // doesn't have to be its own class, though you can do that, if you'd like.
+//
+// Beyond the element type, a HashSet has two optional template parameters.
+// Hash is the type of its hash function, which is a std::function by
+// default; passing a functor type instead (such as HashStringAsProduct)
+// lets the compiler inline the hash into every lookup.  RangePolicy (see
+// HashRangePolicies.hpp) decides how hash values map to indices and how
+// the capacity grows; by default, it's the modulo and "capacity * 2 + 1"
+// scheme described above.
+//
+// A HashSet can optionally grow incrementally instead.  When the ratio is
+// exceeded, a new array is allocated but the old one is kept, and each
+// subsequent add() migrates a fixed number of the old array's buckets into
+// the new one.  Until every bucket has been migrated, lookups check both
+// arrays.  This bounds the work done by any single add(), at the cost of
+// holding both arrays for a while.
+//
+// No matter how poor the hash function is, a lookup never walks a long
+// chain.  When a bucket's chain reaches TREEIFY_THRESHOLD nodes, the
+// HashSet also builds a balanced binary search tree over that bucket's
+// nodes (ordered by hash value, then by element), which lookups use
+// instead of the chain from then on.  (The chain is kept, so resizing and
+// the index-based queries work as they always have.)  So even if every
+// element hashes to the same value, contains() runs in O(log n) time.
+// This requires elements that can be compared with <; for element types
+// that can't be, chains are never treeified.
+//
+// A HashSet can also be made self-organizing, in which case every
+// successful lookup in a chain moves the node it found to the front of
+// that chain.  When some elements are looked up far more often than
+// others (as words in real text are), those elements end up at the heads
+// of their chains, so fewer nodes are visited on average.  Because this
+// reorders chains even during contains(), a self-organizing HashSet must
+// not be searched by more than one thread at a time.  (Neither must one
+// that's been asked to count the nodes its lookups visit; otherwise,
+// contains() writes nothing.)
+//
+// Many elements can be added at once, in parallel, with addAll().  The
+// elements are hashed by several threads, then partitioned by the range
+// of buckets they belong in, so that each thread links nodes into its own
+// range of buckets and no locking is needed.  Rehashing a large HashSet
+// is parallelized the same way.  Either way, the hash function is called
+// from several threads at once, so it must be safe to do that.  Copying
+// and destroying a large HashSet are split across threads, too, each
+// copying or destroying the chains in one range of buckets.
 
 #ifndef HASHSET_HPP
 #define HASHSET_HPP
 
+#include <cstddef>
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "Set.hpp"
+#include "HashRangePolicies.hpp"
+#include "NodePool.hpp"
+#include "Parallel.hpp"
 #include <algorithm>
 
 
-template <typename ElementType>
+
+namespace impl_
+{
+    // HashSet__isOrdered<ElementType>::value is true if two ElementTypes
+    // can be compared with <, which is required to treeify a bucket.
+    template <typename ElementType, typename = void>
+    struct HashSet__isOrdered : std::false_type
+    {
+    };
+
+
+    template <typename ElementType>
+    struct HashSet__isOrdered<
+        ElementType,
+        std::void_t<decltype(std::declval<const ElementType&>() < std::declval<const ElementType&>())>>
+        : std::true_type
+    {
+    };
+}
+
+
+
+template <
+    typename ElementType,
+    typename Hash = std::function<std::size_t(const ElementType&)>,
+    typename RangePolicy = ModuloRange>
 class HashSet : public Set<ElementType>
 {
 public:
     // The default capacity of the HashSet before anything has been
-    // added to it.
-    static constexpr unsigned int DEFAULT_CAPACITY = 10;
+    // added to it, as determined by its range policy.
+    static constexpr std::size_t DEFAULT_CAPACITY = RangePolicy::DEFAULT_CAPACITY;
+
+    // The number of old buckets migrated by each add() while growing
+    // incrementally.  Since the capacity more than doubles, migrating two
+    // buckets per add() finishes well before the next resize is due.
+    static constexpr unsigned int MIGRATION_STEP = 2;
+
+    // The length a bucket's chain must reach before the bucket is
+    // treeified, if elements can be compared with <.
+    static constexpr unsigned int TREEIFY_THRESHOLD = 8;
+
+    // The fewest elements worth giving to each thread when adding, copying,
+    // or destroying elements or rehashing in parallel; smaller jobs use
+    // fewer threads (or one).
+    static constexpr unsigned int PARALLEL_THRESHOLD = 16384;
 
     // A HashFunction is a function that takes a reference to a const
-    // ElementType and returns an unsigned int.
-    using HashFunction = std::function<unsigned int(const ElementType&)>;
+    // ElementType and returns a std::size_t (or anything that converts to
+    // one, like an unsigned int, though a set with more than 2^32 elements
+    // needs a hash function with more bits than that).  By default, it is
+    // a std::function, so any function can be passed to the constructor;
+    // a functor type can be given instead, so calls to it are inlined.
+    using HashFunction = Hash;
 
 public:
     // Initializes a HashSet to be empty, so that it will use the given
-    // hash function whenever it needs to hash an element.
-    explicit HashSet(HashFunction hashFunction);
+    // hash function whenever it needs to hash an element, growing either
+    // all at once (the default) or incrementally, and allocating its nodes
+    // either individually (the default) or from a NodePool, and either
+    // leaving its chains in the order elements were added (the default)
+    // or self-organizing them.
+    explicit HashSet(
+        HashFunction hashFunction, bool growIncrementally = false,
+        bool usePool = false, bool selfOrganizing = false);
 
     // Cleans up the HashSet so that it leaks no memory.
     ~HashSet() noexcept override;
 
-    // Initializes a new HashSet to be a copy of an existing one.
+    // Initializes a new HashSet to be a copy of an existing one, copying
+    // ranges of buckets in parallel if it's large enough, using the given
+    // number of threads (or, by default, one per hardware thread).
     HashSet(const HashSet& s);
+    HashSet(const HashSet& s, unsigned int threadCount);
 
     // Initializes a new HashSet whose contents are moved from an
     // expiring one.
@@ -70,163 +173,551 @@ public:
     // add() adds an element to the set.  If the element is already in the set,
     // this function has no effect.  This function triggers a resizing of the
     // array when the ratio of size to capacity would exceed 0.8, in which case
-    // the new capacity should be determined by this formula:
+    // the new capacity is determined by the range policy.  By default, it's
+    // determined by this formula:
     //
     //     capacity * 2 + 1
     //
     // In the case where the array is resized, this function runs in linear
     // time (with respect to the number of elements, assuming a good hash
     // function); otherwise, it runs in constant time (again, assuming a good
-    // hash function).  The amortized running time is also constant.
+    // hash function).  The amortized running time is also constant.  If
+    // the hash function is poor, it runs in O(log n) time (once a resize
+    // isn't needed), since long chains are treeified.
+    //
+    // When growing incrementally, no call to add() does more than a constant
+    // amount of resizing work, beyond allocating the new array.
     void add(const ElementType& element) override;
 
 
+    // reserve() makes room for at least n elements, resizing the array (by
+    // the same policy add() uses) until n elements would not exceed the
+    // 0.8 ratio, so that adding them triggers no further resizing.  If
+    // there is already enough room, this function has no effect.  Any
+    // incremental growth that's in progress is finished first.
+    void reserve(std::size_t n) override;
+
+
+    // addAll() adds every element in a vector to the set, using the given
+    // number of threads (or, if it's zero, one per hardware thread).  Room
+    // is reserved for the elements first, then they're hashed and linked
+    // into their buckets in parallel.  If there are only a few elements,
+    // they're simply added one at a time.
+    void addAll(const std::vector<ElementType>& elements) override;
+    void addAll(const std::vector<ElementType>& elements, unsigned int threadCount);
+
+
     // contains() returns true if the given element is already in the set,
     // false otherwise.  This function runs in constant time (with respect
-    // to the number of elements, assuming a good hash function).
+    // to the number of elements, assuming a good hash function), and in
+    // O(log n) time at worst, whatever the hash function.  It can
+    // also search for a key, such as a std::string_view in a set of
+    // strings; the key is hashed without being copied into an element as
+    // long as the hash function can be called with it directly (as the
+    // functors in StringHashing.hpp can).
+    using Set<ElementType>::contains;
     bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
 
 
     // size() returns the number of elements in the set.
-    unsigned int size() const noexcept override;
+    std::size_t size() const noexcept override;
+
+
+    // clear() removes every element from the set, keeping its capacity.
+    // If there are enough elements, ranges of buckets are destroyed in
+    // parallel, using the given number of threads (or, if it's zero, one
+    // per hardware thread), as they are when a large HashSet is destroyed.
+    void clear(unsigned int threadCount = 0);
 
 
     // elementsAtIndex() returns the number of elements that hashed to a
     // particular index in the array.  If the index is out of the boundaries
-    // of the array, this function returns 0.
-    unsigned int elementsAtIndex(unsigned int index) const;
+    // of the array, this function returns 0.  While growing incrementally,
+    // elements not yet migrated count toward the index they'll move to.
+    std::size_t elementsAtIndex(std::size_t index) const;
 
 
     // isElementAtIndex() returns true if the given element hashed to a
     // particular index in the array, false otherwise.  If the index is
     // out of the boundaries of the array, this functions returns false.
-    bool isElementAtIndex(const ElementType& element, unsigned int index) const;
+    bool isElementAtIndex(const ElementType& element, std::size_t index) const;
+
+
+    // poolStats() returns a summary of the nodes allocated from the
+    // HashSet's NodePool, which is empty unless it was asked to use one.
+    NodePoolStats poolStats() const noexcept;
+
+
+    // countNodesVisited() turns on (or off) counting the nodes visited by
+    // lookups.  It's off by default, since the count is updated even by
+    // contains(), so a HashSet that counts them must not be searched by
+    // more than one thread at a time.
+    void countNodesVisited(bool count) noexcept;
+
+
+    // nodesVisited() returns the total number of nodes (in chains or in
+    // trees) visited by every lookup made while counting was turned on,
+    // including the ones made by add() to check for duplicates.
+    unsigned long long nodesVisited() const noexcept;
 
 
 private:
+    // Each node remembers the full hash value of its element, so that
+    // lookups can skip comparing elements whose hash values differ and
+    // resizing never needs to call the hash function again.
     struct Node
     {
         ElementType value;
+        std::size_t hashValue;
         Node* next;
     };
 
+    // A TreeNode is a node in the balanced binary search tree (an AVL
+    // tree) built over the nodes of a treeified bucket.
+    struct TreeNode
+    {
+        Node* node;
+        TreeNode* left;
+        TreeNode* right;
+        int height;
+    };
+
 private:
     HashFunction hashFunction;
 
     // You'll no doubt want to add member variables and "helper" member
     // functions here.
-    unsigned int sz;
-    unsigned int cap;
+    std::size_t sz;
+    std::size_t cap;
     Node** hashArray;
+
+    // The roots of the trees of any treeified buckets in hashArray (or
+    // nullptr for the others), or nullptr if none have been treeified.
+    TreeNode** trees;
+
+    // While growing incrementally, oldArray is the previous array (with
+    // capacity oldCap), whose buckets before index "migrated" have already
+    // been moved into hashArray.  Otherwise, oldArray is nullptr.
+    bool growIncrementally;
+    Node** oldArray;
+    TreeNode** oldTrees;
+    std::size_t oldCap;
+    std::size_t migrated;
+
+    // When usePool is true, every node is created in (and only released
+    // along with) the pool.
+    bool usePool;
+    NodePool<Node> pool;
+
+    // When selfOrganizing is true, lookups move the nodes they find to the
+    // fronts of their chains.
+    bool selfOrganizing;
+
+    // When countVisits is true, visitedCount is the number of nodes
+    // visited by lookups, which is mutable since contains() counts them.
+    bool countVisits;
+    mutable unsigned long long visitedCount;
 private:
     // deallocateHashTable() deallocates the hash table that hashArray
     // points to
     void deallocateHashTable() noexcept;
     
-    // copyHashArray() copies all the elements in the source into the target
-    void copyHashArray(Node** target, Node** source, unsigned int cap);
+    // makeNode() creates a new node, in the pool if one is being used
+    Node* makeNode(const ElementType& value, std::size_t hashValue, Node* next);
+
+    // releaseNodes() destroys every node (but not the arrays) using the
+    // given number of threads, leaving every bucket empty
+    void releaseNodes(unsigned int threadCount) noexcept;
+
+    // deleteChains() deletes the nodes in buckets first through last - 1
+    // of an array, leaving those buckets empty
+    static void deleteChains(Node** array, std::size_t first, std::size_t last) noexcept;
+
+    // copyHashArray() copies all the elements in the source into the target,
+    // splitting the buckets among the given number of threads
+    void copyHashArray(
+        Node** target, Node** source, std::size_t arrayCap, unsigned int threadCount);
+
+    // copyBuckets() copies the elements in buckets first through last - 1
+    // of the source into the target, creating their nodes in the given pool
+    // if the set uses one
+    void copyBuckets(
+        Node** target, Node** source, std::size_t first, std::size_t last,
+        NodePool<Node>& nodePool);
+
+    // copyOldHashArray() copies the old array of a HashSet that is growing
+    // incrementally, if it is, using the given number of threads
+    void copyOldHashArray(const HashSet& s, unsigned int threadCount);
+
+    // rehash() moves every node into a new array with the given capacity,
+    // relinking the existing nodes rather than copying their elements,
+    // in parallel if the set is large enough (using the given number of
+    // threads or, if it's zero, one per hardware thread)
+    void rehash(std::size_t newCap, unsigned int threadCount = 0);
+
+    // reserveUsing() is reserve(), rehashing with the given number of threads
+    void reserveUsing(std::size_t n, unsigned int threadCount);
+
+    // startMigration() allocates a new array with the given capacity and
+    // keeps the current one as the old array to be migrated from
+    void startMigration(std::size_t newCap);
+
+    // migrateBuckets() relinks the nodes in up to "count" of the old
+    // array's buckets into the current one, releasing the old array once
+    // every bucket has been migrated
+    void migrateBuckets(std::size_t count);
+
+    // containsHashed() is contains() for an element (or a key that compares
+    // equal to one) whose hash value has already been computed
+    template <typename Key>
+    bool containsHashed(const Key& element, std::size_t hashValue) const;
+
+    // hashKey() hashes a key, calling the hash function on it directly if
+    // it can, or on an element made from it otherwise
+    template <typename Key>
+    std::size_t hashKey(const Key& key) const;
+
+    // countOldAtIndex() returns the number of not-yet-migrated elements
+    // (or, if element is non-null, whether that element is among them)
+    // that will move to the given index of the current array
+    std::size_t countOldAtIndex(std::size_t index, const ElementType* element) const;
+
+    // bucketContains() searches one bucket of an array (using its tree, if
+    // it has one) for an element with the given hash value, moving the
+    // node it finds in a chain to the front if the set is self-organizing,
+    // and adding the number of nodes it visits to the given count
+    template <typename Key>
+    bool bucketContains(
+        Node** array, TreeNode** arrayTrees, std::size_t index,
+        const Key& element, std::size_t hashValue,
+        unsigned long long& visited) const;
+
+    // parallelRehash() is rehash() split across the given number of
+    // threads, each relinking the nodes bound for one range of buckets
+    void parallelRehash(std::size_t newCap, unsigned int threadCount);
+
+    // threadsToUse() returns how many threads to use for a job of the given
+    // size, given the number asked for (or zero for one per hardware thread)
+    static unsigned int threadsToUse(unsigned int threadCount, unsigned long long work) noexcept;
+
+    // firstBucketOf() returns the first bucket in the range handled by the
+    // given thread (or, for thread == threadCount, the capacity), and
+    // threadOf() returns the thread whose range includes a given bucket
+    static std::size_t firstBucketOf(
+        unsigned int thread, unsigned int threadCount, std::size_t arrayCap) noexcept;
+    static unsigned int threadOf(
+        std::size_t index, unsigned int threadCount, std::size_t arrayCap) noexcept;
+
+    // allocateTreesIfOrdered() allocates an empty array of tree roots, if
+    // elements can be ordered and none exists, so that threads linking
+    // nodes into different buckets never race to allocate one;
+    // releaseTreesIfUnused() releases it again if no bucket was treeified
+    void allocateTreesIfOrdered(TreeNode**& arrayTrees, std::size_t arrayCap);
+    static void releaseTreesIfUnused(TreeNode**& arrayTrees, std::size_t arrayCap) noexcept;
+
+    // linkNode() pushes a node onto the front of its bucket in the current
+    // array, adding it to the bucket's tree, or treeifying the bucket if
+    // its chain has become long enough
+    void linkNode(Node* node);
+
+    // treeifyLongBuckets() builds trees for every bucket of an array whose
+    // chain is long enough, releasing any trees it already had
+    static void treeifyLongBuckets(
+        Node** array, std::size_t arrayCap, TreeNode**& arrayTrees);
+
+    // treeify() builds a tree over every node in a bucket's chain
+    static TreeNode* treeify(Node* chain);
+
+    // chainIsLong() returns true if a chain has at least TREEIFY_THRESHOLD
+    // nodes
+    static bool chainIsLong(Node* chain) noexcept;
+
+    // treeInsert() recursively inserts a node into a tree, rebalancing it
+    // on the way back up, and returns the tree's new root
+    static TreeNode* treeInsert(TreeNode* root, Node* node);
+
+    // treeHeight() returns the height of a tree (-1 if it's empty);
+    // rotateLeft() and rotateRight() rotate a tree, returning its new root
+    static int treeHeight(TreeNode* root) noexcept;
+    static TreeNode* rotateLeft(TreeNode* root) noexcept;
+    static TreeNode* rotateRight(TreeNode* root) noexcept;
+
+    // destroyTrees() releases the trees of an array with the given
+    // capacity, along with the array of their roots
+    static void destroyTrees(TreeNode**& arrayTrees, std::size_t arrayCap) noexcept;
+    static void destroyTree(TreeNode* root) noexcept;
+
+    // nodeLess() returns true if the first element (with the given hash
+    // value) comes before the second in a tree's order
+    template <typename A, typename B>
+    static bool nodeLess(
+        std::size_t hashA, const A& a, std::size_t hashB, const B& b);
 };
 
 
 
-namespace impl_
-{
-    template <typename ElementType>
-    unsigned int HashSet__undefinedHashFunction(const ElementType& element)
-    {
-        return 0;
-    }
-}
-
-
-template <typename ElementType>
-HashSet<ElementType>::HashSet(HashFunction hashFunction)
+template <typename ElementType, typename Hash, typename RangePolicy>
+HashSet<ElementType, Hash, RangePolicy>::HashSet(
+    HashFunction hashFunction, bool growIncrementally, bool usePool,
+    bool selfOrganizing)
     : hashFunction{hashFunction}, sz{0}, cap{DEFAULT_CAPACITY},
-      hashArray{new Node*[DEFAULT_CAPACITY]}
+      hashArray{new Node*[DEFAULT_CAPACITY]}, trees{nullptr},
+      growIncrementally{growIncrementally}, oldArray{nullptr}, oldTrees{nullptr},
+      oldCap{0}, migrated{0}, usePool{usePool}, selfOrganizing{selfOrganizing},
+      countVisits{false}, visitedCount{0}
 {
     // make all the cells in the hashTable (Array) point to NULL 
     // when initializing
-   for (unsigned int i = 0; i < cap; i++)
+   for (std::size_t i = 0; i < cap; i++)
    {
         hashArray[i] = nullptr;
    }
 }
 
 
-template <typename ElementType>
-void HashSet<ElementType>::deallocateHashTable() noexcept
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::deallocateHashTable() noexcept
 {
-    // deallocate all the Nodes in the hash Array
-    for (unsigned int i = 0; i < cap; i++)
+    releaseNodes(0);
+
+    destroyTrees(trees, cap);
+    destroyTrees(oldTrees, oldCap);
+    delete[] hashArray;
+    delete[] oldArray;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::releaseNodes(unsigned int threadCount) noexcept
+{
+    if (usePool)
     {
-        Node* current = hashArray[i];
+        // every node lives in the pool, so release them all at once
+        pool.clear();
+        std::fill(hashArray, hashArray + cap, nullptr);
+        if (oldArray != nullptr) std::fill(oldArray, oldArray + oldCap, nullptr);
+        return;
+    }
+
+    threadCount = threadsToUse(threadCount, sz);
+    if (threadCount > 1)
+    {
+        try
+        {
+            // each thread deletes the nodes in its range of buckets (and
+            // in its range of any buckets not yet migrated from the old
+            // array); nothing here can throw once the threads are running
+            impl_::runInParallel(
+                threadCount,
+                [&](unsigned int t)
+                {
+                    deleteChains(
+                        hashArray, firstBucketOf(t, threadCount, cap),
+                        firstBucketOf(t + 1, threadCount, cap));
+
+                    if (oldArray != nullptr)
+                    {
+                        deleteChains(
+                            oldArray, std::max(migrated, firstBucketOf(t, threadCount, oldCap)),
+                            std::max(migrated, firstBucketOf(t + 1, threadCount, oldCap)));
+                    }
+                });
+        }
+        catch (...)
+        {
+            // the threads couldn't be set up, so whatever buckets weren't
+            // emptied are emptied below instead
+        }
+    }
+
+    deleteChains(hashArray, 0, cap);
+    if (oldArray != nullptr) deleteChains(oldArray, migrated, oldCap);
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::deleteChains(
+    Node** array, std::size_t first, std::size_t last) noexcept
+{
+    for (std::size_t i = first; i < last; i++)
+    {
+        Node* current = array[i];
         while (current != nullptr)
         {
             Node* temp = current->next;
             delete current;
             current = temp;
         }
+        array[i] = nullptr;
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::clear(unsigned int threadCount)
+{
+    releaseNodes(threadCount);
+
+    // the old array's buckets are all empty now, so it's no longer needed
+    destroyTrees(trees, cap);
+    destroyTrees(oldTrees, oldCap);
+    delete[] oldArray;
+    oldArray = nullptr;
+    oldCap = 0;
+    migrated = 0;
+    sz = 0;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+typename HashSet<ElementType, Hash, RangePolicy>::Node* HashSet<ElementType, Hash, RangePolicy>::makeNode(
+    const ElementType& value, std::size_t hashValue, Node* next)
+{
+    if (usePool)
+    {
+        return pool.create(value, hashValue, next);
+    }
+    else
+    {
+        return new Node{value, hashValue, next};
     }
-    delete[] hashArray;    
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>::~HashSet() noexcept
+template <typename ElementType, typename Hash, typename RangePolicy>
+HashSet<ElementType, Hash, RangePolicy>::~HashSet() noexcept
 {
     deallocateHashTable();
 }
 
 
-template <typename ElementType>
-void HashSet<ElementType>::copyHashArray(Node** target, Node** source, unsigned int cap)
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::copyHashArray(
+    Node** target, Node** source, std::size_t arrayCap, unsigned int threadCount)
 {
-    for (unsigned int i = 0; i < cap; i++)
+    if (threadCount <= 1)
+    {
+        copyBuckets(target, source, 0, arrayCap, pool);
+        return;
+    }
+
+    // each thread copies its own range of buckets, creating nodes in a
+    // pool of its own if the set uses a pool; the pools are merged into
+    // the set's afterward, even if a thread failed, so that every node
+    // that was created can be released
+    std::vector<NodePool<Node>> pools(threadCount);
+
+    try
+    {
+        impl_::runInParallel(
+            threadCount,
+            [&](unsigned int t)
+            {
+                copyBuckets(
+                    target, source, firstBucketOf(t, threadCount, arrayCap),
+                    firstBucketOf(t + 1, threadCount, arrayCap), pools[t]);
+            });
+    }
+    catch (...)
+    {
+        for (NodePool<Node>& threadPool : pools) pool.merge(std::move(threadPool));
+        throw;
+    }
+
+    for (NodePool<Node>& threadPool : pools) pool.merge(std::move(threadPool));
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::copyBuckets(
+    Node** target, Node** source, std::size_t first, std::size_t last,
+    NodePool<Node>& nodePool)
+{
+    for (std::size_t i = first; i < last; i++)
     {
         Node* current = source[i];
         while (current != nullptr)
         {
             Node* after = target[i];
-            target[i] = new Node{current->value, after};
+            target[i] = usePool
+                ? nodePool.create(current->value, current->hashValue, after)
+                : new Node{current->value, current->hashValue, after};
             current = current->next;
         }
     }
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>::HashSet(const HashSet& s)
-    : hashFunction{impl_::HashSet__undefinedHashFunction<ElementType>},
-    sz{0}, cap{DEFAULT_CAPACITY}, hashArray{new Node*[DEFAULT_CAPACITY]}
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::copyOldHashArray(
+    const HashSet& s, unsigned int threadCount)
 {
-    for (unsigned int i = 0; i < cap; i++)
+    if (s.oldArray == nullptr) return;
+
+    oldArray = new Node*[s.oldCap];
+    std::fill(oldArray, oldArray + s.oldCap, nullptr);
+
+    // buckets before s.migrated are empty, so this copies only the rest
+    copyHashArray(oldArray, s.oldArray, s.oldCap, threadCount);
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+HashSet<ElementType, Hash, RangePolicy>::HashSet(const HashSet& s)
+    : HashSet{s, 0}
+{
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+HashSet<ElementType, Hash, RangePolicy>::HashSet(const HashSet& s, unsigned int threadCount)
+    : hashFunction{s.hashFunction},
+    sz{s.sz}, cap{s.cap}, hashArray{new Node*[s.cap]}, trees{nullptr},
+    growIncrementally{s.growIncrementally}, oldArray{nullptr}, oldTrees{nullptr},
+    oldCap{s.oldCap}, migrated{s.migrated}, usePool{s.usePool},
+    selfOrganizing{s.selfOrganizing}, countVisits{s.countVisits},
+    visitedCount{s.visitedCount}
+{
+    for (std::size_t i = 0; i < cap; i++)
     {
         hashArray[i] = nullptr;
     }
 
-    unsigned int tempCap = s.cap;
-    Node** tempArray = new Node*[tempCap];
-    for (unsigned int i = 0; i < tempCap; i++)
+    threadCount = threadsToUse(threadCount, s.sz);
+
+    try
     {
-        tempArray[i] = nullptr;
-    }
-    
-    copyHashArray(tempArray, s.hashArray, s.cap);
+        copyHashArray(hashArray, s.hashArray, s.cap, threadCount);
+        copyOldHashArray(s, threadCount);
 
-    deallocateHashTable();
-    hashArray = tempArray;
-    hashFunction = s.hashFunction;
-    sz = s.sz;
-    cap = s.cap;
+        if (s.trees != nullptr)
+        {
+            treeifyLongBuckets(hashArray, cap, trees);
+        }
+        if (s.oldTrees != nullptr)
+        {
+            treeifyLongBuckets(oldArray, oldCap, oldTrees);
+        }
+    }
+    catch (...)
+    {
+        // every node copied so far is linked into a bucket (or the pool)
+        deallocateHashTable();
+        throw;
+    }
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>::HashSet(HashSet&& s) noexcept
-    : hashFunction{impl_::HashSet__undefinedHashFunction<ElementType>},
-    sz{0}, cap{DEFAULT_CAPACITY}, hashArray{new Node*[DEFAULT_CAPACITY]}
+template <typename ElementType, typename Hash, typename RangePolicy>
+HashSet<ElementType, Hash, RangePolicy>::HashSet(HashSet&& s) noexcept
+    : hashFunction{s.hashFunction},
+    sz{0}, cap{DEFAULT_CAPACITY}, hashArray{new Node*[DEFAULT_CAPACITY]},
+    trees{nullptr}, growIncrementally{false}, oldArray{nullptr}, oldTrees{nullptr},
+    oldCap{0}, migrated{0}, usePool{false}, selfOrganizing{false},
+    countVisits{false}, visitedCount{0}
 {
-    for (unsigned int i = 0; i < cap; i++)
+    for (std::size_t i = 0; i < cap; i++)
     {
         hashArray[i] = nullptr;
     }
@@ -234,134 +725,591 @@ HashSet<ElementType>::HashSet(HashSet&& s) noexcept
     std::swap(cap, s.cap);
     std::swap(hashFunction, s.hashFunction);
     std::swap(hashArray, s.hashArray);
+    std::swap(trees, s.trees);
+    std::swap(growIncrementally, s.growIncrementally);
+    std::swap(oldArray, s.oldArray);
+    std::swap(oldTrees, s.oldTrees);
+    std::swap(oldCap, s.oldCap);
+    std::swap(migrated, s.migrated);
+    std::swap(usePool, s.usePool);
+    std::swap(pool, s.pool);
+    std::swap(selfOrganizing, s.selfOrganizing);
+    std::swap(countVisits, s.countVisits);
+    std::swap(visitedCount, s.visitedCount);
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>& HashSet<ElementType>::operator=(const HashSet& s)
+template <typename ElementType, typename Hash, typename RangePolicy>
+HashSet<ElementType, Hash, RangePolicy>& HashSet<ElementType, Hash, RangePolicy>::operator=(const HashSet& s)
 {
     if (this != &s)
     {
-        unsigned int tempCap = s.cap;
-        Node** tempArray = new Node*[tempCap];
-        for (unsigned int i = 0; i < tempCap; i++)
-        {
-            tempArray[i] = nullptr;
-        }
-        
-        copyHashArray(tempArray, s.hashArray, s.cap);
-
-        deallocateHashTable();
-        hashArray = tempArray;
-        hashFunction = s.hashFunction;
-        sz = s.sz;
-        cap = s.cap;
+        // copy into a separate HashSet (and, so, a separate pool) first,
+        // so the old nodes can all be released together afterward
+        HashSet copy{s};
+        *this = std::move(copy);
     }
     return *this;
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>& HashSet<ElementType>::operator=(HashSet&& s) noexcept
+template <typename ElementType, typename Hash, typename RangePolicy>
+HashSet<ElementType, Hash, RangePolicy>& HashSet<ElementType, Hash, RangePolicy>::operator=(HashSet&& s) noexcept
 {
     if (this != &s)
     {
         std::swap(sz, s.sz);
         std::swap(cap, s.cap);
         std::swap(hashArray, s.hashArray);
+        std::swap(trees, s.trees);
         std::swap(hashFunction, s.hashFunction);
+        std::swap(growIncrementally, s.growIncrementally);
+        std::swap(oldArray, s.oldArray);
+        std::swap(oldTrees, s.oldTrees);
+        std::swap(oldCap, s.oldCap);
+        std::swap(migrated, s.migrated);
+        std::swap(usePool, s.usePool);
+        std::swap(pool, s.pool);
+        std::swap(selfOrganizing, s.selfOrganizing);
+        std::swap(countVisits, s.countVisits);
+        std::swap(visitedCount, s.visitedCount);
     }
     return *this;
 }
 
 
-template <typename ElementType>
-bool HashSet<ElementType>::isImplemented() const noexcept
+template <typename ElementType, typename Hash, typename RangePolicy>
+bool HashSet<ElementType, Hash, RangePolicy>::isImplemented() const noexcept
 {
     return true;
 }
 
 
-template <typename ElementType>
-void HashSet<ElementType>::add(const ElementType& element)
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::add(const ElementType& element)
 {
-   if (!contains(element))
+   std::size_t hashValue = hashFunction(element);
+   if (!containsHashed(element, hashValue))
    {
-        unsigned int hashValue = hashFunction(element);
-        unsigned int index = hashValue % cap;
-        Node* after = hashArray[index];
-        hashArray[index] = new Node{element, after};
+        linkNode(makeNode(element, hashValue, nullptr));
         sz++;
         if (static_cast<float>(sz)/cap > 0.8)
         {
-            unsigned int newCap = cap * 2 + 1;
-            Node** tempArray = new Node*[newCap];
-            for (unsigned int i = 0; i < newCap; i++)
+            if (growIncrementally)
             {
-                tempArray[i] = nullptr;
+                startMigration(RangePolicy::nextCapacity(cap));
             }
-            
-            // rehash into a temporary array
-            for (unsigned int i = 0; i < cap; i++)
+            else
             {
-                Node* current = hashArray[i];
-                while (current != nullptr)
+                rehash(RangePolicy::nextCapacity(cap));
+            }
+        }
+        else if (oldArray != nullptr)
+        {
+            migrateBuckets(MIGRATION_STEP);
+        }
+   }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::rehash(std::size_t newCap, unsigned int threadCount)
+{
+    if (oldArray != nullptr)
+    {
+        migrateBuckets(oldCap);
+    }
+
+    threadCount = threadsToUse(threadCount, sz);
+    if (threadCount > 1)
+    {
+        parallelRehash(newCap, threadCount);
+        return;
+    }
+
+    Node** tempArray = new Node*[newCap];
+    for (std::size_t i = 0; i < newCap; i++)
+    {
+        tempArray[i] = nullptr;
+    }
+
+    // unlink each node from its old bucket and push it onto the front
+    // of its new one; no element is copied and no node is reallocated
+    for (std::size_t i = 0; i < cap; i++)
+    {
+        Node* current = hashArray[i];
+        while (current != nullptr)
+        {
+            Node* next = current->next;
+            std::size_t newIndex = RangePolicy::index(current->hashValue, newCap);
+            current->next = tempArray[newIndex];
+            tempArray[newIndex] = current;
+            current = next;
+        }
+    }
+
+    destroyTrees(trees, cap);
+    delete[] hashArray;
+    hashArray = tempArray;
+    cap = newCap;
+
+    treeifyLongBuckets(hashArray, cap, trees);
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::parallelRehash(
+    std::size_t newCap, unsigned int threadCount)
+{
+    // each thread sorts the nodes in its range of old buckets by the thread
+    // whose range of new buckets they're bound for; lists[from * threadCount
+    // + to] holds the nodes sorted by thread "from" for thread "to"
+    std::vector<std::vector<Node*>> lists(threadCount * threadCount);
+
+    impl_::runInParallel(
+        threadCount,
+        [&](unsigned int from)
+        {
+            std::size_t last = firstBucketOf(from + 1, threadCount, cap);
+            for (std::size_t i = firstBucketOf(from, threadCount, cap); i < last; i++)
+            {
+                for (Node* current = hashArray[i]; current != nullptr; current = current->next)
                 {
-                    unsigned int newIndex = hashFunction(current->value) 
-                        % newCap;
-                    Node* after = tempArray[newIndex];
-                    tempArray[newIndex] = new Node{current->value, after};
-                    current = current->next;
+                    std::size_t newIndex = RangePolicy::index(current->hashValue, newCap);
+                    lists[from * threadCount + threadOf(newIndex, threadCount, newCap)]
+                        .push_back(current);
                 }
             }
+        });
+
+    Node** tempArray = new Node*[newCap];
+    std::fill(tempArray, tempArray + newCap, nullptr);
+
+    // then each thread relinks the nodes bound for its range of buckets;
+    // nothing here can throw, so the nodes are never left half-moved
+    impl_::runInParallel(
+        threadCount,
+        [&](unsigned int to)
+        {
+            for (unsigned int from = 0; from < threadCount; from++)
+            {
+                for (Node* node : lists[from * threadCount + to])
+                {
+                    std::size_t newIndex = RangePolicy::index(node->hashValue, newCap);
+                    node->next = tempArray[newIndex];
+                    tempArray[newIndex] = node;
+                }
+            }
+        });
+
+    destroyTrees(trees, cap);
+    delete[] hashArray;
+    hashArray = tempArray;
+    cap = newCap;
+
+    // finally, each thread treeifies the long chains in its range
+    allocateTreesIfOrdered(trees, cap);
+    if (trees != nullptr)
+    {
+        try
+        {
+            impl_::runInParallel(
+                threadCount,
+                [&](unsigned int to)
+                {
+                    std::size_t last = firstBucketOf(to + 1, threadCount, cap);
+                    for (std::size_t i = firstBucketOf(to, threadCount, cap); i < last; i++)
+                    {
+                        if (chainIsLong(hashArray[i]))
+                        {
+                            trees[i] = treeify(hashArray[i]);
+                        }
+                    }
+                });
+        }
+        catch (...)
+        {
+            destroyTrees(trees, cap);
+            throw;
+        }
+
+        releaseTreesIfUnused(trees, cap);
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::addAll(const std::vector<ElementType>& elements)
+{
+    addAll(elements, 0);
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::addAll(
+    const std::vector<ElementType>& elements, unsigned int threadCount)
+{
+    reserveUsing(sz + elements.size(), threadCount);
+
+    threadCount = threadsToUse(threadCount, elements.size());
+    if (threadCount <= 1)
+    {
+        for (const ElementType& element : elements)
+        {
+            add(element);
+        }
+        return;
+    }
+
+    // each thread hashes a slice of the elements, sorting their positions
+    // by the thread whose range of buckets they belong in, the same way
+    // parallelRehash() sorts nodes
+    std::vector<std::size_t> hashValues(elements.size());
+    std::vector<std::vector<std::size_t>> lists(threadCount * threadCount);
+
+    impl_::runInParallel(
+        threadCount,
+        [&](unsigned int from)
+        {
+            std::size_t first = static_cast<unsigned long long>(elements.size()) * from / threadCount;
+            std::size_t last = static_cast<unsigned long long>(elements.size()) * (from + 1) / threadCount;
+            for (std::size_t i = first; i < last; i++)
+            {
+                hashValues[i] = hashFunction(elements[i]);
+                std::size_t index = RangePolicy::index(hashValues[i], cap);
+                lists[from * threadCount + threadOf(index, threadCount, cap)].push_back(i);
+            }
+        });
+
+    // then each thread adds the elements belonging in its range of buckets,
+    // creating their nodes in a pool of its own if the set uses a pool
+    std::vector<NodePool<Node>> pools(threadCount);
+    std::vector<std::size_t> added(threadCount, 0);
+    std::vector<unsigned long long> visited(threadCount, 0);
 
-            deallocateHashTable();
-            hashArray = tempArray;
-            cap = newCap;
+    allocateTreesIfOrdered(trees, cap);
+
+    auto finish = [&]()
+    {
+        for (unsigned int t = 0; t < threadCount; t++)
+        {
+            pool.merge(std::move(pools[t]));
+            sz += added[t];
+            visitedCount += visited[t];
         }
-   }
+        releaseTreesIfUnused(trees, cap);
+    };
+
+    try
+    {
+        impl_::runInParallel(
+            threadCount,
+            [&](unsigned int to)
+            {
+                for (unsigned int from = 0; from < threadCount; from++)
+                {
+                    for (std::size_t i : lists[from * threadCount + to])
+                    {
+                        std::size_t hashValue = hashValues[i];
+                        std::size_t index = RangePolicy::index(hashValue, cap);
+                        if (!bucketContains(hashArray, trees, index, elements[i], hashValue, visited[to]))
+                        {
+                            Node* node = usePool
+                                ? pools[to].create(elements[i], hashValue, nullptr)
+                                : new Node{elements[i], hashValue, nullptr};
+                            linkNode(node);
+                            added[to]++;
+                        }
+                    }
+                }
+            });
+    }
+    catch (...)
+    {
+        finish();
+        throw;
+    }
+
+    finish();
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+unsigned int HashSet<ElementType, Hash, RangePolicy>::threadsToUse(
+    unsigned int threadCount, unsigned long long work) noexcept
+{
+    return impl_::threadsToUse(threadCount, work, PARALLEL_THRESHOLD);
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+std::size_t HashSet<ElementType, Hash, RangePolicy>::firstBucketOf(
+    unsigned int thread, unsigned int threadCount, std::size_t arrayCap) noexcept
+{
+    // thread t handles the buckets i for which threadOf(i) == t, which
+    // begin at the smallest i with i * threadCount >= t * arrayCap
+    return static_cast<std::size_t>(
+        (static_cast<unsigned long long>(thread) * arrayCap + threadCount - 1) / threadCount);
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+unsigned int HashSet<ElementType, Hash, RangePolicy>::threadOf(
+    std::size_t index, unsigned int threadCount, std::size_t arrayCap) noexcept
+{
+    return static_cast<unsigned int>(
+        static_cast<unsigned long long>(index) * threadCount / arrayCap);
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::allocateTreesIfOrdered(
+    TreeNode**& arrayTrees, std::size_t arrayCap)
+{
+    if constexpr (impl_::HashSet__isOrdered<ElementType>::value)
+    {
+        if (arrayTrees == nullptr)
+        {
+            arrayTrees = new TreeNode*[arrayCap];
+            std::fill(arrayTrees, arrayTrees + arrayCap, nullptr);
+        }
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::releaseTreesIfUnused(
+    TreeNode**& arrayTrees, std::size_t arrayCap) noexcept
+{
+    if (arrayTrees != nullptr
+        && std::all_of(arrayTrees, arrayTrees + arrayCap, [](TreeNode* root) { return root == nullptr; }))
+    {
+        delete[] arrayTrees;
+        arrayTrees = nullptr;
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::startMigration(std::size_t newCap)
+{
+    // a previous migration is normally long finished by now, but make sure
+    if (oldArray != nullptr)
+    {
+        migrateBuckets(oldCap);
+    }
+
+    Node** tempArray = new Node*[newCap];
+    for (std::size_t i = 0; i < newCap; i++)
+    {
+        tempArray[i] = nullptr;
+    }
+
+    oldArray = hashArray;
+    oldTrees = trees;
+    oldCap = cap;
+    migrated = 0;
+    hashArray = tempArray;
+    trees = nullptr;
+    cap = newCap;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::migrateBuckets(std::size_t count)
+{
+    for (; count > 0 && migrated < oldCap; count--, migrated++)
+    {
+        if (oldTrees != nullptr)
+        {
+            destroyTree(oldTrees[migrated]);
+            oldTrees[migrated] = nullptr;
+        }
+
+        Node* current = oldArray[migrated];
+        while (current != nullptr)
+        {
+            Node* next = current->next;
+            linkNode(current);
+            current = next;
+        }
+        oldArray[migrated] = nullptr;
+    }
+
+    if (migrated == oldCap)
+    {
+        destroyTrees(oldTrees, oldCap);
+        delete[] oldArray;
+        oldArray = nullptr;
+        oldCap = 0;
+        migrated = 0;
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::reserve(std::size_t n)
+{
+    reserveUsing(n, 0);
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::reserveUsing(std::size_t n, unsigned int threadCount)
+{
+    if (oldArray != nullptr)
+    {
+        migrateBuckets(oldCap);
+    }
+
+    std::size_t newCap = cap;
+    while (static_cast<float>(n)/newCap > 0.8)
+    {
+        newCap = RangePolicy::nextCapacity(newCap);
+    }
+
+    if (newCap != cap)
+    {
+        rehash(newCap, threadCount);
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+bool HashSet<ElementType, Hash, RangePolicy>::contains(const ElementType& element) const
+{
+    return containsHashed(element, hashFunction(element));
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+bool HashSet<ElementType, Hash, RangePolicy>::contains(SetKeyType<ElementType> key) const
+{
+    const auto& element = impl_::SetKey<ElementType>::get(key);
+    return containsHashed(element, hashKey(element));
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+template <typename Key>
+std::size_t HashSet<ElementType, Hash, RangePolicy>::hashKey(const Key& key) const
+{
+    if constexpr (std::is_invocable_r_v<std::size_t, const Hash&, const Key&>)
+    {
+        return hashFunction(key);
+    }
+    else
+    {
+        return hashFunction(ElementType{key});
+    }
 }
 
 
-template <typename ElementType>
-bool HashSet<ElementType>::contains(const ElementType& element) const
+template <typename ElementType, typename Hash, typename RangePolicy>
+template <typename Key>
+bool HashSet<ElementType, Hash, RangePolicy>::containsHashed(
+    const Key& element, std::size_t hashValue) const
 {
-    unsigned int hashValue = hashFunction(element);
-    unsigned int index = hashValue % cap;
-    Node* searchBucket = hashArray[index];
-    while (searchBucket != nullptr)
+    std::size_t index = RangePolicy::index(hashValue, cap);
+    if (bucketContains(hashArray, trees, index, element, hashValue, visitedCount))
     {
-        if (searchBucket->value == element) return true;
-        searchBucket = searchBucket->next;
+        return true;
+    }
+
+    // the element may not have been migrated out of the old array yet
+    if (oldArray != nullptr)
+    {
+        std::size_t oldIndex = RangePolicy::index(hashValue, oldCap);
+        if (oldIndex >= migrated)
+        {
+            return bucketContains(
+                oldArray, oldTrees, oldIndex, element, hashValue, visitedCount);
+        }
     }
     return false;
 }
 
 
-template <typename ElementType>
-unsigned int HashSet<ElementType>::size() const noexcept
+template <typename ElementType, typename Hash, typename RangePolicy>
+template <typename Key>
+bool HashSet<ElementType, Hash, RangePolicy>::bucketContains(
+    Node** array, TreeNode** arrayTrees, std::size_t index,
+    const Key& element, std::size_t hashValue,
+    unsigned long long& visitedCount) const
+{
+    unsigned int visited = 0;
+
+    if (arrayTrees != nullptr && arrayTrees[index] != nullptr)
+    {
+        TreeNode* current = arrayTrees[index];
+        while (current != nullptr)
+        {
+            visited++;
+            Node* node = current->node;
+            if (nodeLess(hashValue, element, node->hashValue, node->value))
+            {
+                current = current->left;
+            }
+            else if (nodeLess(node->hashValue, node->value, hashValue, element))
+            {
+                current = current->right;
+            }
+            else
+            {
+                if (countVisits) visitedCount += visited;
+                return true;
+            }
+        }
+        if (countVisits) visitedCount += visited;
+        return false;
+    }
+
+    Node* previous = nullptr;
+    for (Node* current = array[index]; current != nullptr; current = current->next)
+    {
+        visited++;
+        if (current->hashValue == hashValue && current->value == element)
+        {
+            if (selfOrganizing && previous != nullptr)
+            {
+                previous->next = current->next;
+                current->next = array[index];
+                array[index] = current;
+            }
+            if (countVisits) visitedCount += visited;
+            return true;
+        }
+        previous = current;
+    }
+    if (countVisits) visitedCount += visited;
+    return false;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+std::size_t HashSet<ElementType, Hash, RangePolicy>::size() const noexcept
 {
     return sz;
 }
 
 
-template <typename ElementType>
-unsigned int HashSet<ElementType>::elementsAtIndex(unsigned int index) const
+template <typename ElementType, typename Hash, typename RangePolicy>
+std::size_t HashSet<ElementType, Hash, RangePolicy>::elementsAtIndex(std::size_t index) const
 {
     if (index >= cap) return 0;
     Node* current = hashArray[index];
-    unsigned int count = 0;
+    std::size_t count = 0;
     while (current != nullptr)
     {
         count++;
         current = current->next;
     }
-    return count;
+    return count + countOldAtIndex(index, nullptr);
 }
 
 
-template <typename ElementType>
-bool HashSet<ElementType>::isElementAtIndex(const ElementType& element, unsigned int index) const
+template <typename ElementType, typename Hash, typename RangePolicy>
+bool HashSet<ElementType, Hash, RangePolicy>::isElementAtIndex(const ElementType& element, std::size_t index) const
 {
     if (index >= cap) return false;
     Node* current = hashArray[index];
@@ -370,10 +1318,248 @@ bool HashSet<ElementType>::isElementAtIndex(const ElementType& element, unsigned
         if (current->value == element) return true;
         current = current->next;
     }
+    return countOldAtIndex(index, &element) > 0;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+std::size_t HashSet<ElementType, Hash, RangePolicy>::countOldAtIndex(
+    std::size_t index, const ElementType* element) const
+{
+    std::size_t count = 0;
+    if (oldArray != nullptr)
+    {
+        for (std::size_t i = migrated; i < oldCap; i++)
+        {
+            for (Node* current = oldArray[i]; current != nullptr;
+                 current = current->next)
+            {
+                if ((element == nullptr || current->value == *element)
+                    && RangePolicy::index(current->hashValue, cap) == index)
+                {
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+NodePoolStats HashSet<ElementType, Hash, RangePolicy>::poolStats() const noexcept
+{
+    return pool.stats();
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::countNodesVisited(bool count) noexcept
+{
+    countVisits = count;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+unsigned long long HashSet<ElementType, Hash, RangePolicy>::nodesVisited() const noexcept
+{
+    return visitedCount;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::linkNode(Node* node)
+{
+    std::size_t index = RangePolicy::index(node->hashValue, cap);
+    node->next = hashArray[index];
+    hashArray[index] = node;
+
+    if (trees != nullptr && trees[index] != nullptr)
+    {
+        trees[index] = treeInsert(trees[index], node);
+    }
+    else if (chainIsLong(hashArray[index]))
+    {
+        if (trees == nullptr)
+        {
+            trees = new TreeNode*[cap];
+            std::fill(trees, trees + cap, nullptr);
+        }
+        trees[index] = treeify(hashArray[index]);
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::treeifyLongBuckets(
+    Node** array, std::size_t arrayCap, TreeNode**& arrayTrees)
+{
+    destroyTrees(arrayTrees, arrayCap);
+
+    for (std::size_t i = 0; i < arrayCap; i++)
+    {
+        if (chainIsLong(array[i]))
+        {
+            if (arrayTrees == nullptr)
+            {
+                arrayTrees = new TreeNode*[arrayCap];
+                std::fill(arrayTrees, arrayTrees + arrayCap, nullptr);
+            }
+            arrayTrees[i] = treeify(array[i]);
+        }
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+typename HashSet<ElementType, Hash, RangePolicy>::TreeNode*
+HashSet<ElementType, Hash, RangePolicy>::treeify(Node* chain)
+{
+    TreeNode* root = nullptr;
+    for (Node* current = chain; current != nullptr; current = current->next)
+    {
+        root = treeInsert(root, current);
+    }
+    return root;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+bool HashSet<ElementType, Hash, RangePolicy>::chainIsLong(Node* chain) noexcept
+{
+    if constexpr (impl_::HashSet__isOrdered<ElementType>::value)
+    {
+        unsigned int length = 0;
+        for (Node* current = chain; current != nullptr; current = current->next)
+        {
+            if (++length >= TREEIFY_THRESHOLD) return true;
+        }
+    }
     return false;
 }
 
 
+template <typename ElementType, typename Hash, typename RangePolicy>
+typename HashSet<ElementType, Hash, RangePolicy>::TreeNode*
+HashSet<ElementType, Hash, RangePolicy>::treeInsert(TreeNode* root, Node* node)
+{
+    if (root == nullptr)
+    {
+        return new TreeNode{node, nullptr, nullptr, 0};
+    }
+
+    if (nodeLess(node->hashValue, node->value, root->node->hashValue, root->node->value))
+    {
+        root->left = treeInsert(root->left, node);
+    }
+    else
+    {
+        root->right = treeInsert(root->right, node);
+    }
+
+    root->height = std::max(treeHeight(root->left), treeHeight(root->right)) + 1;
+    int balance = treeHeight(root->left) - treeHeight(root->right);
+
+    if (balance > 1)
+    {
+        if (treeHeight(root->left->left) < treeHeight(root->left->right))
+        {
+            root->left = rotateLeft(root->left);
+        }
+        return rotateRight(root);
+    }
+    else if (balance < -1)
+    {
+        if (treeHeight(root->right->right) < treeHeight(root->right->left))
+        {
+            root->right = rotateRight(root->right);
+        }
+        return rotateLeft(root);
+    }
+
+    return root;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+int HashSet<ElementType, Hash, RangePolicy>::treeHeight(TreeNode* root) noexcept
+{
+    return root == nullptr ? -1 : root->height;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+typename HashSet<ElementType, Hash, RangePolicy>::TreeNode*
+HashSet<ElementType, Hash, RangePolicy>::rotateLeft(TreeNode* root) noexcept
+{
+    TreeNode* newRoot = root->right;
+    root->right = newRoot->left;
+    newRoot->left = root;
+    root->height = std::max(treeHeight(root->left), treeHeight(root->right)) + 1;
+    newRoot->height = std::max(treeHeight(newRoot->left), treeHeight(newRoot->right)) + 1;
+    return newRoot;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+typename HashSet<ElementType, Hash, RangePolicy>::TreeNode*
+HashSet<ElementType, Hash, RangePolicy>::rotateRight(TreeNode* root) noexcept
+{
+    TreeNode* newRoot = root->left;
+    root->left = newRoot->right;
+    newRoot->right = root;
+    root->height = std::max(treeHeight(root->left), treeHeight(root->right)) + 1;
+    newRoot->height = std::max(treeHeight(newRoot->left), treeHeight(newRoot->right)) + 1;
+    return newRoot;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::destroyTrees(
+    TreeNode**& arrayTrees, std::size_t arrayCap) noexcept
+{
+    if (arrayTrees == nullptr) return;
+
+    for (std::size_t i = 0; i < arrayCap; i++)
+    {
+        destroyTree(arrayTrees[i]);
+    }
+
+    delete[] arrayTrees;
+    arrayTrees = nullptr;
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+void HashSet<ElementType, Hash, RangePolicy>::destroyTree(TreeNode* root) noexcept
+{
+    if (root != nullptr)
+    {
+        destroyTree(root->left);
+        destroyTree(root->right);
+        delete root;
+    }
+}
+
+
+template <typename ElementType, typename Hash, typename RangePolicy>
+template <typename A, typename B>
+bool HashSet<ElementType, Hash, RangePolicy>::nodeLess(
+    std::size_t hashA, const A& a, std::size_t hashB, const B& b)
+{
+    if (hashA != hashB) return hashA < hashB;
+
+    if constexpr (impl_::HashSet__isOrdered<ElementType>::value)
+    {
+        return a < b;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+
 
 #endif
 
@@ -0,0 +1,61 @@
+// KeyPrefix.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// The tree-based sets keep a "prefix" of each string alongside it: its
+// first 8 characters, packed into an unsigned 64-bit integer with the
+// first character in the high-order byte, so that comparing two prefixes
+// as integers orders them the same way as comparing the strings.  Most
+// comparisons between words are settled by their first few characters, so
+// most of them can be made without reading the strings at all; only when
+// two prefixes are the same do the strings themselves need comparing.
+
+#ifndef KEYPREFIX_HPP
+#define KEYPREFIX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+
+namespace impl_
+{
+    // KeyPrefix<ElementType>::enabled is true if sets of ElementType keep
+    // a prefix of each element, in which case of() returns the prefix of an
+    // element (or of a key that compares with the elements the same way).
+    template <typename ElementType>
+    struct KeyPrefix
+    {
+        static constexpr bool enabled = false;
+    };
+
+
+    template <>
+    struct KeyPrefix<std::string>
+    {
+        static constexpr bool enabled = true;
+
+        // Missing characters are zeroes, so if one string's prefix is less
+        // than another's, then so is the string.
+        static std::uint64_t of(std::string_view s) noexcept
+        {
+            std::uint64_t prefix = 0;
+            std::size_t length = std::min<std::size_t>(s.length(), 8);
+
+            for (std::size_t i = 0; i < length; i++)
+            {
+                prefix = (prefix << 8) | static_cast<unsigned char>(s[i]);
+            }
+
+            return (length == 0) ? 0 : prefix << (8 * (8 - length));
+        }
+    };
+}
+
+
+
+#endif
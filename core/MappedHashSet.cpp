@@ -0,0 +1,354 @@
+// MappedHashSet.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the MappedHashSet class.  Mapping files into memory
+// uses the POSIX mmap() facility.
+
+#include "MappedHashSet.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "StringHashing.hpp"
+
+
+
+namespace
+{
+    // The seed every index is written with.  It's stored in the header,
+    // so a later version could choose another without breaking old indexes.
+    constexpr std::uint64_t INDEX_SEED = 0;
+
+
+    // Each part of the index is made up of 32-bit numbers (or, for the
+    // words, bytes), so the offset of each part is a multiple of four, and
+    // reading the numbers never requires an unaligned access.
+    std::uint64_t partsSize(
+        std::uint64_t bucketCount, std::uint64_t entryCount, std::uint64_t wordBytes)
+    {
+        return sizeof(std::uint32_t) * (bucketCount + 1)
+            + sizeof(std::uint32_t) * entryCount
+            + sizeof(std::uint32_t) * (entryCount + 1)
+            + wordBytes;
+    }
+
+
+    template <typename T>
+    void writeArray(std::ofstream& out, const std::vector<T>& values)
+    {
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+}
+
+
+
+MappedHashSet::IndexException::IndexException(const std::string& reason)
+    : reason_{reason}
+{
+}
+
+
+std::string MappedHashSet::IndexException::reason() const
+{
+    return reason_;
+}
+
+
+
+void MappedHashSet::write(const std::vector<std::string>& words, const std::string& path)
+{
+    if (words.size() >= std::numeric_limits<std::uint32_t>::max())
+    {
+        throw IndexException{"Too many words to index"};
+    }
+
+    std::uint32_t bucketCount = std::max<std::uint32_t>(1, words.size());
+
+    std::vector<std::uint64_t> hashValues(words.size());
+    std::vector<std::uint32_t> bucketStarts(bucketCount + 1, 0);
+
+    // count how many words land in each bucket, then turn the counts into
+    // the position at which each bucket begins (in a counting sort)
+    for (std::size_t i = 0; i < words.size(); i++)
+    {
+        hashValues[i] = hash(words[i], INDEX_SEED);
+        bucketStarts[bucketOf(hashValues[i], bucketCount) + 1]++;
+    }
+
+    for (std::uint32_t b = 0; b < bucketCount; b++)
+    {
+        bucketStarts[b + 1] += bucketStarts[b];
+    }
+
+    std::vector<std::uint32_t> order(words.size());
+    std::vector<std::uint32_t> next{bucketStarts.begin(), bucketStarts.end() - 1};
+
+    for (std::size_t i = 0; i < words.size(); i++)
+    {
+        order[next[bucketOf(hashValues[i], bucketCount)]++] = i;
+    }
+
+    // then lay out each bucket's words, leaving out any duplicates (which
+    // are necessarily in the same bucket), so buckets can only shrink
+    std::vector<std::uint32_t> tags;
+    std::vector<std::uint32_t> wordOffsets{0};
+    std::string packedWords;
+
+    std::uint32_t first = 0;
+    for (std::uint32_t b = 0; b < bucketCount; b++)
+    {
+        std::uint32_t last = bucketStarts[b + 1];
+        bucketStarts[b] = tags.size();
+
+        for (std::uint32_t i = first; i < last; i++)
+        {
+            const std::string& word = words[order[i]];
+            bool duplicate = false;
+
+            for (std::uint32_t e = bucketStarts[b]; e < tags.size() && !duplicate; e++)
+            {
+                duplicate = std::string_view{packedWords}.substr(
+                    wordOffsets[e], wordOffsets[e + 1] - wordOffsets[e]) == word;
+            }
+
+            if (!duplicate)
+            {
+                tags.push_back(static_cast<std::uint32_t>(hashValues[order[i]]));
+                packedWords += word;
+
+                if (packedWords.size() > std::numeric_limits<std::uint32_t>::max())
+                {
+                    throw IndexException{"Too many bytes of words to index"};
+                }
+
+                wordOffsets.push_back(packedWords.size());
+            }
+        }
+
+        first = last;
+    }
+
+    bucketStarts[bucketCount] = tags.size();
+
+    Header header{
+        MAGIC, VERSION, bucketCount, static_cast<std::uint32_t>(tags.size()), INDEX_SEED, 0};
+    header.fileSize = sizeof(Header) + partsSize(bucketCount, tags.size(), packedWords.size());
+
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    if (!out)
+    {
+        throw IndexException{"Cannot write index: " + path};
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    writeArray(out, bucketStarts);
+    writeArray(out, tags);
+    writeArray(out, wordOffsets);
+    out.write(packedWords.data(), packedWords.size());
+
+    out.close();
+    if (!out)
+    {
+        throw IndexException{"Cannot write index: " + path};
+    }
+}
+
+
+
+MappedHashSet::MappedHashSet()
+    : mapping{nullptr}, mappingSize{0}, header{nullptr}, bucketStarts{nullptr},
+      tags{nullptr}, wordOffsets{nullptr}, words{nullptr}
+{
+}
+
+
+MappedHashSet::MappedHashSet(const std::string& path)
+    : MappedHashSet{}
+{
+    open(path);
+}
+
+
+MappedHashSet::~MappedHashSet() noexcept
+{
+    close();
+}
+
+
+MappedHashSet::MappedHashSet(MappedHashSet&& s) noexcept
+    : MappedHashSet{}
+{
+    *this = std::move(s);
+}
+
+
+MappedHashSet& MappedHashSet::operator=(MappedHashSet&& s) noexcept
+{
+    if (this != &s)
+    {
+        std::swap(mapping, s.mapping);
+        std::swap(mappingSize, s.mappingSize);
+        std::swap(header, s.header);
+        std::swap(bucketStarts, s.bucketStarts);
+        std::swap(tags, s.tags);
+        std::swap(wordOffsets, s.wordOffsets);
+        std::swap(words, s.words);
+    }
+    return *this;
+}
+
+
+void MappedHashSet::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw IndexException{"Cannot open index: " + path};
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Header))
+    {
+        ::close(fd);
+        throw IndexException{"Not an index: " + path};
+    }
+
+    std::size_t size = status.st_size;
+    void* newMapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // the mapping keeps the file open, so the descriptor isn't needed
+    ::close(fd);
+
+    if (newMapping == MAP_FAILED)
+    {
+        throw IndexException{"Cannot map index: " + path};
+    }
+
+    const Header* newHeader = static_cast<const Header*>(newMapping);
+    const std::uint32_t* parts = reinterpret_cast<const std::uint32_t*>(newHeader + 1);
+    std::uint64_t bucketCount = newHeader->bucketCount;
+    std::uint64_t entryCount = newHeader->entryCount;
+
+    // the word offsets (and so the size of the words) can only be read
+    // once the buckets, tags, and offsets are known to fit
+    bool valid = newHeader->magic == MAGIC && newHeader->version == VERSION
+        && newHeader->fileSize == size && bucketCount > 0
+        && sizeof(Header) + partsSize(bucketCount, entryCount, 0) <= size;
+
+    if (valid)
+    {
+        const std::uint32_t* newWordOffsets = parts + (bucketCount + 1) + entryCount;
+        valid = parts[bucketCount] == entryCount && newWordOffsets[0] == 0
+            && sizeof(Header) + partsSize(bucketCount, entryCount, newWordOffsets[entryCount]) == size;
+    }
+
+    if (!valid)
+    {
+        ::munmap(newMapping, size);
+        throw IndexException{"Not an index: " + path};
+    }
+
+    close();
+
+    mapping = newMapping;
+    mappingSize = size;
+    header = newHeader;
+    bucketStarts = parts;
+    tags = bucketStarts + (bucketCount + 1);
+    wordOffsets = tags + entryCount;
+    words = reinterpret_cast<const char*>(wordOffsets + (entryCount + 1));
+}
+
+
+void MappedHashSet::close() noexcept
+{
+    if (mapping != nullptr)
+    {
+        ::munmap(mapping, mappingSize);
+    }
+
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    bucketStarts = nullptr;
+    tags = nullptr;
+    wordOffsets = nullptr;
+    words = nullptr;
+}
+
+
+bool MappedHashSet::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+void MappedHashSet::add(const std::string& element)
+{
+    if (!contains(element))
+    {
+        throw IndexException{"Cannot add to a read-only index: " + element};
+    }
+}
+
+
+bool MappedHashSet::contains(const std::string& element) const
+{
+    return contains(std::string_view{element});
+}
+
+
+bool MappedHashSet::contains(SetKeyType<std::string> key) const
+{
+    if (header == nullptr)
+    {
+        return false;
+    }
+
+    std::uint64_t hashValue = hash(key, header->seed);
+    std::uint32_t tag = static_cast<std::uint32_t>(hashValue);
+    std::uint32_t bucket = bucketOf(hashValue, header->bucketCount);
+
+    for (std::uint32_t e = bucketStarts[bucket]; e < bucketStarts[bucket + 1]; e++)
+    {
+        if (tags[e] == tag
+            && wordOffsets[e + 1] - wordOffsets[e] == key.length()
+            && std::memcmp(words + wordOffsets[e], key.data(), key.length()) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+std::size_t MappedHashSet::size() const noexcept
+{
+    return header == nullptr ? 0 : header->entryCount;
+}
+
+
+std::size_t MappedHashSet::byteCount() const noexcept
+{
+    return mappingSize;
+}
+
+
+std::uint64_t MappedHashSet::hash(std::string_view word, std::uint64_t seed) noexcept
+{
+    return HashStringSeeded{}(word, seed);
+}
+
+
+std::uint32_t MappedHashSet::bucketOf(std::uint64_t hashValue, std::uint32_t bucketCount) noexcept
+{
+    return static_cast<std::uint32_t>(((hashValue >> 32) * bucketCount) >> 32);
+}
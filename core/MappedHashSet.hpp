@@ -0,0 +1,159 @@
+// MappedHashSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A MappedHashSet is a read-only Set of strings whose contents live in an
+// "index" file, written ahead of time by MappedHashSet::write().  Opening
+// one maps the file into memory rather than reading it, so it takes about
+// the same (short) time no matter how many words the index holds, and
+// contains() looks words up directly in the mapping.  Since the mapping is
+// shared, any number of processes using the same index share one copy of
+// it in the operating system's page cache.
+//
+// The index is a hash table laid out so that it never needs to be
+// rebuilt:
+//
+// * A header, identifying the file and giving the sizes of what follows.
+// * The start of each bucket: one 32-bit entry number per bucket, plus one
+//   more marking the end of the last bucket.  A bucket's entries sit next
+//   to one another, so a bucket is just a range of entry numbers.
+// * One 32-bit "tag" per entry, taken from the low-order bits of the
+//   word's 64-bit hash value, so that most mismatches are rejected without
+//   looking at the words themselves.
+// * The offset of each entry's word, plus one more marking the end of the
+//   last word, so that word i spans offsets i through i + 1.
+// * The words, packed together with no separators.
+//
+// Which bucket a word belongs to is decided by the high-order bits of its
+// hash value.  The numbers are stored in the byte order of the machine
+// that wrote the index, so an index should be read on the same kind of
+// machine it was written on.
+//
+// add() only succeeds when the word is already in the set; adding any
+// other word throws an IndexException, as does failing to write or open
+// an index.  MappedHashSets can be moved, but not copied.
+
+#ifndef MAPPEDHASHSET_HPP
+#define MAPPEDHASHSET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Set.hpp"
+
+
+
+class MappedHashSet : public Set<std::string>
+{
+public:
+    // The first four bytes of every index ("IDX1" when read as text on a
+    // little-endian machine) and the version of the layout it uses.
+    static constexpr std::uint32_t MAGIC = 0x31584449;
+    static constexpr std::uint32_t VERSION = 1;
+
+
+    class IndexException
+    {
+    public:
+        IndexException(const std::string& reason);
+
+        std::string reason() const;
+
+    private:
+        std::string reason_;
+    };
+
+
+    // write() writes an index containing the given words (ignoring any
+    // duplicates) to the file at the given path, replacing it if it exists.
+    static void write(const std::vector<std::string>& words, const std::string& path);
+
+public:
+    // Initializes a MappedHashSet that has no index open, so it's empty.
+    MappedHashSet();
+
+    // Initializes a MappedHashSet by opening the index at the given path.
+    explicit MappedHashSet(const std::string& path);
+
+    // Unmaps the index, if one is open.
+    ~MappedHashSet() noexcept override;
+
+    MappedHashSet(const MappedHashSet& s) = delete;
+    MappedHashSet& operator=(const MappedHashSet& s) = delete;
+
+    MappedHashSet(MappedHashSet&& s) noexcept;
+    MappedHashSet& operator=(MappedHashSet&& s) noexcept;
+
+
+    // open() maps the index at the given path, replacing whatever index
+    // was open before.  It checks that the file is an index and that its
+    // parts fit within it, but it doesn't read the buckets or the words,
+    // so an index that's been altered since it was written can make
+    // contains() misbehave.
+    void open(const std::string& path);
+
+    // close() unmaps the index, if one is open, leaving the set empty.
+    void close() noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() has no effect if the word is already in the set.  Otherwise,
+    // since the set is read-only, it throws an IndexException.
+    void add(const std::string& element) override;
+
+
+    // contains() returns true if the given word is in the index, false
+    // otherwise.  It never allocates memory or modifies the set, so it
+    // can safely be called by many threads at once.
+    using Set<std::string>::contains;
+    bool contains(const std::string& element) const override;
+    bool contains(SetKeyType<std::string> key) const override;
+
+
+    // size() returns the number of words in the index.
+    std::size_t size() const noexcept override;
+
+
+    // byteCount() returns the size of the mapped index, in bytes.
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t bucketCount;
+        std::uint32_t entryCount;
+        std::uint64_t seed;
+        std::uint64_t fileSize;
+    };
+
+private:
+    void* mapping;
+    std::size_t mappingSize;
+
+    // Pointers into the mapping, pointing at each part of the index.
+    const Header* header;
+    const std::uint32_t* bucketStarts;
+    const std::uint32_t* tags;
+    const std::uint32_t* wordOffsets;
+    const char* words;
+
+private:
+    // hash() returns the 64-bit hash value of a word; existing indexes
+    // were laid out using it, so it must never change
+    static std::uint64_t hash(std::string_view word, std::uint64_t seed) noexcept;
+
+    // bucketOf() returns the bucket a hash value belongs in
+    static std::uint32_t bucketOf(std::uint64_t hashValue, std::uint32_t bucketCount) noexcept;
+};
+
+
+
+#endif
@@ -0,0 +1,253 @@
+// NodePool.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A NodePool is an arena that node-based data structures (such as HashSet
+// and AVLSet) can use in place of allocating each of their nodes with new.
+// Nodes are carved, in order, out of large "slabs" of contiguous storage,
+// so that nodes created one after another sit next to one another in
+// memory, and only one allocation is made per slab instead of per node.
+//
+// Nodes cannot be released individually; instead, clear() destroys every
+// node in the pool at once, walking each slab front to back and releasing
+// it with a single deallocation.  That fits our sets well, since they
+// never remove elements, and only ever free their nodes all together.
+//
+// Slabs start small, so that a pool used by a tiny set wastes little
+// memory, and double in size (up to a limit) as the pool grows.
+
+#ifndef NODEPOOL_HPP
+#define NODEPOOL_HPP
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+
+// NodePoolStats summarizes how much a NodePool has allocated.
+
+struct NodePoolStats
+{
+    // The number of nodes currently in the pool.
+    unsigned long long nodes;
+
+    // The number of slabs (i.e., allocations) the pool has made.
+    unsigned int slabs;
+
+    // The total size, in bytes, of those slabs.
+    unsigned long long bytes;
+};
+
+
+
+template <typename NodeType>
+class NodePool
+{
+public:
+    // The number of nodes in the first slab, and the most in any slab.
+    static constexpr unsigned int INITIAL_SLAB_SIZE = 16;
+    static constexpr unsigned int MAX_SLAB_SIZE = 65536;
+
+public:
+    // Initializes a NodePool to be empty; no slab is allocated until the
+    // first node is created.
+    NodePool() noexcept;
+
+    // Destroys every node in the pool and releases its slabs.
+    ~NodePool() noexcept;
+
+    // NodePools cannot be copied, since the nodes in them are linked to
+    // one another by pointers; only the structure using the pool knows
+    // how to copy them.
+    NodePool(const NodePool& p) = delete;
+    NodePool& operator=(const NodePool& p) = delete;
+
+    // Initializes a new NodePool that takes over the nodes of an expiring
+    // one, leaving it empty.
+    NodePool(NodePool&& p) noexcept;
+
+    // Exchanges the nodes of two NodePools.
+    NodePool& operator=(NodePool&& p) noexcept;
+
+
+    // create() constructs a new node in the pool from the given arguments
+    // (using brace initialization, so aggregates can be used as nodes),
+    // and returns a pointer to it.  The node lives until clear() is called
+    // or the pool is destroyed.
+    template <typename... Args>
+    NodeType* create(Args&&... args);
+
+
+    // clear() destroys every node in the pool and releases its slabs.
+    // This runs in time linear in the number of nodes (to run their
+    // destructors) but makes only one deallocation per slab.
+    void clear() noexcept;
+
+
+    // merge() takes over every node of another pool, leaving it empty.
+    // This lets several threads each create nodes in a pool of their own,
+    // with the nodes ending up in one pool afterward.
+    void merge(NodePool&& p) noexcept;
+
+
+    // stats() returns a summary of what the pool has allocated.
+    NodePoolStats stats() const noexcept;
+
+
+private:
+    struct Slab
+    {
+        Slab* next;
+        unsigned int used;
+        unsigned int capacity;
+        NodeType* nodes;
+    };
+
+private:
+    // The most recently allocated slab, from which nodes are created;
+    // each slab points to the one allocated before it.
+    Slab* current;
+    unsigned long long nodeCount;
+    unsigned int slabCount;
+    unsigned long long byteCount;
+
+private:
+    // addSlab() allocates a new slab, twice the size of the current one
+    // (up to MAX_SLAB_SIZE), and makes it current.
+    void addSlab();
+};
+
+
+
+template <typename NodeType>
+NodePool<NodeType>::NodePool() noexcept
+    : current{nullptr}, nodeCount{0}, slabCount{0}, byteCount{0}
+{
+}
+
+
+template <typename NodeType>
+NodePool<NodeType>::~NodePool() noexcept
+{
+    clear();
+}
+
+
+template <typename NodeType>
+NodePool<NodeType>::NodePool(NodePool&& p) noexcept
+    : current{nullptr}, nodeCount{0}, slabCount{0}, byteCount{0}
+{
+    std::swap(current, p.current);
+    std::swap(nodeCount, p.nodeCount);
+    std::swap(slabCount, p.slabCount);
+    std::swap(byteCount, p.byteCount);
+}
+
+
+template <typename NodeType>
+NodePool<NodeType>& NodePool<NodeType>::operator=(NodePool&& p) noexcept
+{
+    if (this != &p)
+    {
+        std::swap(current, p.current);
+        std::swap(nodeCount, p.nodeCount);
+        std::swap(slabCount, p.slabCount);
+        std::swap(byteCount, p.byteCount);
+    }
+    return *this;
+}
+
+
+template <typename NodeType>
+void NodePool<NodeType>::addSlab()
+{
+    unsigned int capacity = (current == nullptr)
+        ? INITIAL_SLAB_SIZE : std::min(current->capacity * 2, MAX_SLAB_SIZE);
+
+    NodeType* nodes = static_cast<NodeType*>(::operator new(sizeof(NodeType) * capacity));
+    current = new Slab{current, 0, capacity, nodes};
+    slabCount++;
+    byteCount += sizeof(NodeType) * capacity;
+}
+
+
+template <typename NodeType>
+template <typename... Args>
+NodeType* NodePool<NodeType>::create(Args&&... args)
+{
+    if (current == nullptr || current->used == current->capacity)
+    {
+        addSlab();
+    }
+
+    NodeType* node = new (current->nodes + current->used) NodeType{std::forward<Args>(args)...};
+    current->used++;
+    nodeCount++;
+    return node;
+}
+
+
+template <typename NodeType>
+void NodePool<NodeType>::clear() noexcept
+{
+    while (current != nullptr)
+    {
+        Slab* previous = current->next;
+
+        if constexpr (!std::is_trivially_destructible_v<NodeType>)
+        {
+            for (unsigned int i = 0; i < current->used; i++)
+            {
+                current->nodes[i].~NodeType();
+            }
+        }
+
+        ::operator delete(current->nodes);
+        delete current;
+        current = previous;
+    }
+
+    nodeCount = 0;
+    slabCount = 0;
+    byteCount = 0;
+}
+
+
+template <typename NodeType>
+void NodePool<NodeType>::merge(NodePool&& p) noexcept
+{
+    if (this == &p || p.current == nullptr) return;
+
+    // link this pool's slabs behind the other's, so that its most recent
+    // slab (which may still have room) becomes the current one
+    Slab* oldest = p.current;
+    while (oldest->next != nullptr)
+    {
+        oldest = oldest->next;
+    }
+
+    oldest->next = current;
+    current = p.current;
+    nodeCount += p.nodeCount;
+    slabCount += p.slabCount;
+    byteCount += p.byteCount;
+
+    p.current = nullptr;
+    p.nodeCount = 0;
+    p.slabCount = 0;
+    p.byteCount = 0;
+}
+
+
+template <typename NodeType>
+NodePoolStats NodePool<NodeType>::stats() const noexcept
+{
+    return NodePoolStats{nodeCount, slabCount, byteCount};
+}
+
+
+
+#endif
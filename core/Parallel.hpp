@@ -0,0 +1,95 @@
+// Parallel.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Helpers shared by the sets that split large jobs (such as adding,
+// rehashing, copying, or destroying many elements) across threads.
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+
+
+namespace impl_
+{
+    // threadsToUse() returns how many threads to use for a job with the
+    // given amount of work, given the number of threads asked for (or zero
+    // for one per hardware thread) and the least work worth giving to each
+    // thread, so that small jobs use fewer threads (or one).
+    inline unsigned int threadsToUse(
+        unsigned int threadCount, unsigned long long work,
+        unsigned long long threshold) noexcept
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        unsigned long long worthwhile = std::max(1ULL, work / std::max(1ULL, threshold));
+        return static_cast<unsigned int>(std::min<unsigned long long>(threadCount, worthwhile));
+    }
+
+
+    // runInParallel() calls work(t) on its own thread for each t from 0 to
+    // threadCount - 1 (using the calling thread for t = 0), waits for all
+    // of them, then rethrows the first exception any of them threw.  If a
+    // thread can't be started, the calling thread does its share instead.
+    template <typename Work>
+    void runInParallel(unsigned int threadCount, Work work)
+    {
+        std::vector<std::exception_ptr> errors(threadCount);
+        std::vector<std::thread> threads;
+
+        auto run = [&](unsigned int t)
+        {
+            try
+            {
+                work(t);
+            }
+            catch (...)
+            {
+                errors[t] = std::current_exception();
+            }
+        };
+
+        try
+        {
+            for (unsigned int t = 1; t < threadCount; t++)
+            {
+                threads.emplace_back(run, t);
+            }
+        }
+        catch (...)
+        {
+            for (unsigned int t = threads.size() + 1; t < threadCount; t++)
+            {
+                run(t);
+            }
+        }
+
+        run(0);
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (std::exception_ptr& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+}
+
+
+
+#endif
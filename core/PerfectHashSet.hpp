@@ -0,0 +1,634 @@
+// PerfectHashSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A PerfectHashSet is an implementation of a Set meant for dictionaries
+// that are built once and then only searched.  It builds a minimal perfect
+// hash function for its elements using the "hash, displace, and compress"
+// (CHD) algorithm, so that every element has its own slot in an array of
+// exactly n slots, and contains() is one hash, one lookup of a displacement
+// value, and one comparison.
+//
+// The elements are divided by hash value into about n/5 small buckets.
+// Each bucket is given a displacement, chosen (largest buckets first) so
+// that every element in the bucket lands on a slot that no other element
+// has taken.  Only the displacements (4 bytes per bucket, so less than a
+// byte per element) and the elements themselves are kept.
+//
+// The hash function must be a seeded one, taking an element and a 64-bit
+// seed and returning a 64-bit hash value, because building occasionally
+// has to start over with a different seed.
+//
+// Constructing a PerfectHashSet from a vector of elements, or adding them
+// with addAll(), builds the perfect hash right away.  Elements passed to
+// add() are instead staged in a small open-addressing index (where
+// contains() finds them with a second lookup) until build() is called to
+// rebuild the perfect hash over the staged and existing elements together.
+// Adding elements after building is allowed, but each build takes linear
+// time, and until the next one, the added elements aren't found with just
+// one hash and one comparison.
+//
+// contains() never modifies the set, so any number of threads can search
+// it at once, as long as none of them is adding elements or building.
+
+#ifndef PERFECTHASHSET_HPP
+#define PERFECTHASHSET_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Set.hpp"
+#include "StringHashing.hpp"
+
+
+
+template <typename ElementType, typename SeededHash = HashStringSeeded>
+class PerfectHashSet : public Set<ElementType>
+{
+public:
+    // The average number of elements per bucket.  Larger values mean fewer
+    // displacements to store, but more work to find them.
+    static constexpr unsigned int ELEMENTS_PER_BUCKET = 5;
+
+public:
+    // Initializes a PerfectHashSet to be empty.
+    explicit PerfectHashSet(SeededHash hash = SeededHash{});
+
+    // Initializes a PerfectHashSet containing the given elements, and
+    // builds its perfect hash right away.
+    explicit PerfectHashSet(
+        const std::vector<ElementType>& elements, SeededHash hash = SeededHash{});
+
+    // Cleans up the PerfectHashSet so that it leaks no memory.
+    ~PerfectHashSet() noexcept override;
+
+    // Initializes a new PerfectHashSet to be a copy of an existing one.
+    PerfectHashSet(const PerfectHashSet& s);
+
+    // Initializes a new PerfectHashSet whose contents are moved from an
+    // expiring one.
+    PerfectHashSet(PerfectHashSet&& s) noexcept;
+
+    // Assigns an existing PerfectHashSet into another.
+    PerfectHashSet& operator=(const PerfectHashSet& s);
+
+    // Assigns an expiring PerfectHashSet into another.
+    PerfectHashSet& operator=(PerfectHashSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() stages an element to be included the next time the perfect
+    // hash is built.  If the element is already in the set (or already
+    // staged), this function has no effect.
+    void add(const ElementType& element) override;
+
+
+    // addAll() stages every element in a vector, then builds the perfect
+    // hash over them (and any elements already in the set).
+    void addAll(const std::vector<ElementType>& elements) override;
+
+
+    // reserve() makes room to stage n elements without reallocating.
+    void reserve(std::size_t n) override;
+
+
+    // build() builds the perfect hash over every element, if any have been
+    // staged since it was last built.  This runs in expected linear time.
+    // If it throws an exception, the set is left as it was.
+    void build();
+
+
+    // contains() returns true if the given element is in the set, false
+    // otherwise.  Unless elements have been staged since the perfect hash
+    // was built, it hashes the element once and compares it with exactly
+    // one other element.  It can also search for a key, such as a
+    // std::string_view in a set of strings; the key is hashed without being
+    // copied into an element as long as the hash function can be called
+    // with it directly (as HashStringSeeded can).
+    using Set<ElementType>::contains;
+    bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
+
+
+    // size() returns the number of elements in the set, including any
+    // that are staged.
+    std::size_t size() const noexcept override;
+
+
+    // byteCount() returns the size of the built structure in bytes: the
+    // displacements plus the array of elements.  (Memory owned by the
+    // elements themselves, like the contents of long strings, isn't
+    // included.)
+    unsigned long long byteCount() const noexcept;
+
+
+private:
+    SeededHash hash;
+
+    // The built perfect hash.
+    std::uint64_t seed;
+    unsigned int sz;
+    unsigned int bucketCount;
+    std::uint32_t* displacements;
+    ElementType* elements;
+
+    // Elements that have been added, but not yet built into the perfect
+    // hash, along with a small open-addressing index into them (holding
+    // each one's position plus one, or zero if empty) used to reject
+    // duplicates as they're added and to find them until they're built.
+    std::vector<ElementType> staged;
+    std::uint32_t* stagedIndex;
+    unsigned int stagedIndexCap;
+
+private:
+    // bucketOf() and slotOf() find the bucket of a hash value, and the slot
+    // that a hash value lands on given its bucket's displacement.
+    static unsigned int bucketOf(std::uint64_t hashValue, unsigned int bucketCount) noexcept;
+    static unsigned int slotOf(
+        std::uint64_t hashValue, std::uint32_t displacement, unsigned int n) noexcept;
+
+    // builtContains() searches the built perfect hash for an element (or a
+    // key that compares equal to one), ignoring any staged elements.
+    template <typename Key>
+    bool builtContains(const Key& element) const;
+
+    // hashKey() hashes a key with the current seed, calling the hash
+    // function on it directly if it can, or on an element made from it
+    // otherwise.
+    template <typename Key>
+    std::uint64_t hashKey(const Key& key) const;
+
+    // stagedContains() searches the staged elements, returning the slot of
+    // the index where the element is (or where it would be added).
+    bool stagedContains(const ElementType& element, unsigned int& indexSlot) const;
+
+    // growStagedIndex() doubles the capacity of the staged index.
+    void growStagedIndex(unsigned int minCap);
+
+    // tryBuild() attempts to build a perfect hash over the given elements
+    // using the given seed, replacing the built one and the staged elements
+    // only once it's complete.  It returns false if no displacement could
+    // be found for some bucket (or if two elements' hash values collide).
+    bool tryBuild(const std::vector<ElementType*>& all, std::uint64_t trySeed);
+
+    // clearBuilt() releases the built perfect hash; clearStaged() releases
+    // the staged elements and their index.
+    void clearBuilt() noexcept;
+    void clearStaged() noexcept;
+};
+
+
+
+template <typename ElementType, typename SeededHash>
+PerfectHashSet<ElementType, SeededHash>::PerfectHashSet(SeededHash hash)
+    : hash{hash}, seed{0}, sz{0}, bucketCount{0}, displacements{nullptr},
+      elements{nullptr}, stagedIndex{nullptr}, stagedIndexCap{0}
+{
+}
+
+
+template <typename ElementType, typename SeededHash>
+PerfectHashSet<ElementType, SeededHash>::PerfectHashSet(
+    const std::vector<ElementType>& elements, SeededHash hash)
+    : PerfectHashSet{hash}
+{
+    addAll(elements);
+}
+
+
+template <typename ElementType, typename SeededHash>
+PerfectHashSet<ElementType, SeededHash>::~PerfectHashSet() noexcept
+{
+    clearBuilt();
+    clearStaged();
+}
+
+
+template <typename ElementType, typename SeededHash>
+PerfectHashSet<ElementType, SeededHash>::PerfectHashSet(const PerfectHashSet& s)
+    : PerfectHashSet{s.hash}
+{
+    seed = s.seed;
+    sz = s.sz;
+    bucketCount = s.bucketCount;
+
+    if (s.sz > 0)
+    {
+        displacements = new std::uint32_t[bucketCount];
+        std::copy(s.displacements, s.displacements + bucketCount, displacements);
+        elements = new ElementType[sz];
+        std::copy(s.elements, s.elements + sz, elements);
+    }
+
+    for (const ElementType& element : s.staged)
+    {
+        add(element);
+    }
+}
+
+
+template <typename ElementType, typename SeededHash>
+PerfectHashSet<ElementType, SeededHash>::PerfectHashSet(PerfectHashSet&& s) noexcept
+    : PerfectHashSet{s.hash}
+{
+    *this = std::move(s);
+}
+
+
+template <typename ElementType, typename SeededHash>
+PerfectHashSet<ElementType, SeededHash>& PerfectHashSet<ElementType, SeededHash>::operator=(
+    const PerfectHashSet& s)
+{
+    if (this != &s)
+    {
+        PerfectHashSet copy{s};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename SeededHash>
+PerfectHashSet<ElementType, SeededHash>& PerfectHashSet<ElementType, SeededHash>::operator=(
+    PerfectHashSet&& s) noexcept
+{
+    if (this != &s)
+    {
+        std::swap(hash, s.hash);
+        std::swap(seed, s.seed);
+        std::swap(sz, s.sz);
+        std::swap(bucketCount, s.bucketCount);
+        std::swap(displacements, s.displacements);
+        std::swap(elements, s.elements);
+        std::swap(staged, s.staged);
+        std::swap(stagedIndex, s.stagedIndex);
+        std::swap(stagedIndexCap, s.stagedIndexCap);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool PerfectHashSet<ElementType, SeededHash>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType, typename SeededHash>
+unsigned int PerfectHashSet<ElementType, SeededHash>::bucketOf(
+    std::uint64_t hashValue, unsigned int bucketCount) noexcept
+{
+    return static_cast<unsigned int>(((hashValue >> 32) * bucketCount) >> 32);
+}
+
+
+template <typename ElementType, typename SeededHash>
+unsigned int PerfectHashSet<ElementType, SeededHash>::slotOf(
+    std::uint64_t hashValue, std::uint32_t displacement, unsigned int n) noexcept
+{
+    // each displacement remixes the hash value into a fresh, independent
+    // position, which is then scaled into [0, n) by taking the high bits of
+    // a multiplication rather than by dividing
+    std::uint64_t mixed = hashValue ^ (displacement * 0x9E3779B97F4A7C15ULL);
+    mixed ^= mixed >> 31;
+    mixed *= 0xBF58476D1CE4E5B9ULL;
+    mixed ^= mixed >> 29;
+    return static_cast<unsigned int>(((mixed & 0xFFFFFFFFULL) * n) >> 32);
+}
+
+
+template <typename ElementType, typename SeededHash>
+void PerfectHashSet<ElementType, SeededHash>::add(const ElementType& element)
+{
+    unsigned int indexSlot = 0;
+    if (builtContains(element) || stagedContains(element, indexSlot)) return;
+
+    if ((staged.size() + 1) * 2 > stagedIndexCap)
+    {
+        growStagedIndex((staged.size() + 1) * 2);
+        stagedContains(element, indexSlot);
+    }
+
+    staged.push_back(element);
+    stagedIndex[indexSlot] = static_cast<std::uint32_t>(staged.size());
+}
+
+
+template <typename ElementType, typename SeededHash>
+void PerfectHashSet<ElementType, SeededHash>::addAll(const std::vector<ElementType>& elements)
+{
+    reserve(staged.size() + elements.size());
+    for (const ElementType& element : elements)
+    {
+        add(element);
+    }
+    build();
+}
+
+
+template <typename ElementType, typename SeededHash>
+void PerfectHashSet<ElementType, SeededHash>::reserve(std::size_t n)
+{
+    staged.reserve(n);
+    if (n * 2 > stagedIndexCap)
+    {
+        growStagedIndex(n * 2);
+    }
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool PerfectHashSet<ElementType, SeededHash>::stagedContains(
+    const ElementType& element, unsigned int& indexSlot) const
+{
+    if (stagedIndexCap == 0) return false;
+
+    unsigned int mask = stagedIndexCap - 1;
+    indexSlot = static_cast<unsigned int>(hash(element, 0)) & mask;
+
+    while (stagedIndex[indexSlot] != 0)
+    {
+        if (staged[stagedIndex[indexSlot] - 1] == element) return true;
+        indexSlot = (indexSlot + 1) & mask;
+    }
+    return false;
+}
+
+
+template <typename ElementType, typename SeededHash>
+void PerfectHashSet<ElementType, SeededHash>::growStagedIndex(unsigned int minCap)
+{
+    unsigned int newCap = std::max(16u, stagedIndexCap);
+    while (newCap < minCap)
+    {
+        newCap *= 2;
+    }
+
+    std::uint32_t* newIndex = new std::uint32_t[newCap];
+    std::fill(newIndex, newIndex + newCap, 0);
+
+    unsigned int mask = newCap - 1;
+    for (unsigned int i = 0; i < staged.size(); i++)
+    {
+        unsigned int slot = static_cast<unsigned int>(hash(staged[i], 0)) & mask;
+        while (newIndex[slot] != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+        newIndex[slot] = i + 1;
+    }
+
+    delete[] stagedIndex;
+    stagedIndex = newIndex;
+    stagedIndexCap = newCap;
+}
+
+
+template <typename ElementType, typename SeededHash>
+void PerfectHashSet<ElementType, SeededHash>::build()
+{
+    if (staged.empty()) return;
+
+    // the elements stay where they are until the new perfect hash is
+    // complete, so the old one is still intact if building it fails
+    std::vector<ElementType*> all;
+    all.reserve(sz + staged.size());
+    for (unsigned int i = 0; i < sz; i++)
+    {
+        all.push_back(&elements[i]);
+    }
+    for (ElementType& element : staged)
+    {
+        all.push_back(&element);
+    }
+
+    // each failed attempt is unlikely, so this almost never loops
+    std::uint64_t trySeed = seed;
+    while (!tryBuild(all, trySeed))
+    {
+        trySeed++;
+    }
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool PerfectHashSet<ElementType, SeededHash>::tryBuild(
+    const std::vector<ElementType*>& all, std::uint64_t trySeed)
+{
+    unsigned int n = all.size();
+    unsigned int buckets = std::max(1u, n / ELEMENTS_PER_BUCKET);
+
+    std::vector<std::uint64_t> hashValues(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        hashValues[i] = hash(*all[i], trySeed);
+    }
+
+    // group the elements by bucket: "members" lists the elements of bucket
+    // b at positions bucketStart[b] through bucketStart[b + 1] - 1
+    std::vector<unsigned int> bucketStart(buckets + 1, 0);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        bucketStart[bucketOf(hashValues[i], buckets) + 1]++;
+    }
+    for (unsigned int b = 0; b < buckets; b++)
+    {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+
+    std::vector<unsigned int> members(n);
+    std::vector<unsigned int> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        members[fill[bucketOf(hashValues[i], buckets)]++] = i;
+    }
+
+    std::vector<unsigned int> order(buckets);
+    for (unsigned int b = 0; b < buckets; b++)
+    {
+        order[b] = b;
+    }
+    std::stable_sort(
+        order.begin(), order.end(),
+        [&](unsigned int a, unsigned int b)
+        {
+            return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+        });
+
+    // place the largest buckets first, while the table is mostly empty
+    std::vector<std::uint32_t> newDisplacements(buckets, 0);
+    std::vector<unsigned int> slotOwner(n, n);
+    std::vector<unsigned int> slots;
+    std::uint64_t maxDisplacement = std::min<std::uint64_t>(
+        0xFFFFFFFFULL, static_cast<std::uint64_t>(n) * 64);
+
+    for (unsigned int b : order)
+    {
+        unsigned int first = bucketStart[b];
+        unsigned int last = bucketStart[b + 1];
+        if (first == last) break;
+
+        bool placed = false;
+        for (std::uint64_t d = 0; d < maxDisplacement && !placed; d++)
+        {
+            slots.clear();
+            placed = true;
+
+            for (unsigned int m = first; m < last && placed; m++)
+            {
+                unsigned int slot = slotOf(hashValues[members[m]], d, n);
+                if (slotOwner[slot] != n || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                {
+                    placed = false;
+                }
+                slots.push_back(slot);
+            }
+
+            if (placed)
+            {
+                for (unsigned int m = first; m < last; m++)
+                {
+                    slotOwner[slots[m - first]] = members[m];
+                }
+                newDisplacements[b] = static_cast<std::uint32_t>(d);
+            }
+        }
+
+        // two elements whose hash values collide can never be separated
+        if (!placed) return false;
+    }
+
+    std::uint32_t* newDisplacementArray = new std::uint32_t[buckets];
+    ElementType* newElements = nullptr;
+
+    try
+    {
+        newElements = new ElementType[n];
+
+        // elements are moved only if that can't throw, since a failure
+        // partway would leave some of the old ones moved away
+        for (unsigned int slot = 0; slot < n; slot++)
+        {
+            if constexpr (std::is_nothrow_move_assignable_v<ElementType>)
+            {
+                newElements[slot] = std::move(*all[slotOwner[slot]]);
+            }
+            else
+            {
+                newElements[slot] = *all[slotOwner[slot]];
+            }
+        }
+    }
+    catch (...)
+    {
+        delete[] newElements;
+        delete[] newDisplacementArray;
+        throw;
+    }
+
+    std::copy(newDisplacements.begin(), newDisplacements.end(), newDisplacementArray);
+
+    clearBuilt();
+    clearStaged();
+
+    displacements = newDisplacementArray;
+    elements = newElements;
+    seed = trySeed;
+    sz = n;
+    bucketCount = buckets;
+    return true;
+}
+
+
+template <typename ElementType, typename SeededHash>
+template <typename Key>
+bool PerfectHashSet<ElementType, SeededHash>::builtContains(const Key& element) const
+{
+    if (sz == 0) return false;
+
+    std::uint64_t hashValue = hashKey(element);
+    std::uint32_t displacement = displacements[bucketOf(hashValue, bucketCount)];
+    return elements[slotOf(hashValue, displacement, sz)] == element;
+}
+
+
+template <typename ElementType, typename SeededHash>
+template <typename Key>
+std::uint64_t PerfectHashSet<ElementType, SeededHash>::hashKey(const Key& key) const
+{
+    if constexpr (std::is_invocable_r_v<std::uint64_t, const SeededHash&, const Key&, std::uint64_t>)
+    {
+        return hash(key, seed);
+    }
+    else
+    {
+        return hash(ElementType{key}, seed);
+    }
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool PerfectHashSet<ElementType, SeededHash>::contains(const ElementType& element) const
+{
+    unsigned int indexSlot = 0;
+    return builtContains(element)
+        || (!staged.empty() && stagedContains(element, indexSlot));
+}
+
+
+template <typename ElementType, typename SeededHash>
+bool PerfectHashSet<ElementType, SeededHash>::contains(SetKeyType<ElementType> key) const
+{
+    unsigned int indexSlot = 0;
+    return builtContains(impl_::SetKey<ElementType>::get(key))
+        || (!staged.empty()
+            && stagedContains(ElementType{impl_::SetKey<ElementType>::get(key)}, indexSlot));
+}
+
+
+template <typename ElementType, typename SeededHash>
+std::size_t PerfectHashSet<ElementType, SeededHash>::size() const noexcept
+{
+    return sz + staged.size();
+}
+
+
+template <typename ElementType, typename SeededHash>
+unsigned long long PerfectHashSet<ElementType, SeededHash>::byteCount() const noexcept
+{
+    return static_cast<unsigned long long>(bucketCount) * sizeof(std::uint32_t)
+        + static_cast<unsigned long long>(sz) * sizeof(ElementType);
+}
+
+
+template <typename ElementType, typename SeededHash>
+void PerfectHashSet<ElementType, SeededHash>::clearBuilt() noexcept
+{
+    delete[] displacements;
+    delete[] elements;
+    displacements = nullptr;
+    elements = nullptr;
+    sz = 0;
+    bucketCount = 0;
+}
+
+
+template <typename ElementType, typename SeededHash>
+void PerfectHashSet<ElementType, SeededHash>::clearStaged() noexcept
+{
+    staged.clear();
+    staged.shrink_to_fit();
+    delete[] stagedIndex;
+    stagedIndex = nullptr;
+    stagedIndexCap = 0;
+}
+
+
+
+#endif
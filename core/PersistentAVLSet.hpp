@@ -0,0 +1,556 @@
+// PersistentAVLSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A PersistentAVLSet is an implementation of a Set that is an AVL tree,
+// like an AVLSet, except that its nodes are never modified once they've
+// been created.  Instead, add() copies the nodes on the path from the root
+// down to where the new element belongs (along with any that a rotation
+// would have changed), sharing every other subtree with the tree as it was,
+// and then publishes the new root.  That's O(log n) new nodes per add().
+//
+// Since an old root still describes the whole tree as it was, a Snapshot
+// is just a reference to one: taking it is O(1), and it stays valid (and
+// unchanged) for as long as it exists, no matter what's added to the set
+// afterward.  Nodes are reference-counted (by std::shared_ptr), so each one
+// is destroyed as soon as no root, in the set or in any Snapshot, can
+// reach it anymore.
+//
+// Any number of threads can call contains() or take snapshots while
+// another thread calls add().  Readers take no locks of their own; they
+// copy the current root (which std::atomic_load() does with, at most, a
+// brief internal lock around the reference count, not while any add() is
+// in progress) and then search nodes that can't change underneath them.
+// Writers are serialized by a mutex, so that two of them never copy the
+// same path at once.  Copying a PersistentAVLSet is as cheap as taking a
+// snapshot, since the copy shares every node with the original.
+//
+// Moving and assigning PersistentAVLSets (and destroying them) are not
+// safe while other threads are using them, though their snapshots are.
+
+#ifndef PERSISTENTAVLSET_HPP
+#define PERSISTENTAVLSET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "AVLSet.hpp"
+#include "Set.hpp"
+
+
+
+template <typename ElementType>
+class PersistentAVLSet : public Set<ElementType>
+{
+private:
+    struct Node;
+
+public:
+    // A VisitFunction is a function that takes a reference to a const
+    // ElementType and returns no value.  inorder() accepts one, but it
+    // also accepts any other callable object that can be called the same
+    // way.
+    using VisitFunction = std::function<void(const ElementType&)>;
+
+
+    // A Snapshot is a read-only view of a PersistentAVLSet as it was when
+    // the snapshot was taken.  It can be copied freely, and used by any
+    // number of threads at once.
+    class Snapshot
+    {
+    public:
+        // Initializes a Snapshot of an empty set.
+        Snapshot() = default;
+
+        // contains() returns true if the given element (or a key that
+        // compares with the elements the same way) was in the set when
+        // the snapshot was taken, false otherwise.
+        bool contains(const ElementType& element) const;
+        bool contains(SetKeyType<ElementType> key) const;
+
+        // As with a Set, a string literal is searched for as a key.
+        template <
+            typename E = ElementType,
+            typename = std::enable_if_t<std::is_same_v<E, std::string>>>
+        bool contains(const char* element) const
+        {
+            return contains(std::string_view{element});
+        }
+
+        // size() returns the number of elements in the snapshot.
+        std::size_t size() const noexcept;
+
+        // height() returns the height of the snapshot's AVL tree, which is
+        // -1 when it's empty.
+        int height() const noexcept;
+
+        // inorder() calls the given "visit" function for each of the
+        // elements in the snapshot, in ascending order.
+        template <typename Visit>
+        void inorder(Visit&& visit) const;
+
+    private:
+        friend class PersistentAVLSet;
+
+        explicit Snapshot(std::shared_ptr<const Node> root) noexcept;
+
+        std::shared_ptr<const Node> root;
+    };
+
+public:
+    // Initializes a PersistentAVLSet to be empty.
+    PersistentAVLSet();
+
+    // Initializes a new PersistentAVLSet to be a copy of an existing one.
+    // This takes O(1) time, since they share every node.
+    PersistentAVLSet(const PersistentAVLSet& s);
+
+    // Initializes a new PersistentAVLSet whose contents are moved from an
+    // expiring one, leaving it empty.
+    PersistentAVLSet(PersistentAVLSet&& s) noexcept;
+
+    // Assigns an existing PersistentAVLSet into another.
+    PersistentAVLSet& operator=(const PersistentAVLSet& s);
+
+    // Assigns an expiring PersistentAVLSet into another.
+    PersistentAVLSet& operator=(PersistentAVLSet&& s) noexcept;
+
+    // Cleans up the PersistentAVLSet, releasing every node that no
+    // snapshot (or copy) still shares.
+    ~PersistentAVLSet() noexcept override = default;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  Otherwise, it creates O(log n)
+    // new nodes, leaving the existing ones (and every snapshot) unchanged,
+    // and publishes the new tree atomically.
+    void add(const ElementType& element) override;
+
+
+    // contains() returns true if the given element (or a key that compares
+    // with the elements the same way) is in the set, false otherwise.  It
+    // searches the tree as it was when contains() was called, so it's
+    // unaffected by any add() running at the same time.
+    using Set<ElementType>::contains;
+    bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
+
+
+    // size() returns the number of elements in the set.
+    std::size_t size() const noexcept override;
+
+
+    // height() returns the height of the AVL tree, which is -1 when it's
+    // empty.
+    int height() const noexcept;
+
+
+    // inorder() calls the given "visit" function for each of the elements
+    // in the set, in ascending order, as they were when it was called.
+    template <typename Visit>
+    void inorder(Visit&& visit) const;
+
+
+    // snapshot() returns a Snapshot of the set as it is now, in O(1) time.
+    Snapshot snapshot() const noexcept;
+
+
+private:
+    // Every node knows the number of elements in its subtree, so that a
+    // snapshot's size is simply its root's.
+    struct Node
+    {
+        Node(
+            const ElementType& value,
+            std::shared_ptr<const Node> left, std::shared_ptr<const Node> right);
+
+        ElementType value;
+        int height;
+        std::size_t count;
+        std::shared_ptr<const Node> left;
+        std::shared_ptr<const Node> right;
+    };
+
+    using NodePtr = std::shared_ptr<const Node>;
+
+private:
+    // The current root, which is only read and written with the atomic
+    // functions for std::shared_ptr.
+    NodePtr root;
+
+    // Serializes writers, so each add() starts from its predecessor's tree.
+    std::mutex writeMutex;
+
+private:
+    // heightOf() and countOf() return a subtree's height (or -1) and its
+    // number of elements (or 0) if it's empty
+    static int heightOf(const NodePtr& n) noexcept;
+    static std::size_t countOf(const NodePtr& n) noexcept;
+
+    // makeNode() creates a node with the given value and children
+    static NodePtr makeNode(const ElementType& value, NodePtr left, NodePtr right);
+
+    // balance() creates a node with the given value and children, which
+    // may be unbalanced by one insertion, and returns the root of the
+    // balanced subtree, creating new nodes for the ones a rotation moves
+    static NodePtr balance(const ElementType& value, NodePtr left, NodePtr right);
+
+    // insert() returns the root of a copy of the subtree n with the element
+    // added, which is n itself if the element was already there.  It
+    // recurses once per level, which in a balanced tree is never many.
+    static NodePtr insert(const NodePtr& n, const ElementType& element);
+
+    // containsKey() searches the subtree n for an element, or a key that
+    // compares with the elements the same way that element would
+    template <typename Key>
+    static bool containsKey(const Node* n, const Key& key);
+
+    // compare() compares an element (or key) with a node's value the same
+    // way AVLSet does, returning a negative number, zero, or a positive one
+    template <typename Key>
+    static int compare(const Key& key, const ElementType& value);
+
+    // inorderFrom() visits the subtree n in order, without recursion
+    template <typename Visit>
+    static void inorderFrom(const Node* n, Visit& visit);
+};
+
+
+
+template <typename ElementType>
+PersistentAVLSet<ElementType>::Node::Node(
+    const ElementType& value, std::shared_ptr<const Node> left, std::shared_ptr<const Node> right)
+    : value{value},
+      height{std::max(heightOf(left), heightOf(right)) + 1},
+      count{countOf(left) + countOf(right) + 1},
+      left{std::move(left)},
+      right{std::move(right)}
+{
+}
+
+
+template <typename ElementType>
+PersistentAVLSet<ElementType>::PersistentAVLSet()
+    : root{nullptr}
+{
+}
+
+
+template <typename ElementType>
+PersistentAVLSet<ElementType>::PersistentAVLSet(const PersistentAVLSet& s)
+    : root{std::atomic_load(&s.root)}
+{
+}
+
+
+template <typename ElementType>
+PersistentAVLSet<ElementType>::PersistentAVLSet(PersistentAVLSet&& s) noexcept
+    : root{std::move(s.root)}
+{
+}
+
+
+template <typename ElementType>
+PersistentAVLSet<ElementType>& PersistentAVLSet<ElementType>::operator=(const PersistentAVLSet& s)
+{
+    if (this != &s)
+    {
+        root = std::atomic_load(&s.root);
+    }
+    return *this;
+}
+
+
+template <typename ElementType>
+PersistentAVLSet<ElementType>& PersistentAVLSet<ElementType>::operator=(PersistentAVLSet&& s) noexcept
+{
+    std::swap(root, s.root);
+    return *this;
+}
+
+
+template <typename ElementType>
+bool PersistentAVLSet<ElementType>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType>
+void PersistentAVLSet<ElementType>::add(const ElementType& element)
+{
+    std::lock_guard<std::mutex> lock{writeMutex};
+
+    // no other writer can publish a root while the lock is held, so the
+    // one read here is still current when the new one replaces it
+    NodePtr current = std::atomic_load(&root);
+    NodePtr added = insert(current, element);
+
+    if (added != current)
+    {
+        std::atomic_store(&root, std::move(added));
+    }
+}
+
+
+template <typename ElementType>
+bool PersistentAVLSet<ElementType>::contains(const ElementType& element) const
+{
+    NodePtr current = std::atomic_load(&root);
+    return containsKey(current.get(), element);
+}
+
+
+template <typename ElementType>
+bool PersistentAVLSet<ElementType>::contains(SetKeyType<ElementType> key) const
+{
+    NodePtr current = std::atomic_load(&root);
+    return containsKey(current.get(), impl_::SetKey<ElementType>::get(key));
+}
+
+
+template <typename ElementType>
+std::size_t PersistentAVLSet<ElementType>::size() const noexcept
+{
+    return countOf(std::atomic_load(&root));
+}
+
+
+template <typename ElementType>
+int PersistentAVLSet<ElementType>::height() const noexcept
+{
+    return heightOf(std::atomic_load(&root));
+}
+
+
+template <typename ElementType>
+template <typename Visit>
+void PersistentAVLSet<ElementType>::inorder(Visit&& visit) const
+{
+    NodePtr current = std::atomic_load(&root);
+    inorderFrom(current.get(), visit);
+}
+
+
+template <typename ElementType>
+typename PersistentAVLSet<ElementType>::Snapshot PersistentAVLSet<ElementType>::snapshot() const noexcept
+{
+    return Snapshot{std::atomic_load(&root)};
+}
+
+
+template <typename ElementType>
+int PersistentAVLSet<ElementType>::heightOf(const NodePtr& n) noexcept
+{
+    return (n == nullptr) ? -1 : n->height;
+}
+
+
+template <typename ElementType>
+std::size_t PersistentAVLSet<ElementType>::countOf(const NodePtr& n) noexcept
+{
+    return (n == nullptr) ? 0 : n->count;
+}
+
+
+template <typename ElementType>
+typename PersistentAVLSet<ElementType>::NodePtr PersistentAVLSet<ElementType>::makeNode(
+    const ElementType& value, NodePtr left, NodePtr right)
+{
+    return std::make_shared<const Node>(value, std::move(left), std::move(right));
+}
+
+
+template <typename ElementType>
+typename PersistentAVLSet<ElementType>::NodePtr PersistentAVLSet<ElementType>::balance(
+    const ElementType& value, NodePtr left, NodePtr right)
+{
+    int leftHeight = heightOf(left);
+    int rightHeight = heightOf(right);
+
+    if (leftHeight > rightHeight + 1)
+    {
+        if (heightOf(left->left) >= heightOf(left->right))
+        {
+            // LL: the left child becomes the root
+            return makeNode(
+                left->value, left->left,
+                makeNode(value, left->right, std::move(right)));
+        }
+        else
+        {
+            // LR: the left child's right child becomes the root
+            const NodePtr& middle = left->right;
+            return makeNode(
+                middle->value,
+                makeNode(left->value, left->left, middle->left),
+                makeNode(value, middle->right, std::move(right)));
+        }
+    }
+    else if (rightHeight > leftHeight + 1)
+    {
+        if (heightOf(right->right) >= heightOf(right->left))
+        {
+            // RR: the right child becomes the root
+            return makeNode(
+                right->value,
+                makeNode(value, std::move(left), right->left),
+                right->right);
+        }
+        else
+        {
+            // RL: the right child's left child becomes the root
+            const NodePtr& middle = right->left;
+            return makeNode(
+                middle->value,
+                makeNode(value, std::move(left), middle->left),
+                makeNode(right->value, middle->right, right->right));
+        }
+    }
+    else
+    {
+        return makeNode(value, std::move(left), std::move(right));
+    }
+}
+
+
+template <typename ElementType>
+typename PersistentAVLSet<ElementType>::NodePtr PersistentAVLSet<ElementType>::insert(
+    const NodePtr& n, const ElementType& element)
+{
+    if (n == nullptr)
+    {
+        return makeNode(element, nullptr, nullptr);
+    }
+
+    int order = compare(element, n->value);
+
+    if (order < 0)
+    {
+        NodePtr left = insert(n->left, element);
+        return (left == n->left) ? n : balance(n->value, std::move(left), n->right);
+    }
+    else if (order > 0)
+    {
+        NodePtr right = insert(n->right, element);
+        return (right == n->right) ? n : balance(n->value, n->left, std::move(right));
+    }
+    else
+    {
+        return n;
+    }
+}
+
+
+template <typename ElementType>
+template <typename Key>
+bool PersistentAVLSet<ElementType>::containsKey(const Node* n, const Key& key)
+{
+    while (n != nullptr)
+    {
+        int order = compare(key, n->value);
+        if (order == 0) return true;
+
+        n = (order < 0) ? n->left.get() : n->right.get();
+    }
+
+    return false;
+}
+
+
+template <typename ElementType>
+template <typename Key>
+int PersistentAVLSet<ElementType>::compare(const Key& key, const ElementType& value)
+{
+    if constexpr (impl_::AVLSet__hasCompare<Key, ElementType>::value)
+    {
+        return key.compare(value);
+    }
+    else if (key < value)
+    {
+        return -1;
+    }
+    else
+    {
+        return (value < key) ? 1 : 0;
+    }
+}
+
+
+template <typename ElementType>
+template <typename Visit>
+void PersistentAVLSet<ElementType>::inorderFrom(const Node* n, Visit& visit)
+{
+    std::vector<const Node*> pending;
+
+    while (n != nullptr || !pending.empty())
+    {
+        for (; n != nullptr; n = n->left.get())
+        {
+            pending.push_back(n);
+        }
+
+        n = pending.back();
+        pending.pop_back();
+        visit(n->value);
+        n = n->right.get();
+    }
+}
+
+
+template <typename ElementType>
+PersistentAVLSet<ElementType>::Snapshot::Snapshot(std::shared_ptr<const Node> root) noexcept
+    : root{std::move(root)}
+{
+}
+
+
+template <typename ElementType>
+bool PersistentAVLSet<ElementType>::Snapshot::contains(const ElementType& element) const
+{
+    return containsKey(root.get(), element);
+}
+
+
+template <typename ElementType>
+bool PersistentAVLSet<ElementType>::Snapshot::contains(SetKeyType<ElementType> key) const
+{
+    return containsKey(root.get(), impl_::SetKey<ElementType>::get(key));
+}
+
+
+template <typename ElementType>
+std::size_t PersistentAVLSet<ElementType>::Snapshot::size() const noexcept
+{
+    return countOf(root);
+}
+
+
+template <typename ElementType>
+int PersistentAVLSet<ElementType>::Snapshot::height() const noexcept
+{
+    return heightOf(root);
+}
+
+
+template <typename ElementType>
+template <typename Visit>
+void PersistentAVLSet<ElementType>::Snapshot::inorder(Visit&& visit) const
+{
+    inorderFrom(root.get(), visit);
+}
+
+
+
+#endif
@@ -0,0 +1,407 @@
+// ShardedSet.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A ShardedSet is an implementation of a Set that splits its elements
+// among a fixed number of independent "shards", each of which is itself
+// a Set of any kind (a HashSet, an AVLSet, and so on), made by a factory
+// function given to the ShardedSet when it's created.  Each element is
+// sent to one shard, chosen by mixing its hash value and using the high-
+// order bits of the result, so that the choice of shard has nothing to
+// do with which bucket (say) the element lands in within its shard.
+//
+// Splitting a set into shards has a few benefits:
+//
+// * Each shard is smaller than the whole set would be, so it can be sized
+//   (using shardsToFit()) to fit in a processor's cache.
+// * Each shard has its own lock, so any number of threads can call add()
+//   and contains() at once, only waiting for one another when they need
+//   the same shard.  By default, contains() takes its shard's lock shared,
+//   so readers never wait for one another, only for writers.
+// * addAll() loads the shards in parallel, one thread per shard at a time.
+//
+// Because every operation on a shard locks it, shards can be of any kind,
+// even ones (like a self-organizing HashSet) whose contains() modifies
+// them, though a ShardedSet of those has to be told to take its locks
+// exclusively in contains(), too.
+//
+// Since the shards' types aren't known, a ShardedSet can't be copied,
+// but it can be moved.  Moving ShardedSets (and destroying them) is not
+// safe while other threads are using them.
+
+#ifndef SHARDEDSET_HPP
+#define SHARDEDSET_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Parallel.hpp"
+#include "Set.hpp"
+
+
+
+template <typename ElementType, typename Hash = std::function<unsigned int(const ElementType&)>>
+class ShardedSet : public Set<ElementType>
+{
+public:
+    // The number of shards a ShardedSet has unless it's told otherwise.
+    static constexpr unsigned int DEFAULT_SHARD_COUNT = 16;
+
+    // The number of bytes shardsToFit() aims to keep each shard within,
+    // which is the size of a typical L2 cache.
+    static constexpr unsigned int DEFAULT_SHARD_BYTES = 256 * 1024;
+
+    // The fewest elements worth giving to each thread in addAll().
+    static constexpr unsigned int PARALLEL_THRESHOLD = 16384;
+
+    // A HashFunction is a function (or function object) that takes a
+    // reference to a const ElementType and returns an unsigned int.  It
+    // will be called by many threads at once, so it must be safe to do so.
+    using HashFunction = Hash;
+
+    // A ShardFactory is a function that returns a new, empty Set, which
+    // will become one of the shards.
+    using ShardFactory = std::function<std::unique_ptr<Set<ElementType>>()>;
+
+public:
+    // Initializes a ShardedSet to have the given number of shards, each
+    // made by calling makeShard, using the given hash function to decide
+    // which shard each element belongs to.  Unless sharedReads is false,
+    // contains() takes its shard's lock shared, which is only safe if the
+    // shards' contains() doesn't modify them.
+    ShardedSet(
+        HashFunction hashFunction, ShardFactory makeShard,
+        unsigned int shardCount = DEFAULT_SHARD_COUNT, bool sharedReads = true);
+
+    // Cleans up the ShardedSet so that it leaks no memory.
+    ~ShardedSet() noexcept override;
+
+    // ShardedSets can't be copied, since their shards can't be.
+    ShardedSet(const ShardedSet& s) = delete;
+    ShardedSet& operator=(const ShardedSet& s) = delete;
+
+    // Initializes a new ShardedSet whose shards are moved from an expiring
+    // one, leaving it with no shards; it can only be destroyed or assigned.
+    ShardedSet(ShardedSet&& s) noexcept;
+
+    // Assigns an expiring ShardedSet into another.
+    ShardedSet& operator=(ShardedSet&& s) noexcept;
+
+
+    // isImplemented() returns true if the shards are implemented.
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to its shard, locking only that shard.  It
+    // can safely be called by many threads at once.
+    void add(const ElementType& element) override;
+
+
+    // addAll() sorts the positions of the elements by shard, then adds
+    // each shard's share of them with one call to that shard's addAll(),
+    // loading several shards at once if there are enough elements to make
+    // it worthwhile.  Each share is copied out of the vector only when its
+    // shard is about to be loaded.
+    void addAll(const std::vector<ElementType>& elements) override;
+
+
+    // reserve() asks every shard to make room for its share of n elements.
+    void reserve(std::size_t n) override;
+
+
+    // contains() returns true if the given element is in its shard, false
+    // otherwise, locking only that shard (shared, unless the ShardedSet was
+    // told otherwise).  It can safely be called by many threads at once.
+    using Set<ElementType>::contains;
+    bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
+
+
+    // size() returns the total number of elements in the shards.
+    std::size_t size() const noexcept override;
+
+
+    // shardCount() returns the number of shards, and shardSize() returns
+    // the number of elements in one of them.
+    unsigned int shardCount() const noexcept;
+    std::size_t shardSize(unsigned int shard) const;
+
+
+    // shardsToFit() returns how many shards are needed so that each one
+    // holds no more than shardBytes, given how many elements there will
+    // be and roughly how many bytes each takes up in a shard.
+    static unsigned int shardsToFit(
+        std::size_t elementCount, unsigned int bytesPerElement,
+        unsigned int shardBytes = DEFAULT_SHARD_BYTES) noexcept;
+
+
+private:
+    struct Shard
+    {
+        std::unique_ptr<Set<ElementType>> set;
+        mutable std::shared_mutex mutex;
+    };
+
+private:
+    HashFunction hashFunction;
+    Shard* shards;
+    unsigned int count;
+    bool sharedReads;
+
+private:
+    // shardOf() returns the index of the shard an element (or a key that
+    // can stand in for one) belongs to
+    template <typename Key>
+    unsigned int shardOf(const Key& key) const;
+
+    // shardContains() searches the given shard for an element or a key,
+    // locking it shared or exclusively, as the ShardedSet was told to
+    template <typename Key>
+    bool shardContains(const Shard& shard, const Key& key) const;
+};
+
+
+
+template <typename ElementType, typename Hash>
+ShardedSet<ElementType, Hash>::ShardedSet(
+    HashFunction hashFunction, ShardFactory makeShard, unsigned int shardCount,
+    bool sharedReads)
+    : hashFunction{hashFunction}, shards{new Shard[std::max(1u, shardCount)]},
+      count{std::max(1u, shardCount)}, sharedReads{sharedReads}
+{
+    try
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            shards[i].set = makeShard();
+        }
+    }
+    catch (...)
+    {
+        delete[] shards;
+        throw;
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+ShardedSet<ElementType, Hash>::~ShardedSet() noexcept
+{
+    delete[] shards;
+}
+
+
+template <typename ElementType, typename Hash>
+ShardedSet<ElementType, Hash>::ShardedSet(ShardedSet&& s) noexcept
+    : hashFunction{s.hashFunction}, shards{nullptr}, count{0}, sharedReads{s.sharedReads}
+{
+    std::swap(shards, s.shards);
+    std::swap(count, s.count);
+}
+
+
+template <typename ElementType, typename Hash>
+ShardedSet<ElementType, Hash>& ShardedSet<ElementType, Hash>::operator=(ShardedSet&& s) noexcept
+{
+    if (this != &s)
+    {
+        std::swap(hashFunction, s.hashFunction);
+        std::swap(shards, s.shards);
+        std::swap(count, s.count);
+        std::swap(sharedReads, s.sharedReads);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename Hash>
+bool ShardedSet<ElementType, Hash>::isImplemented() const noexcept
+{
+    return count > 0 && shards[0].set->isImplemented();
+}
+
+
+template <typename ElementType, typename Hash>
+void ShardedSet<ElementType, Hash>::add(const ElementType& element)
+{
+    Shard& shard = shards[shardOf(element)];
+    std::lock_guard<std::shared_mutex> lock{shard.mutex};
+    shard.set->add(element);
+}
+
+
+template <typename ElementType, typename Hash>
+void ShardedSet<ElementType, Hash>::addAll(const std::vector<ElementType>& elements)
+{
+    // the positions of shard i's elements are positions[start[i]] through
+    // positions[start[i + 1] - 1]
+    std::vector<unsigned int> shardOfElement(elements.size());
+    std::vector<std::size_t> start(count + 1, 0);
+    for (std::size_t e = 0; e < elements.size(); e++)
+    {
+        shardOfElement[e] = shardOf(elements[e]);
+        start[shardOfElement[e] + 1]++;
+    }
+    for (unsigned int i = 0; i < count; i++)
+    {
+        start[i + 1] += start[i];
+    }
+
+    std::vector<std::size_t> positions(elements.size());
+    std::vector<std::size_t> fill(start.begin(), start.end() - 1);
+    for (std::size_t e = 0; e < elements.size(); e++)
+    {
+        positions[fill[shardOfElement[e]]++] = e;
+    }
+
+    unsigned int threadCount = std::min(
+        count, impl_::threadsToUse(0, elements.size(), PARALLEL_THRESHOLD));
+
+    // each thread repeatedly claims the next shard nobody has loaded yet,
+    // so that a thread given small shards moves on to others
+    std::atomic<unsigned int> nextShard{0};
+
+    impl_::runInParallel(
+        threadCount,
+        [&](unsigned int)
+        {
+            for (unsigned int i = nextShard++; i < count; i = nextShard++)
+            {
+                std::vector<ElementType> share;
+                share.reserve(start[i + 1] - start[i]);
+                for (std::size_t p = start[i]; p < start[i + 1]; p++)
+                {
+                    share.push_back(elements[positions[p]]);
+                }
+
+                std::lock_guard<std::shared_mutex> lock{shards[i].mutex};
+                shards[i].set->addAll(share);
+            }
+        });
+}
+
+
+template <typename ElementType, typename Hash>
+void ShardedSet<ElementType, Hash>::reserve(std::size_t n)
+{
+    // shares are never quite even, so leave an eighth more room in each
+    std::size_t share = n / count;
+    share += share / 8 + 1;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        std::lock_guard<std::shared_mutex> lock{shards[i].mutex};
+        shards[i].set->reserve(share);
+    }
+}
+
+
+template <typename ElementType, typename Hash>
+bool ShardedSet<ElementType, Hash>::contains(const ElementType& element) const
+{
+    return shardContains(shards[shardOf(element)], element);
+}
+
+
+template <typename ElementType, typename Hash>
+bool ShardedSet<ElementType, Hash>::contains(SetKeyType<ElementType> key) const
+{
+    return shardContains(shards[shardOf(impl_::SetKey<ElementType>::get(key))], key);
+}
+
+
+template <typename ElementType, typename Hash>
+std::size_t ShardedSet<ElementType, Hash>::size() const noexcept
+{
+    std::size_t total = 0;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        std::shared_lock<std::shared_mutex> lock{shards[i].mutex};
+        total += shards[i].set->size();
+    }
+
+    return total;
+}
+
+
+template <typename ElementType, typename Hash>
+unsigned int ShardedSet<ElementType, Hash>::shardCount() const noexcept
+{
+    return count;
+}
+
+
+template <typename ElementType, typename Hash>
+std::size_t ShardedSet<ElementType, Hash>::shardSize(unsigned int shard) const
+{
+    std::shared_lock<std::shared_mutex> lock{shards[shard].mutex};
+    return shards[shard].set->size();
+}
+
+
+template <typename ElementType, typename Hash>
+unsigned int ShardedSet<ElementType, Hash>::shardsToFit(
+    std::size_t elementCount, unsigned int bytesPerElement, unsigned int shardBytes) noexcept
+{
+    unsigned long long totalBytes = static_cast<unsigned long long>(elementCount) * bytesPerElement;
+    unsigned long long shardCount = (totalBytes + shardBytes - 1) / std::max(1u, shardBytes);
+    return static_cast<unsigned int>(std::max(1ULL, shardCount));
+}
+
+
+template <typename ElementType, typename Hash>
+template <typename Key>
+unsigned int ShardedSet<ElementType, Hash>::shardOf(const Key& key) const
+{
+    std::uint32_t hashValue;
+    if constexpr (std::is_invocable_r_v<unsigned int, const Hash&, const Key&>)
+    {
+        hashValue = hashFunction(key);
+    }
+    else
+    {
+        hashValue = hashFunction(ElementType{key});
+    }
+
+    // the shards might themselves be hash tables using the same hash
+    // function, so the bits are mixed (as in MurmurHash3's finalizer)
+    // before the high-order ones pick the shard
+    hashValue ^= hashValue >> 16;
+    hashValue *= 0x85ebca6bu;
+    hashValue ^= hashValue >> 13;
+    hashValue *= 0xc2b2ae35u;
+    hashValue ^= hashValue >> 16;
+
+    return static_cast<unsigned int>((static_cast<std::uint64_t>(hashValue) * count) >> 32);
+}
+
+
+template <typename ElementType, typename Hash>
+template <typename Key>
+bool ShardedSet<ElementType, Hash>::shardContains(const Shard& shard, const Key& key) const
+{
+    if (sharedReads)
+    {
+        std::shared_lock<std::shared_mutex> lock{shard.mutex};
+        return shard.set->contains(key);
+    }
+    else
+    {
+        std::lock_guard<std::shared_mutex> lock{shard.mutex};
+        return shard.set->contains(key);
+    }
+}
+
+
+
+#endif
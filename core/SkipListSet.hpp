@@ -254,12 +254,15 @@ public:
     // contains() returns true if the given element is already in the set,
     // false otherwise.  This function runs in an expected time of O(log n)
     // (i.e., over the long run, we expect the average to be O(log n))
-    // with very high probability.
+    // with very high probability.  It can also search for a key, such as a
+    // std::string_view in a set of strings.
+    using Set<ElementType>::contains;
     bool contains(const ElementType& element) const override;
+    bool contains(SetKeyType<ElementType> key) const override;
 
 
     // size() returns the number of elements in the set.
-    unsigned int size() const noexcept override;
+    std::size_t size() const noexcept override;
 
 
     // levelCount() returns the number of levels in the skip list.
@@ -286,7 +289,7 @@ private:
 
     // You'll no doubt want to add member variables and "helper" member
     // functions here.
-    unsigned int sz;
+    std::size_t sz;
 };
 
 
@@ -359,7 +362,14 @@ bool SkipListSet<ElementType>::contains(const ElementType& element) const
 
 
 template <typename ElementType>
-unsigned int SkipListSet<ElementType>::size() const noexcept
+bool SkipListSet<ElementType>::contains(SetKeyType<ElementType> key) const
+{
+    return false;
+}
+
+
+template <typename ElementType>
+std::size_t SkipListSet<ElementType>::size() const noexcept
 {
     return sz;
 }
@@ -7,6 +7,8 @@
 // the requirements.
 
 #include "WordChecker.hpp"
+#include <string_view>
+#include <utility>
 #include "HashSet.hpp"
 #include "StringHashing.hpp"
 
@@ -26,25 +28,36 @@ bool WordChecker::wordExists(const std::string& word) const
 std::vector<std::string> WordChecker::findSuggestions(const std::string& word) const
 {
     std::vector<std::string> suggestions;
-    HashSet<std::string> checkDuplicates{hashStringAsProduct};
+    HashSet<std::string, HashStringAsProduct, FibonacciRange> checkDuplicates{
+        HashStringAsProduct{}};
     unsigned int sz = word.size();
+
+    // every candidate is built in this one buffer (and the halves of a
+    // split word are searched for as views into the word), so only the
+    // suggestions themselves are allocated
+    std::string alterWord;
+    alterWord.reserve(sz + 1);
+
+    auto suggest = [&](std::string_view candidate)
+    {
+        if (!checkDuplicates.contains(candidate))
+        {
+            std::string suggestion{candidate};
+            checkDuplicates.add(suggestion);
+            suggestions.push_back(std::move(suggestion));
+        }
+    };
     
     // swap each adjacent pair of characters in the word
     if (word.size() >= 2)  // in order to swap, size must be at least 2
     {
         for (unsigned int i = 0; i < sz - 1; i++)
         {
-            std::string alterWord = word;
-            char temp = alterWord[i];
-            alterWord[i] = alterWord[i+1];
-            alterWord[i+1] = temp;
+            alterWord = word;
+            std::swap(alterWord[i], alterWord[i+1]);
             if (words.contains(alterWord)) 
             {
-                if (!checkDuplicates.contains(alterWord))
-                {
-                    checkDuplicates.add(alterWord);
-                    suggestions.push_back(alterWord);
-                }
+                suggest(alterWord);
             }
         }
     }
@@ -53,17 +66,14 @@ std::vector<std::string> WordChecker::findSuggestions(const std::string& word) c
     // in the word
     for (unsigned int i = 0; i <= sz; i++)
     {
+        alterWord = word;
+        alterWord.insert(i, 1, ' ');
         for (unsigned int j = 0; j < 26; j++)
         {
-            std::string alterWord = word;
-            alterWord.insert(i, 1, letters[j]);
+            alterWord[i] = letters[j];
             if (words.contains(alterWord)) 
             {
-                if (!checkDuplicates.contains(alterWord))
-                {
-                    checkDuplicates.add(alterWord);
-                    suggestions.push_back(alterWord);
-                }
+                suggest(alterWord);
             }
         }
     }
@@ -71,15 +81,11 @@ std::vector<std::string> WordChecker::findSuggestions(const std::string& word) c
     // delete each character from the word
     for (unsigned int i = 0; i < sz; i++)
     {
-        std::string alterWord = word;
+        alterWord = word;
         alterWord.erase(i, 1);
         if (words.contains(alterWord)) 
         {
-            if (!checkDuplicates.contains(alterWord))
-            {
-                checkDuplicates.add(alterWord);
-                suggestions.push_back(alterWord);
-            }
+            suggest(alterWord);
         }
     }
 
@@ -87,17 +93,13 @@ std::vector<std::string> WordChecker::findSuggestions(const std::string& word) c
     // through 'Z'
     for (unsigned int i = 0; i < sz; i++)
     {
+        alterWord = word;
         for (unsigned int j = 0; j < 26; j++)
         {
-            std::string alterWord = word;
             alterWord[i] = letters[j];
             if (words.contains(alterWord)) 
             {
-                if (!checkDuplicates.contains(alterWord))
-                {
-                    checkDuplicates.add(alterWord);
-                    suggestions.push_back(alterWord);
-                }
+                suggest(alterWord);
             }
         }
     }
@@ -105,24 +107,19 @@ std::vector<std::string> WordChecker::findSuggestions(const std::string& word) c
     // add a space in between each adjacent pair of characters in the word
     if (sz >= 2)
     {
+        std::string_view wordView{word};
         for (unsigned int i = 1; i < sz; i++)
         {
-            std::string space = " ";
-            std::string alterWord = word;
-            alterWord.insert(i, 1, space[0]);
-            std::string left = alterWord.substr(0, i);
-            std::string right = alterWord.substr(i+1, sz-i);
+            std::string_view left = wordView.substr(0, i);
+            std::string_view right = wordView.substr(i);
             if (words.contains(left) && words.contains(right))
             {
-                if (!checkDuplicates.contains(alterWord))
-                {
-                    checkDuplicates.add(alterWord);
-                    suggestions.push_back(alterWord);
-                }
+                alterWord = word;
+                alterWord.insert(i, 1, ' ');
+                suggest(alterWord);
             }
         }
     }
 
     return suggestions;
 }
-
@@ -0,0 +1,195 @@
+// BTreeSetExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file, then the number of words in a synthetic
+// word list (e.g., 10000000), or 0 to skip it.  The synthetic words are
+// made by joining two words from the word file chosen at random (so, like
+// real words, many of them share their first several characters).
+//
+// The words of each list are added, in the order they're listed, to an
+// AVLSet, a CompactAVLSet, and a BTreeSet, one at a time.  For each, the
+// experiment reports how long the adds took, how many millions of
+// contains() calls per second it can do (looking up, in a shuffled order,
+// up to a million of the words plus the same number that aren't in the
+// set), and how long an inorder traversal of it takes.
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "AVLSet.hpp"
+#include "BTreeSet.hpp"
+#include "CompactAVLSet.hpp"
+#include "Experiments.hpp"
+#include "Set.hpp"
+#include "Stopwatch.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    constexpr std::size_t MAX_LOOKUP_WORDS = 1000000;
+    constexpr std::size_t MIN_LOOKUPS = 2000000;
+
+
+    std::vector<std::string> makeSyntheticWords(
+        const std::vector<std::string>& words, std::size_t count)
+    {
+        std::mt19937_64 random{46};
+        std::uniform_int_distribution<std::size_t> pick{0, words.size() - 1};
+
+        std::vector<std::string> synthetic;
+        synthetic.reserve(count);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            synthetic.push_back(words[pick(random)] + words[pick(random)]);
+        }
+
+        return synthetic;
+    }
+
+
+    // makeLookups() returns a shuffled sample of the words, along with the
+    // same number of words that aren't in the list
+    std::vector<std::string> makeLookups(const std::vector<std::string>& words)
+    {
+        std::mt19937 random{46};
+
+        std::vector<std::string> lookups;
+        std::sample(
+            words.begin(), words.end(), std::back_inserter(lookups),
+            MAX_LOOKUP_WORDS, random);
+
+        std::size_t found = lookups.size();
+        for (std::size_t i = 0; i < found; i++)
+        {
+            lookups.push_back(lookups[i] + "#");
+        }
+
+        std::shuffle(lookups.begin(), lookups.end(), random);
+        return lookups;
+    }
+
+
+    // lookupsPerSecond() returns how many millions of contains() calls the
+    // set does per second, looking up every word at least once and making
+    // at least MIN_LOOKUPS calls
+    double lookupsPerSecond(
+        const Set<std::string>& set, const std::vector<std::string>& lookups)
+    {
+        std::size_t rounds = std::max<std::size_t>(1, MIN_LOOKUPS / lookups.size());
+
+        Stopwatch stopwatch;
+        std::size_t found = 0;
+
+        stopwatch.start();
+        for (std::size_t round = 0; round < rounds; round++)
+        {
+            for (const std::string& word : lookups)
+            {
+                if (set.contains(word))
+                {
+                    found++;
+                }
+            }
+        }
+        stopwatch.stop();
+
+        // keeps the lookups from being optimized away
+        if (found == 0)
+        {
+            std::cout << "(nothing found)" << std::endl;
+        }
+
+        return static_cast<double>(lookups.size()) * rounds / stopwatch.lastDuration();
+    }
+
+
+    template <typename SetType>
+    void runSet(
+        const std::string& name, const std::vector<std::string>& words,
+        const std::vector<std::string>& lookups)
+    {
+        SetType set;
+        Stopwatch stopwatch;
+
+        stopwatch.start();
+        for (const std::string& word : words)
+        {
+            set.add(word);
+        }
+        stopwatch.stop();
+        double loadDuration = stopwatch.lastDuration();
+
+        double lookupRate = lookupsPerSecond(set, lookups);
+
+        std::size_t totalLength = 0;
+        stopwatch.start();
+        set.inorder([&](const std::string& word) { totalLength += word.length(); });
+        stopwatch.stop();
+        double traversalDuration = stopwatch.lastDuration();
+
+        std::cout << std::left << std::setw(16) << name;
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(14) << loadDuration << "usec"
+                  << std::setprecision(2) << std::setw(16) << lookupRate
+                  << std::setprecision(0) << std::setw(14) << traversalDuration << "usec"
+                  << std::endl;
+
+        if constexpr (std::is_same_v<SetType, BTreeSet<std::string>>)
+        {
+            std::cout << "    (" << set.nodeCount() << " nodes, height " << set.height()
+                      << ", " << std::setprecision(1)
+                      << static_cast<double>(set.byteCount()) / set.size()
+                      << " bytes of nodes per word, " << totalLength << " characters)"
+                      << std::endl;
+        }
+    }
+
+
+    void runWordList(const std::string& description, const std::vector<std::string>& words)
+    {
+        std::vector<std::string> lookups = makeLookups(words);
+
+        std::cout << description << ": " << words.size() << " words, "
+                  << lookups.size() << " lookups" << std::endl;
+        std::cout << "                      LoadTime    MLookups/sec     Traversal" << std::endl;
+
+        runSet<AVLSet<std::string>>("AVL", words, lookups);
+        runSet<CompactAVLSet<std::string>>("AVL COMPACT", words, lookups);
+        runSet<BTreeSet<std::string>>("BTREE", words, lookups);
+
+        std::cout << std::endl;
+    }
+}
+
+
+
+void runBTreeSetExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::size_t syntheticCount = 0;
+    std::cin >> syntheticCount;
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+
+    std::cout << "BTreeSet nodes hold up to " << BTreeSet<std::string>::MAX_KEYS
+              << " words" << std::endl;
+    std::cout << std::endl;
+
+    runWordList(wordFilePath, words);
+
+    if (syntheticCount > 0)
+    {
+        runWordList("Synthetic", makeSyntheticWords(words, syntheticCount));
+    }
+}
@@ -0,0 +1,168 @@
+// CompactAVLSetExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file.  The words are added, one at a time, to
+// an AVLSet (with and without a NodePool) and to a CompactAVLSet.  For
+// each, the experiment reports how long it took, roughly how many bytes of
+// nodes it uses per word (not counting the contents of the strings, which
+// all of them store alike), and how many millions of contains() calls per
+// second it can do, looking up every word in a shuffled order, plus the
+// same number of words that aren't in the set.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "AVLSet.hpp"
+#include "CompactAVLSet.hpp"
+#include "Experiments.hpp"
+#include "Set.hpp"
+#include "Stopwatch.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    constexpr unsigned int ROUNDS = 5;
+
+
+    // An AVLSet's node is laid out like this (a set of strings keeps each
+    // one's prefix first), and each one is allocated separately, so the
+    // allocator adds a header and rounds it up.
+    struct PointerNode
+    {
+        std::uint64_t prefix;
+        std::string value;
+        int height;
+        PointerNode* left;
+        PointerNode* right;
+    };
+
+    constexpr std::size_t ALLOCATOR_HEADER_BYTES = 8;
+    constexpr std::size_t ALLOCATOR_ALIGNMENT = 16;
+
+
+    std::size_t allocatedBytes(std::size_t requested)
+    {
+        std::size_t bytes = requested + ALLOCATOR_HEADER_BYTES;
+        return (bytes + ALLOCATOR_ALIGNMENT - 1) / ALLOCATOR_ALIGNMENT * ALLOCATOR_ALIGNMENT;
+    }
+
+
+    template <typename SetType>
+    double timeAdds(SetType& set, const std::vector<std::string>& words)
+    {
+        Stopwatch stopwatch;
+
+        stopwatch.start();
+        for (const std::string& word : words)
+        {
+            set.add(word);
+        }
+        stopwatch.stop();
+
+        return stopwatch.lastDuration();
+    }
+
+
+    // lookupsPerSecond() returns how many millions of contains() calls the
+    // set does per second
+    double lookupsPerSecond(
+        const Set<std::string>& set, const std::vector<std::string>& lookups)
+    {
+        Stopwatch stopwatch;
+        unsigned int found = 0;
+
+        stopwatch.start();
+        for (unsigned int round = 0; round < ROUNDS; round++)
+        {
+            for (const std::string& word : lookups)
+            {
+                if (set.contains(word))
+                {
+                    found++;
+                }
+            }
+        }
+        stopwatch.stop();
+
+        // keeps the lookups from being optimized away
+        if (found == 0)
+        {
+            std::cout << "(nothing found)" << std::endl;
+        }
+
+        return static_cast<double>(lookups.size()) * ROUNDS / stopwatch.lastDuration();
+    }
+
+
+    void printRow(
+        const std::string& name, double loadDuration, double bytesPerWord,
+        double lookupRate)
+    {
+        std::cout << std::left << std::setw(16) << name;
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << loadDuration << "usec"
+                  << std::setprecision(1) << std::setw(14) << bytesPerWord
+                  << std::setprecision(2) << std::setw(16) << lookupRate
+                  << std::endl;
+    }
+}
+
+
+
+void runCompactAVLSetExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+
+    std::vector<std::string> lookups = words;
+    for (const std::string& word : words)
+    {
+        lookups.push_back(word + "#");
+    }
+
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937{46});
+
+    std::cout << "Loaded " << words.size() << " words from " << wordFilePath << std::endl;
+    std::cout << std::endl;
+    std::cout << "                    LoadTime  BytesPerWord  MLookups/sec" << std::endl;
+
+    AVLSet<std::string> avlSet;
+    double avlLoadDuration = timeAdds(avlSet, words);
+
+    printRow(
+        "AVL", avlLoadDuration, static_cast<double>(allocatedBytes(sizeof(PointerNode))),
+        lookupsPerSecond(avlSet, lookups));
+
+    AVLSet<std::string> pooledSet{true, true};
+    double pooledLoadDuration = timeAdds(pooledSet, words);
+
+    printRow(
+        "AVL POOLED", pooledLoadDuration,
+        static_cast<double>(pooledSet.poolStats().bytes) / pooledSet.size(),
+        lookupsPerSecond(pooledSet, lookups));
+
+    CompactAVLSet<std::string> compactSet;
+    double compactLoadDuration = timeAdds(compactSet, words);
+
+    printRow(
+        "AVL COMPACT", compactLoadDuration,
+        static_cast<double>(compactSet.byteCount()) / compactSet.size(),
+        lookupsPerSecond(compactSet, lookups));
+
+    // without the slack left by doubling, each node is exactly this big
+    std::cout << std::endl;
+    std::cout << "Node sizes: AVL " << sizeof(PointerNode) << " bytes (plus allocator overhead), "
+              << "AVL COMPACT " << compactSet.byteCount() / compactSet.capacity() << " bytes"
+              << std::endl;
+}
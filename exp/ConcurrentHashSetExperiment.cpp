@@ -0,0 +1,91 @@
+// ConcurrentHashSetExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file.  The words are loaded into a
+// ConcurrentHashSet, then looked up by 1, 2, 4, ... threads at once (up
+// to the number of hardware threads), reporting the total throughput of
+// contains() at each thread count.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ConcurrentHashSet.hpp"
+#include "Experiments.hpp"
+#include "Stopwatch.hpp"
+#include "StringHashing.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    constexpr unsigned int ROUNDS = 10;
+}
+
+
+
+void runConcurrentHashSetExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+
+    ConcurrentHashSet<std::string> wordSet{hashStringAsProduct};
+    wordSet.reserve(words.size());
+    for (const std::string& word : words)
+    {
+        wordSet.add(word);
+    }
+
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Loaded " << wordSet.size() << " words from " << wordFilePath << std::endl;
+    std::cout << std::endl;
+    std::cout << "Threads        Time    Lookups/usec" << std::endl;
+
+    for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        Stopwatch stopwatch;
+        std::vector<unsigned int> found(threadCount, 0);
+
+        stopwatch.start();
+
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                unsigned int count = 0;
+                for (unsigned int round = 0; round < ROUNDS; round++)
+                {
+                    for (const std::string& word : words)
+                    {
+                        if (wordSet.contains(word)) count++;
+                    }
+                }
+                found[t] = count;
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        stopwatch.stop();
+
+        double lookups = static_cast<double>(words.size()) * ROUNDS * threadCount;
+
+        std::cout << std::left << std::setw(8) << threadCount;
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << stopwatch.lastDuration() << "usec"
+                  << std::setprecision(2) << std::setw(12)
+                  << lookups / stopwatch.lastDuration() << std::endl;
+    }
+}
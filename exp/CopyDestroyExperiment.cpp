@@ -0,0 +1,140 @@
+// CopyDestroyExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: a line of set sizes, separated by spaces (e.g., "1000000 10000000
+// 50000000").  For each size, a HashSet and then an AVLSet of that many
+// 64-bit integers is built, then copied and cleared, first using one
+// thread and then using one per hardware thread, reporting how long each
+// copy and each clear took.
+//
+// Only the set being measured, its copy, and (while the set is built) the
+// integers are in memory at once.  That's roughly 85 bytes per element for
+// a HashSet and 100 for an AVLSet, counting the allocator's overhead, so
+// leave some headroom when choosing the sizes.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AVLSet.hpp"
+#include "Experiments.hpp"
+#include "HashSet.hpp"
+#include "Stopwatch.hpp"
+
+
+
+namespace
+{
+    // The elements are consecutive outputs of SplitMix64, which are all
+    // different and look random, so they can be their own hash values.
+    std::uint64_t element(std::uint64_t i)
+    {
+        std::uint64_t z = (i + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+
+    struct IdentityHash
+    {
+        std::size_t operator()(std::uint64_t value) const noexcept
+        {
+            return static_cast<std::size_t>(value);
+        }
+    };
+
+
+    std::vector<std::uint64_t> makeElements(std::size_t count)
+    {
+        std::vector<std::uint64_t> elements(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            elements[i] = element(i);
+        }
+        return elements;
+    }
+
+
+    // timeCopyAndClear() copies the set using the given number of threads
+    // (or, if it's zero, one per hardware thread), then clears the copy the
+    // same way, and prints how long each took
+    template <typename SetType>
+    void timeCopyAndClear(const SetType& set, unsigned int threadCount)
+    {
+        Stopwatch stopwatch;
+
+        stopwatch.start();
+        SetType copy{set, threadCount};
+        stopwatch.stop();
+        double copyDuration = stopwatch.lastDuration();
+
+        stopwatch.start();
+        copy.clear(threadCount);
+        stopwatch.stop();
+        double clearDuration = stopwatch.lastDuration();
+
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(14) << copyDuration << "usec"
+                  << std::setw(14) << clearDuration << "usec";
+    }
+
+
+    template <typename SetType>
+    void runSet(const std::string& name, std::size_t count, const SetType& set)
+    {
+        for (unsigned int threadCount : {1u, 0u})
+        {
+            std::cout << std::left << std::setw(12) << count << std::setw(8) << name
+                      << std::setw(8) << (threadCount == 0 ? "all" : "1");
+            timeCopyAndClear(set, threadCount);
+            std::cout << std::endl;
+        }
+    }
+}
+
+
+
+void runCopyDestroyExperiment()
+{
+    std::string line;
+    std::getline(std::cin, line);
+
+    std::vector<std::size_t> sizes;
+    std::istringstream in{line};
+    for (std::size_t size; in >> size; )
+    {
+        sizes.push_back(size);
+    }
+
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << std::endl;
+    std::cout << "Elements    Set     Threads           Copy         Clear" << std::endl;
+
+    for (std::size_t count : sizes)
+    {
+        {
+            HashSet<std::uint64_t, IdentityHash> hashSet{IdentityHash{}};
+            hashSet.addAll(makeElements(count));
+            runSet("HASH", count, hashSet);
+        }
+
+        {
+            // sorted elements are built into a balanced tree in linear time
+            AVLSet<std::uint64_t> avlSet;
+            {
+                std::vector<std::uint64_t> elements = makeElements(count);
+                std::sort(elements.begin(), elements.end());
+                avlSet.assignSorted(elements);
+            }
+            runSet("AVL", count, avlSet);
+        }
+    }
+}
@@ -0,0 +1,154 @@
+// CuckooHashSetExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file, then the path to a text file.  The words
+// are loaded into a CuckooHashSet and into HashSets using the sum and
+// product hash functions, then each set looks up three workloads:
+//
+//     Hits      every word in the word file
+//     Text      every word in the text file (mostly hits)
+//     Edits     every word in the text file with each of its letters
+//               replaced by each letter from 'A' through 'Z', the way
+//               suggestions are generated (almost all misses)
+//
+// The time for each workload is reported, along with the average time per
+// lookup in nanoseconds.
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "CuckooHashSet.hpp"
+#include "Experiments.hpp"
+#include "HashSet.hpp"
+#include "Set.hpp"
+#include "Stopwatch.hpp"
+#include "StringHashing.hpp"
+#include "TextFileReader.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    std::vector<std::string> readText(const std::string& textFilePath)
+    {
+        std::vector<std::string> words;
+        TextFileReader reader{textFilePath};
+
+        while (!reader.noMoreWords())
+        {
+            words.push_back(reader.currentWord());
+            reader.advanceToNextWord();
+        }
+
+        return words;
+    }
+
+
+    std::vector<std::string> makeEdits(const std::vector<std::string>& text)
+    {
+        std::vector<std::string> edits;
+
+        for (const std::string& word : text)
+        {
+            std::string edit = word;
+            for (unsigned int i = 0; i < word.size(); i++)
+            {
+                for (char letter = 'A'; letter <= 'Z'; letter++)
+                {
+                    edit[i] = letter;
+                    edits.push_back(edit);
+                }
+                edit[i] = word[i];
+            }
+        }
+
+        return edits;
+    }
+
+
+    void timeLookups(const Set<std::string>& set, const std::vector<std::string>& lookups)
+    {
+        Stopwatch stopwatch;
+        unsigned int found = 0;
+
+        stopwatch.start();
+        for (const std::string& word : lookups)
+        {
+            if (set.contains(word))
+            {
+                found++;
+            }
+        }
+        stopwatch.stop();
+
+        double duration = stopwatch.lastDuration();
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(10) << duration << "usec"
+                  << std::setprecision(1) << std::setw(8)
+                  << duration * 1000.0 / lookups.size() << "ns";
+    }
+
+
+    void timeWorkloads(
+        const std::string& name, const Set<std::string>& set,
+        const std::vector<std::vector<std::string>>& workloads)
+    {
+        std::cout << std::left << std::setw(16) << name;
+        for (const std::vector<std::string>& lookups : workloads)
+        {
+            timeLookups(set, lookups);
+        }
+        std::cout << std::endl;
+    }
+
+
+    template <typename SetType>
+    void load(SetType& set, const std::vector<std::string>& words)
+    {
+        set.reserve(words.size());
+        for (const std::string& word : words)
+        {
+            set.add(word);
+        }
+    }
+}
+
+
+
+void runCuckooHashSetExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::string textFilePath;
+    std::getline(std::cin, textFilePath);
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+    std::vector<std::string> text = readText(textFilePath);
+    std::vector<std::string> edits = makeEdits(text);
+    std::vector<std::vector<std::string>> workloads{words, text, edits};
+
+    std::cout << "Loaded " << words.size() << " words from " << wordFilePath << std::endl;
+    std::cout << "Read " << text.size() << " words from " << textFilePath
+              << " (" << edits.size() << " edits)" << std::endl;
+    std::cout << std::endl;
+    std::cout << std::setw(16) << "" << std::right
+              << std::setw(24) << "Hits" << std::setw(24) << "Text"
+              << std::setw(24) << "Edits" << std::endl;
+
+    HashSet<std::string> sumSet{hashStringAsSum};
+    load(sumSet, words);
+    timeWorkloads("HASH SUM", sumSet, workloads);
+
+    HashSet<std::string> productSet{hashStringAsProduct};
+    load(productSet, words);
+    timeWorkloads("HASH PRODUCT", productSet, workloads);
+
+    CuckooHashSet<std::string> cuckooSet;
+    load(cuckooSet, words);
+    timeWorkloads("CUCKOO HASH", cuckooSet, workloads);
+}
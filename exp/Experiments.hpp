@@ -0,0 +1,88 @@
+// Experiments.hpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Each experiment is a benchmark that can be run from a.out.exp by typing
+// its name (see expmain.cpp).  Experiments read any further input they
+// need (such as the path to a word file) from the standard input.
+
+#ifndef EXPERIMENTS_HPP
+#define EXPERIMENTS_HPP
+
+
+
+// Compares loading and destroying HashSets and AVLSets whose nodes are
+// allocated individually with ones whose nodes come from a NodePool.
+void runNodePoolExperiment();
+
+
+// Measures how the throughput of ConcurrentHashSet::contains() scales as
+// more threads look up words at once.
+void runConcurrentHashSetExperiment();
+
+
+// Measures how long a PerfectHashSet takes to build and how much memory it
+// uses per word, and compares its lookups with those of a HashSet and a
+// FlatHashSet.
+void runPerfectHashSetExperiment();
+
+
+// Compares lookups in a CuckooHashSet with those in HashSets, for words
+// that are found (the word file and a text file) and that mostly aren't
+// (edits of the text file's words, like the ones suggestions come from).
+void runCuckooHashSetExperiment();
+
+
+// Compares how many nodes HashSets visit per lookup, with and without
+// self-organizing chains, when words are looked up with Zipf-distributed
+// frequencies (as they are in real text).
+void runSelfOrganizingExperiment();
+
+
+// Writes an index of the words in a word file, which a MappedHashSet can
+// open (and the shell can use as the "MAPPED HASH" search structure).
+void runWriteIndexTool();
+
+
+// Compares the time it takes to get a word set ready to use by loading a
+// word file into a HashSet with opening an index as a MappedHashSet, and
+// compares their lookups.
+void runMappedHashSetExperiment();
+
+
+// Measures how insertion throughput into a HashSet and an AVLSet changes
+// as they grow, doubling their sizes until they reach a memory limit.
+void runScalingExperiment();
+
+
+// Compares how many bytes each word takes up in an AVLSet and in a
+// CompactAVLSet, and how many lookups per second each can do.
+void runCompactAVLSetExperiment();
+
+
+// Measures how long it takes to copy and to clear large HashSets and
+// AVLSets, with one thread and with one per hardware thread.
+void runCopyDestroyExperiment();
+
+
+// Compares loading, looking up, and traversing the words of a word file,
+// and of a larger synthetic list of words, in an AVLSet, a CompactAVLSet,
+// and a BTreeSet.
+void runBTreeSetExperiment();
+
+
+// Compares adding and looking up words in an AVLSet and a
+// PersistentAVLSet, and copying an AVLSet with taking a snapshot of a
+// PersistentAVLSet.
+void runPersistentAVLSetExperiment();
+
+
+// Measures how many whole-string comparisons an AVLSet of words makes per
+// lookup, and how many lookups per second it does, looking up the words
+// of a text file and edits of them.
+void runKeyPrefixExperiment();
+
+
+
+#endif
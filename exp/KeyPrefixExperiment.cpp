@@ -0,0 +1,195 @@
+// KeyPrefixExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file, then the path to a text file.  The words
+// are loaded into an AVLSet, which then looks up three workloads:
+//
+//     Words     every word in the word file (all hits)
+//     Text      every word in the text file
+//     Edits     every word in the text file with each of its letters
+//               replaced by each letter from 'A' through 'Z', the way
+//               suggestions are generated (almost all misses)
+//
+// For each, the experiment reports how many times, on average, a lookup
+// compared the word it was searching for with a whole string in the set,
+// how many millions of contains() calls per second the set can do, and
+// how many of the words it found.
+//
+// The comparisons are counted by searching with lowerBound() (which takes
+// the same path down the tree as contains()) for a key that counts each
+// call to its compare() member function.  Comparisons settled by the
+// prefixes AVLSet stores in its nodes never call it.
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "AVLSet.hpp"
+#include "Experiments.hpp"
+#include "Stopwatch.hpp"
+#include "TextFileReader.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    constexpr unsigned int ROUNDS = 5;
+
+
+    // A CountingKey is searched for in an AVLSet in place of a string,
+    // counting how many times it's compared with one of the set's strings.
+    class CountingKey
+    {
+    public:
+        CountingKey(std::string_view word, std::size_t& comparisons)
+            : word{word}, comparisons{comparisons}
+        {
+        }
+
+        operator std::string_view() const noexcept
+        {
+            return word;
+        }
+
+        int compare(const std::string& value) const
+        {
+            comparisons++;
+            return word.compare(value);
+        }
+
+    private:
+        std::string_view word;
+        std::size_t& comparisons;
+    };
+
+
+    std::vector<std::string> readText(const std::string& textFilePath)
+    {
+        std::vector<std::string> words;
+        TextFileReader reader{textFilePath};
+
+        while (!reader.noMoreWords())
+        {
+            words.push_back(reader.currentWord());
+            reader.advanceToNextWord();
+        }
+
+        return words;
+    }
+
+
+    std::vector<std::string> makeEdits(const std::vector<std::string>& text)
+    {
+        std::vector<std::string> edits;
+
+        for (const std::string& word : text)
+        {
+            std::string edit = word;
+            for (unsigned int i = 0; i < word.size(); i++)
+            {
+                for (char letter = 'A'; letter <= 'Z'; letter++)
+                {
+                    edit[i] = letter;
+                    edits.push_back(edit);
+                }
+                edit[i] = word[i];
+            }
+        }
+
+        return edits;
+    }
+
+
+    double comparisonsPerLookup(
+        const AVLSet<std::string>& set, const std::vector<std::string>& lookups)
+    {
+        std::size_t comparisons = 0;
+
+        for (const std::string& word : lookups)
+        {
+            set.lowerBound(CountingKey{word, comparisons});
+        }
+
+        return static_cast<double>(comparisons) / lookups.size();
+    }
+
+
+    // lookupsPerSecond() returns how many millions of contains() calls the
+    // set does per second, and sets found to how many words it found
+    double lookupsPerSecond(
+        const AVLSet<std::string>& set, const std::vector<std::string>& lookups,
+        std::size_t& found)
+    {
+        Stopwatch stopwatch;
+        found = 0;
+
+        stopwatch.start();
+        for (unsigned int round = 0; round < ROUNDS; round++)
+        {
+            for (const std::string& word : lookups)
+            {
+                if (set.contains(word))
+                {
+                    found++;
+                }
+            }
+        }
+        stopwatch.stop();
+
+        found /= ROUNDS;
+        return static_cast<double>(lookups.size()) * ROUNDS / stopwatch.lastDuration();
+    }
+
+
+    void runWorkload(
+        const std::string& name, const AVLSet<std::string>& set,
+        const std::vector<std::string>& lookups)
+    {
+        double comparisons = comparisonsPerLookup(set, lookups);
+
+        // reporting how many were found keeps the lookups from being
+        // optimized away
+        std::size_t found;
+        double lookupRate = lookupsPerSecond(set, lookups, found);
+
+        std::cout << std::left << std::setw(8) << name;
+        std::cout << std::right << std::setw(12) << lookups.size()
+                  << std::setw(12) << found
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(16) << comparisons
+                  << std::setw(16) << lookupRate
+                  << std::endl;
+    }
+}
+
+
+
+void runKeyPrefixExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::string textFilePath;
+    std::getline(std::cin, textFilePath);
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+
+    AVLSet<std::string> set;
+    set.addAll(words);
+
+    std::vector<std::string> text = readText(textFilePath);
+
+    std::cout << "Loaded " << set.size() << " words from " << wordFilePath
+              << " (height " << set.height() << ")" << std::endl;
+    std::cout << std::endl;
+    std::cout << "              Lookups       Found  Compares/lookup    MLookups/sec" << std::endl;
+
+    runWorkload("Words", set, words);
+    runWorkload("Text", set, text);
+    runWorkload("Edits", set, makeEdits(text));
+}
@@ -0,0 +1,152 @@
+// MappedHashSetExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// WRITE INDEX
+//   Input: the path to a word file, then the path of an index to write.
+//   The words are loaded and written as an index for a MappedHashSet.
+//
+// MAPPED HASH
+//   Input: the path to a word file, then the path of an index to write.
+//   After writing the index, reports how long it takes to get a set ready
+//   to use (loading the word file into a HashSet vs. opening the index),
+//   then how long each takes to look up every word, plus the same number
+//   of words that aren't in the set.
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Experiments.hpp"
+#include "HashSet.hpp"
+#include "MappedHashSet.hpp"
+#include "Set.hpp"
+#include "Stopwatch.hpp"
+#include "StringHashing.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    constexpr unsigned int ROUNDS = 5;
+
+
+    double timeLookups(
+        const Set<std::string>& set, const std::vector<std::string>& lookups)
+    {
+        Stopwatch stopwatch;
+        unsigned int found = 0;
+
+        stopwatch.start();
+        for (unsigned int round = 0; round < ROUNDS; round++)
+        {
+            for (const std::string& word : lookups)
+            {
+                if (set.contains(word))
+                {
+                    found++;
+                }
+            }
+        }
+        stopwatch.stop();
+
+        // keeps the lookups from being optimized away
+        if (found == 0)
+        {
+            std::cout << "(nothing found)" << std::endl;
+        }
+
+        return stopwatch.lastDuration();
+    }
+
+
+    void printRow(const std::string& name, double readyDuration, double lookupDuration)
+    {
+        std::cout << std::left << std::setw(16) << name;
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << readyDuration << "usec"
+                  << std::setw(12) << lookupDuration << "usec"
+                  << std::endl;
+    }
+
+
+    void writeIndex(const std::string& wordFilePath, const std::string& indexPath)
+    {
+        std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+
+        try
+        {
+            MappedHashSet::write(words, indexPath);
+            std::cout << "Wrote index of " << words.size() << " words to "
+                      << indexPath << std::endl;
+        }
+        catch (MappedHashSet::IndexException& e)
+        {
+            std::cout << "ERROR: " << e.reason() << std::endl;
+        }
+    }
+}
+
+
+
+void runWriteIndexTool()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::string indexPath;
+    std::getline(std::cin, indexPath);
+
+    writeIndex(wordFilePath, indexPath);
+}
+
+
+void runMappedHashSetExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::string indexPath;
+    std::getline(std::cin, indexPath);
+
+    writeIndex(wordFilePath, indexPath);
+
+    std::vector<std::string> lookups = WordSetLoader{}.load(wordFilePath);
+    unsigned int wordCount = lookups.size();
+    for (unsigned int i = 0; i < wordCount; i++)
+    {
+        lookups.push_back(lookups[i] + "#");
+    }
+
+    std::cout << std::endl;
+    std::cout << "                   ReadyTime  LookupTime" << std::endl;
+
+    Stopwatch stopwatch;
+
+    // the word file is read again here, since reading it is part of what
+    // a HashSet needs to do before it's ready
+    stopwatch.start();
+    HashSet<std::string> hashSet{hashStringAsProduct};
+    hashSet.addAll(WordSetLoader{}.load(wordFilePath));
+    stopwatch.stop();
+
+    printRow("HASH", stopwatch.lastDuration(), timeLookups(hashSet, lookups));
+
+    try
+    {
+        stopwatch.start();
+        MappedHashSet mappedSet{indexPath};
+        stopwatch.stop();
+
+        printRow("MAPPED HASH", stopwatch.lastDuration(), timeLookups(mappedSet, lookups));
+
+        std::cout << std::endl;
+        std::cout << "Index size: " << mappedSet.byteCount() << " bytes" << std::endl;
+    }
+    catch (MappedHashSet::IndexException& e)
+    {
+        std::cout << "ERROR: " << e.reason() << std::endl;
+    }
+}
@@ -0,0 +1,82 @@
+// NodePoolExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file.  The words are loaded into each kind of
+// set (with and without a NodePool), timing how long it takes to add them
+// and how long it takes to destroy the set afterward.
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AVLSet.hpp"
+#include "Experiments.hpp"
+#include "HashSet.hpp"
+#include "Stopwatch.hpp"
+#include "StringHashing.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    template <typename SetType>
+    void timeLoadAndDestroy(
+        const std::string& name, std::unique_ptr<SetType> set,
+        const std::vector<std::string>& words)
+    {
+        Stopwatch stopwatch;
+
+        stopwatch.start();
+        for (const std::string& word : words)
+        {
+            set->add(word);
+        }
+        stopwatch.stop();
+        double loadDuration = stopwatch.lastDuration();
+
+        NodePoolStats stats = set->poolStats();
+
+        stopwatch.start();
+        set.reset();
+        stopwatch.stop();
+        double destroyDuration = stopwatch.lastDuration();
+
+        std::cout << std::left << std::setw(16) << name;
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << loadDuration << "usec"
+                  << std::setw(12) << destroyDuration << "usec"
+                  << std::setw(12) << stats.slabs
+                  << std::setw(14) << stats.bytes << std::endl;
+    }
+}
+
+
+
+void runNodePoolExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+
+    std::cout << "Loaded " << words.size() << " words from " << wordFilePath << std::endl;
+    std::cout << std::endl;
+    std::cout << "                    LoadTime     DestroyTime  PoolSlabs     PoolBytes" << std::endl;
+
+    timeLoadAndDestroy(
+        "HASH", std::make_unique<HashSet<std::string>>(hashStringAsProduct), words);
+
+    timeLoadAndDestroy(
+        "HASH POOLED",
+        std::make_unique<HashSet<std::string>>(hashStringAsProduct, false, true), words);
+
+    timeLoadAndDestroy(
+        "AVL", std::make_unique<AVLSet<std::string>>(), words);
+
+    timeLoadAndDestroy(
+        "AVL POOLED", std::make_unique<AVLSet<std::string>>(true, true), words);
+}
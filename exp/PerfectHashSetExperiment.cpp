@@ -0,0 +1,138 @@
+// PerfectHashSetExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file.  The words are loaded into a
+// PerfectHashSet, a HashSet, and a FlatHashSet, reporting how long each
+// takes to build, roughly how many bytes of table each uses per word (not
+// counting the contents of the strings, which all of them store alike),
+// and how long each takes to look up every word, plus the same number of
+// words that aren't in the set.
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Experiments.hpp"
+#include "FlatHashSet.hpp"
+#include "HashSet.hpp"
+#include "PerfectHashSet.hpp"
+#include "Set.hpp"
+#include "Stopwatch.hpp"
+#include "StringHashing.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    constexpr unsigned int ROUNDS = 5;
+
+
+    double timeLookups(
+        const Set<std::string>& set, const std::vector<std::string>& lookups)
+    {
+        Stopwatch stopwatch;
+        unsigned int found = 0;
+
+        stopwatch.start();
+        for (unsigned int round = 0; round < ROUNDS; round++)
+        {
+            for (const std::string& word : lookups)
+            {
+                if (set.contains(word))
+                {
+                    found++;
+                }
+            }
+        }
+        stopwatch.stop();
+
+        // keeps the lookups from being optimized away
+        if (found == 0)
+        {
+            std::cout << "(nothing found)" << std::endl;
+        }
+
+        return stopwatch.lastDuration();
+    }
+
+
+    void printRow(
+        const std::string& name, double buildDuration, double bytesPerWord,
+        double lookupDuration)
+    {
+        std::cout << std::left << std::setw(16) << name;
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << buildDuration << "usec"
+                  << std::setprecision(1) << std::setw(14) << bytesPerWord
+                  << std::setprecision(0) << std::setw(12) << lookupDuration << "usec"
+                  << std::endl;
+    }
+}
+
+
+
+void runPerfectHashSetExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+
+    std::vector<std::string> lookups = words;
+    for (const std::string& word : words)
+    {
+        lookups.push_back(word + "#");
+    }
+
+    std::cout << "Loaded " << words.size() << " words from " << wordFilePath << std::endl;
+    std::cout << std::endl;
+    std::cout << "                   BuildTime  BytesPerWord  LookupTime" << std::endl;
+
+    Stopwatch stopwatch;
+
+    stopwatch.start();
+    PerfectHashSet<std::string> perfectSet{words};
+    stopwatch.stop();
+
+    printRow(
+        "PERFECT HASH", stopwatch.lastDuration(),
+        static_cast<double>(perfectSet.byteCount()) / perfectSet.size(),
+        timeLookups(perfectSet, lookups));
+
+    stopwatch.start();
+    HashSet<std::string> hashSet{hashStringAsProduct};
+    hashSet.reserve(words.size());
+    for (const std::string& word : words)
+    {
+        hashSet.add(word);
+    }
+    stopwatch.stop();
+
+    // a node (value, hash, and next) per word, plus one pointer per bucket,
+    // of which reserve() makes about one per 0.8 words
+    double hashBytes = static_cast<double>(hashSet.size()) * (sizeof(std::string) + 16)
+        + static_cast<double>(words.size()) / 0.8 * sizeof(void*);
+
+    printRow(
+        "HASH", stopwatch.lastDuration(), hashBytes / hashSet.size(),
+        timeLookups(hashSet, lookups));
+
+    stopwatch.start();
+    FlatHashSet<std::string> flatSet{hashStringAsProduct};
+    flatSet.reserve(words.size());
+    for (const std::string& word : words)
+    {
+        flatSet.add(word);
+    }
+    stopwatch.stop();
+
+    // one element and one control byte per slot
+    double flatBytes = static_cast<double>(flatSet.capacity()) * (sizeof(std::string) + 1);
+
+    printRow(
+        "FLAT HASH", stopwatch.lastDuration(), flatBytes / flatSet.size(),
+        timeLookups(flatSet, lookups));
+}
@@ -0,0 +1,179 @@
+// PersistentAVLSetExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file.  The words are added, one at a time, to
+// an AVLSet and to a PersistentAVLSet.  For each, the experiment reports
+// how long that took, how many millions of contains() calls per second it
+// can do (looking up every word in a shuffled order), and how long it
+// takes to get a copy of the set that later adds won't change: a deep copy
+// of the AVLSet, or a snapshot of the PersistentAVLSet.
+//
+// Then the words are added to a new PersistentAVLSet again, while another
+// thread repeatedly takes snapshots and looks up words in them, and the
+// experiment reports how many lookups it did in the meantime.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AVLSet.hpp"
+#include "Experiments.hpp"
+#include "PersistentAVLSet.hpp"
+#include "Set.hpp"
+#include "Stopwatch.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    constexpr unsigned int ROUNDS = 5;
+
+
+    template <typename SetType>
+    double timeAdds(SetType& set, const std::vector<std::string>& words)
+    {
+        Stopwatch stopwatch;
+
+        stopwatch.start();
+        for (const std::string& word : words)
+        {
+            set.add(word);
+        }
+        stopwatch.stop();
+
+        return stopwatch.lastDuration();
+    }
+
+
+    // lookupsPerSecond() returns how many millions of contains() calls the
+    // set does per second
+    double lookupsPerSecond(
+        const Set<std::string>& set, const std::vector<std::string>& lookups)
+    {
+        Stopwatch stopwatch;
+        unsigned int found = 0;
+
+        stopwatch.start();
+        for (unsigned int round = 0; round < ROUNDS; round++)
+        {
+            for (const std::string& word : lookups)
+            {
+                if (set.contains(word))
+                {
+                    found++;
+                }
+            }
+        }
+        stopwatch.stop();
+
+        // keeps the lookups from being optimized away
+        if (found == 0)
+        {
+            std::cout << "(nothing found)" << std::endl;
+        }
+
+        return static_cast<double>(lookups.size()) * ROUNDS / stopwatch.lastDuration();
+    }
+
+
+    void printRow(
+        const std::string& name, double loadDuration, double lookupRate,
+        double copyDuration)
+    {
+        std::cout << std::left << std::setw(16) << name;
+        std::cout << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << loadDuration << "usec"
+                  << std::setprecision(2) << std::setw(16) << lookupRate
+                  << std::setprecision(1) << std::setw(14) << copyDuration << "usec"
+                  << std::endl;
+    }
+}
+
+
+
+void runPersistentAVLSetExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+
+    std::vector<std::string> lookups = words;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937{46});
+
+    std::cout << "Loaded " << words.size() << " words from " << wordFilePath << std::endl;
+    std::cout << std::endl;
+    std::cout << "                    LoadTime    MLookups/sec  Copy/Snapshot" << std::endl;
+
+    Stopwatch stopwatch;
+
+    {
+        AVLSet<std::string> avlSet;
+        double loadDuration = timeAdds(avlSet, words);
+        double lookupRate = lookupsPerSecond(avlSet, lookups);
+
+        stopwatch.start();
+        AVLSet<std::string> copy{avlSet};
+        stopwatch.stop();
+
+        printRow("AVL", loadDuration, lookupRate, stopwatch.lastDuration());
+    }
+
+    {
+        PersistentAVLSet<std::string> persistentSet;
+        double loadDuration = timeAdds(persistentSet, words);
+        double lookupRate = lookupsPerSecond(persistentSet, lookups);
+
+        stopwatch.start();
+        PersistentAVLSet<std::string>::Snapshot snapshot = persistentSet.snapshot();
+        stopwatch.stop();
+
+        printRow("AVL PERSISTENT", loadDuration, lookupRate, stopwatch.lastDuration());
+    }
+
+    PersistentAVLSet<std::string> persistentSet;
+    std::atomic<bool> done{false};
+    std::size_t readerLookups = 0;
+    std::size_t readerFound = 0;
+    std::size_t snapshotsTaken = 0;
+
+    std::thread reader{
+        [&]()
+        {
+            for (std::size_t i = 0; !done; i = (i + 1) % lookups.size())
+            {
+                PersistentAVLSet<std::string>::Snapshot snapshot = persistentSet.snapshot();
+                snapshotsTaken++;
+
+                // a snapshot's contents never change, so a batch of lookups
+                // in one of them agree with one another
+                for (std::size_t j = 0; j < 100; j++)
+                {
+                    if (snapshot.contains(lookups[(i + j) % lookups.size()]))
+                    {
+                        readerFound++;
+                    }
+                    readerLookups++;
+                }
+            }
+        }};
+
+    double concurrentLoadDuration = timeAdds(persistentSet, words);
+    done = true;
+    reader.join();
+
+    std::cout << std::endl;
+    std::cout << "While adding every word again (" << std::setprecision(0)
+              << concurrentLoadDuration << "usec), another thread took "
+              << snapshotsTaken << " snapshots and did " << readerLookups
+              << " lookups in them, finding " << readerFound << " words" << std::endl;
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+}
@@ -0,0 +1,115 @@
+// ScalingExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: a memory limit, in megabytes.  64-bit integers are added to a
+// HashSet and then to an AVLSet, each growing from 2^16 elements and
+// doubling until the next doubling would take it past the limit.  After
+// each doubling, the experiment reports how long it took to add that
+// batch of elements and how many were added per microsecond, which shows
+// how each set's throughput holds up as it outgrows the processor's caches
+// (and, past 2^32 elements, as it goes where 32-bit sizes couldn't).
+//
+// The memory used is estimated from the size of each set's nodes rather
+// than measured, so leave some headroom when choosing the limit.
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "AVLSet.hpp"
+#include "Experiments.hpp"
+#include "HashSet.hpp"
+#include "Set.hpp"
+#include "Stopwatch.hpp"
+
+
+
+namespace
+{
+    constexpr std::size_t FIRST_SIZE = std::size_t{1} << 16;
+
+    // Roughly how many bytes each element costs, counting the allocator's
+    // overhead for each node (and, for the HashSet, its buckets).
+    constexpr std::size_t HASH_BYTES_PER_ELEMENT = 48;
+    constexpr std::size_t AVL_BYTES_PER_ELEMENT = 48;
+
+
+    // The elements are consecutive outputs of SplitMix64, which are all
+    // different and look random, so they can be their own hash values.
+    std::uint64_t element(std::uint64_t i)
+    {
+        std::uint64_t z = (i + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+
+    struct IdentityHash
+    {
+        std::size_t operator()(std::uint64_t value) const noexcept
+        {
+            return static_cast<std::size_t>(value);
+        }
+    };
+
+
+    void runDoublings(
+        const std::string& name, Set<std::uint64_t>& set,
+        std::size_t bytesPerElement, std::size_t memoryLimit)
+    {
+        std::cout << std::endl;
+        std::cout << name << std::endl;
+        std::cout << "        Elements          BatchTime  AddsPerUsec" << std::endl;
+
+        Stopwatch stopwatch;
+        std::size_t added = 0;
+
+        for (std::size_t target = FIRST_SIZE; target * bytesPerElement <= memoryLimit; target *= 2)
+        {
+            stopwatch.start();
+            for (; added < target; added++)
+            {
+                set.add(element(added));
+            }
+            stopwatch.stop();
+
+            std::size_t batch = target == FIRST_SIZE ? target : target / 2;
+
+            std::cout << std::right << std::setw(16) << set.size()
+                      << std::fixed << std::setprecision(0)
+                      << std::setw(15) << stopwatch.lastDuration() << "usec"
+                      << std::setprecision(2)
+                      << std::setw(13) << batch / stopwatch.lastDuration()
+                      << std::endl;
+        }
+
+        if (added == 0)
+        {
+            std::cout << "(the limit is too small for even " << FIRST_SIZE << " elements)" << std::endl;
+        }
+    }
+}
+
+
+
+void runScalingExperiment()
+{
+    std::string line;
+    std::getline(std::cin, line);
+
+    std::size_t memoryLimit = std::stoull(line) * 1024 * 1024;
+
+    {
+        HashSet<std::uint64_t, IdentityHash> hashSet{IdentityHash{}};
+        runDoublings("HASH", hashSet, HASH_BYTES_PER_ELEMENT, memoryLimit);
+    }
+
+    {
+        AVLSet<std::uint64_t> avlSet;
+        runDoublings("AVL", avlSet, AVL_BYTES_PER_ELEMENT, memoryLimit);
+    }
+}
@@ -0,0 +1,131 @@
+// SelfOrganizingExperiment.cpp
+//
+// ICS 46 Winter 2022
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Input: the path to a word file.  The words are shuffled and given Zipf-
+// distributed frequencies (the word of rank k is looked up in proportion
+// to 1/k, as words in real text roughly are), then a corpus of lookups is
+// drawn from them.  Each kind of HashSet looks up the whole corpus, once
+// with its chains left in insertion order and once self-organizing, and
+// the average number of nodes visited per lookup is reported along with
+// the time taken.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Experiments.hpp"
+#include "HashSet.hpp"
+#include "Stopwatch.hpp"
+#include "StringHashing.hpp"
+#include "WordSetLoader.hpp"
+
+
+
+namespace
+{
+    constexpr unsigned int CORPUS_SIZE = 1000000;
+    constexpr unsigned int RANDOM_SEED = 46;
+
+
+    std::vector<std::string> makeZipfCorpus(std::vector<std::string> words)
+    {
+        std::mt19937 engine{RANDOM_SEED};
+        std::shuffle(words.begin(), words.end(), engine);
+
+        std::vector<double> weights;
+        for (unsigned int rank = 1; rank <= words.size(); rank++)
+        {
+            weights.push_back(1.0 / rank);
+        }
+
+        std::discrete_distribution<unsigned int> distribution{weights.begin(), weights.end()};
+
+        std::vector<std::string> corpus;
+        corpus.reserve(CORPUS_SIZE);
+        for (unsigned int i = 0; i < CORPUS_SIZE; i++)
+        {
+            corpus.push_back(words[distribution(engine)]);
+        }
+
+        return corpus;
+    }
+
+
+    // makeSet() returns a HashSet with the given hash function holding
+    // every word, added in order
+    HashSet<std::string> makeSet(
+        HashSet<std::string>::HashFunction hashFunction, bool selfOrganizing,
+        const std::vector<std::string>& words)
+    {
+        HashSet<std::string> set{hashFunction, false, false, selfOrganizing};
+        set.reserve(words.size());
+        for (const std::string& word : words)
+        {
+            set.add(word);
+        }
+        return set;
+    }
+
+
+    void timeCorpus(
+        const std::string& name, HashSet<std::string>::HashFunction hashFunction,
+        bool selfOrganizing, const std::vector<std::string>& words,
+        const std::vector<std::string>& corpus)
+    {
+        // the nodes are counted by searching a second set, built the same
+        // way (so its chains start out in the same order), so that counting
+        // them doesn't slow down the timed search
+        HashSet<std::string> counted = makeSet(hashFunction, selfOrganizing, words);
+        counted.countNodesVisited(true);
+        for (const std::string& word : corpus)
+        {
+            counted.contains(word);
+        }
+
+        HashSet<std::string> set = makeSet(hashFunction, selfOrganizing, words);
+        Stopwatch stopwatch;
+
+        stopwatch.start();
+        for (const std::string& word : corpus)
+        {
+            set.contains(word);
+        }
+        stopwatch.stop();
+
+        double visited = static_cast<double>(counted.nodesVisited());
+
+        std::cout << std::left << std::setw(28) << name;
+        std::cout << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << visited / corpus.size()
+                  << std::setprecision(0) << std::setw(12) << stopwatch.lastDuration()
+                  << "usec" << std::endl;
+    }
+}
+
+
+
+void runSelfOrganizingExperiment()
+{
+    std::string wordFilePath;
+    std::getline(std::cin, wordFilePath);
+
+    std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+    std::vector<std::string> corpus = makeZipfCorpus(words);
+
+    std::cout << "Loaded " << words.size() << " words from " << wordFilePath << std::endl;
+    std::cout << "Looking up " << corpus.size() << " Zipf-distributed words" << std::endl;
+    std::cout << std::endl;
+    std::cout << "                            NodesVisited        Time" << std::endl;
+
+    for (bool selfOrganizing : {false, true})
+    {
+        std::string suffix = selfOrganizing ? " SELF ORGANIZING" : "";
+
+        timeCorpus("HASH SUM" + suffix, hashStringAsSum, selfOrganizing, words, corpus);
+        timeCorpus("HASH PRODUCT" + suffix, hashStringAsProduct, selfOrganizing, words, corpus);
+    }
+}
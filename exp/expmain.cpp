@@ -6,12 +6,75 @@
 // Do whatever you'd like here.  This is intended to allow you to experiment
 // with your code, outside of the context of the broader program or Google
 // Test.
+//
+// The first line of input names the experiment to run (see Experiments.hpp).
+
+#include <iostream>
+#include <string>
+#include "Experiments.hpp"
 
 
 int main()
 {
+    std::string experiment;
+    std::getline(std::cin, experiment);
 
+    if (experiment == "NODE POOL")
+    {
+        runNodePoolExperiment();
+    }
+    else if (experiment == "CONCURRENT HASH")
+    {
+        runConcurrentHashSetExperiment();
+    }
+    else if (experiment == "PERFECT HASH")
+    {
+        runPerfectHashSetExperiment();
+    }
+    else if (experiment == "CUCKOO HASH")
+    {
+        runCuckooHashSetExperiment();
+    }
+    else if (experiment == "SELF ORGANIZING")
+    {
+        runSelfOrganizingExperiment();
+    }
+    else if (experiment == "WRITE INDEX")
+    {
+        runWriteIndexTool();
+    }
+    else if (experiment == "MAPPED HASH")
+    {
+        runMappedHashSetExperiment();
+    }
+    else if (experiment == "SCALING")
+    {
+        runScalingExperiment();
+    }
+    else if (experiment == "COMPACT AVL")
+    {
+        runCompactAVLSetExperiment();
+    }
+    else if (experiment == "COPY DESTROY")
+    {
+        runCopyDestroyExperiment();
+    }
+    else if (experiment == "BTREE")
+    {
+        runBTreeSetExperiment();
+    }
+    else if (experiment == "PERSISTENT AVL")
+    {
+        runPersistentAVLSetExperiment();
+    }
+    else if (experiment == "KEY PREFIX")
+    {
+        runKeyPrefixExperiment();
+    }
+    else
+    {
+        std::cout << "ERROR: Invalid experiment: " << experiment << std::endl;
+    }
 
     return 0;
 }
-
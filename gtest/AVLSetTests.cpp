@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 #include "AVLSet.hpp"
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 
 void visitI(const int& e)
@@ -323,5 +326,510 @@ TEST(AVLSetTests, simpleRLRotationBalance)
 }
 
 
+TEST(AVLSetTests, containsStringViews)
+{
+    AVLSet<std::string> a;
+    a.add("apple");
+    a.add("banana");
+    a.add("cherry");
+
+    std::string buffer = "bananas";
+    std::string_view view{buffer};
+    EXPECT_TRUE(a.contains(view.substr(0, 6)));
+    EXPECT_FALSE(a.contains(view));
+    EXPECT_FALSE(a.contains(view.substr(0, 3)));
+
+    const Set<std::string>& s = a;
+    EXPECT_TRUE(s.contains(std::string_view{"cherry"}));
+    EXPECT_TRUE(s.contains("apple"));
+}
+
+
+namespace
+{
+    // Counted wraps an int and counts how many times elements are compared
+    // with compare() and with <.
+    struct Counted
+    {
+        int value;
+
+        static inline unsigned int compares = 0;
+        static inline unsigned int lessThans = 0;
+
+        int compare(const Counted& other) const
+        {
+            compares++;
+            return (value < other.value) ? -1 : ((other.value < value) ? 1 : 0);
+        }
+
+        bool operator<(const Counted& other) const
+        {
+            lessThans++;
+            return value < other.value;
+        }
+    };
+}
+
+
+TEST(AVLSetTests, comparesOnceWithEachNodeOnThePath)
+{
+    AVLSet<Counted> a;
+    for (int i = 0; i < 1000; i++)
+    {
+        a.add(Counted{i});
+    }
+    EXPECT_EQ(1000, a.size());
+    EXPECT_EQ(0, Counted::lessThans);
+
+    Counted::compares = 0;
+    EXPECT_TRUE(a.contains(Counted{500}));
+    EXPECT_LE(Counted::compares, a.height() + 1);
+
+    Counted::compares = 0;
+    a.add(Counted{1000});
+    EXPECT_LE(Counted::compares, a.height() + 1);
+    EXPECT_EQ(0, Counted::lessThans);
+}
+
+
+TEST(AVLSetTests, balancedTreeStaysShallowWhateverTheOrder)
+{
+    AVLSet<int> ascending;
+    AVLSet<int> descending;
+    AVLSet<int> zigzag;
+    for (int i = 0; i < 4096; i++)
+    {
+        ascending.add(i);
+        descending.add(-i);
+        zigzag.add((i % 2 == 0) ? i : -i);
+    }
+
+    // an AVL tree with n nodes is never taller than about 1.44 log2 n
+    EXPECT_LE(ascending.height(), 17);
+    EXPECT_LE(descending.height(), 17);
+    EXPECT_LE(zigzag.height(), 17);
+
+    for (int i = 0; i < 4096; i++)
+    {
+        ASSERT_TRUE(ascending.contains(i));
+        ASSERT_TRUE(descending.contains(-i));
+    }
+}
+
+
+TEST(AVLSetTests, unbalancedTreeCanGrowDeeperThanAnyBalancedOne)
+{
+    AVLSet<int> a{false};
+    for (int i = 0; i < 500; i++)
+    {
+        a.add(i);
+    }
+    a.add(250);
+
+    EXPECT_EQ(500, a.size());
+    EXPECT_EQ(499, a.height());
+    EXPECT_TRUE(a.contains(499));
+    EXPECT_FALSE(a.contains(500));
+}
+
+
+TEST(AVLSetTests, assignSortedBuildsPerfectlyBalancedTree)
+{
+    AVLSet<int> a;
+    a.assignSorted(std::vector<int>{1, 2, 3, 4, 5, 6, 7});
+
+    EXPECT_EQ(7, a.size());
+    EXPECT_EQ(2, a.height());
+
+    std::vector<int> preorder;
+    a.preorder([&](const int& e) { preorder.push_back(e); });
+    EXPECT_EQ((std::vector<int>{4, 2, 1, 3, 6, 5, 7}), preorder);
+
+    std::vector<int> many;
+    for (int i = 0; i < 1000; i++)
+    {
+        many.push_back(i);
+    }
+
+    AVLSet<int> b;
+    b.assignSorted(many);
+
+    // a perfectly balanced tree with n nodes has height floor(log2 n)
+    EXPECT_EQ(1000, b.size());
+    EXPECT_EQ(9, b.height());
+
+    for (int i = 0; i < 1000; i++)
+    {
+        ASSERT_TRUE(b.contains(i));
+    }
+    EXPECT_FALSE(b.contains(1000));
+
+    // heights are right everywhere, so adding more keeps it balanced
+    for (int i = 1000; i < 2000; i++)
+    {
+        b.add(i);
+    }
+    EXPECT_EQ(2000, b.size());
+    EXPECT_LE(b.height(), 12);
+}
+
+
+TEST(AVLSetTests, assignSortedSkipsDuplicatesAndReplacesElements)
+{
+    AVLSet<std::string> a;
+    a.add("ZEBRA");
+    a.assignSorted(std::vector<std::string>{"ALPHA", "ALPHA", "BETA", "GAMMA", "GAMMA"});
+
+    EXPECT_EQ(3, a.size());
+    EXPECT_EQ(1, a.height());
+    EXPECT_TRUE(a.contains("ALPHA"));
+    EXPECT_TRUE(a.contains("BETA"));
+    EXPECT_TRUE(a.contains("GAMMA"));
+    EXPECT_FALSE(a.contains("ZEBRA"));
+}
+
+
+TEST(AVLSetTests, assignSortedAddsUnsortedElementsOneAtATime)
+{
+    AVLSet<int> a;
+    a.assignSorted(std::vector<int>{5, 1, 4, 2, 3, 1});
+
+    EXPECT_EQ(5, a.size());
+    EXPECT_LE(a.height(), 2);
+
+    std::vector<int> inorder;
+    a.inorder([&](const int& e) { inorder.push_back(e); });
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5}), inorder);
+}
+
+
+TEST(AVLSetTests, addAllBuildsSortedElementsIntoEmptySet)
+{
+    std::vector<int> elements;
+    for (int i = 0; i < 255; i++)
+    {
+        elements.push_back(i * 2);
+    }
+
+    AVLSet<int> a{true, true};
+    a.addAll(elements);
+    EXPECT_EQ(255, a.size());
+    EXPECT_EQ(7, a.height());
+
+    // once the set isn't empty, elements are added to what's already there
+    a.addAll(std::vector<int>{1, 3, 0});
+    EXPECT_EQ(257, a.size());
+    EXPECT_TRUE(a.contains(0));
+    EXPECT_TRUE(a.contains(3));
+    EXPECT_TRUE(a.contains(508));
+}
+
+
+TEST(AVLSetTests, sortedElementsAreNotBalancedWhenBalancingIsTurnedOff)
+{
+    std::vector<int> elements{1, 2, 3, 4, 5, 6, 7};
+
+    AVLSet<int> a{false};
+    a.addAll(elements);
+    EXPECT_EQ(7, a.size());
+    EXPECT_EQ(6, a.height());
+
+    AVLSet<int> b{false};
+    b.assignSorted(elements);
+    EXPECT_EQ(7, b.size());
+    EXPECT_EQ(6, b.height());
+    EXPECT_TRUE(b.contains(7));
+}
+
+
+TEST(AVLSetTests, lowerBoundFindsSmallestElementNotLessThanKey)
+{
+    AVLSet<int> a;
+    for (int i = 0; i < 100; i += 10)
+    {
+        a.add(i);
+    }
+
+    ASSERT_NE(nullptr, a.lowerBound(30));
+    EXPECT_EQ(30, *a.lowerBound(30));
+    EXPECT_EQ(40, *a.lowerBound(31));
+    EXPECT_EQ(0, *a.lowerBound(-5));
+    EXPECT_EQ(90, *a.lowerBound(90));
+    EXPECT_EQ(nullptr, a.lowerBound(91));
+
+    AVLSet<int> empty;
+    EXPECT_EQ(nullptr, empty.lowerBound(0));
+}
+
+
+TEST(AVLSetTests, forEachInRangeVisitsOnlyElementsInRangeInOrder)
+{
+    AVLSet<int> a;
+    for (int i = 99; i >= 0; i--)
+    {
+        a.add(i * 2);
+    }
+
+    std::vector<int> visited;
+    std::size_t count = a.forEachInRange(9, 20, [&](const int& e) { visited.push_back(e); });
+    EXPECT_EQ(5, count);
+    EXPECT_EQ((std::vector<int>{10, 12, 14, 16, 18}), visited);
+
+    // the next 3 elements after 100
+    visited.clear();
+    count = a.forEachInRange(101, 1000, [&](const int& e) { visited.push_back(e); }, 3);
+    EXPECT_EQ(3, count);
+    EXPECT_EQ((std::vector<int>{102, 104, 106}), visited);
+
+    visited.clear();
+    EXPECT_EQ(0, a.forEachInRange(11, 12, [&](const int& e) { visited.push_back(e); }));
+    EXPECT_EQ(0, a.forEachInRange(500, 600, [&](const int& e) { visited.push_back(e); }));
+    EXPECT_TRUE(visited.empty());
+
+    // the whole set, in ascending order
+    count = a.forEachInRange(-1, 1000, [&](const int& e) { visited.push_back(e); });
+    EXPECT_EQ(100, count);
+    EXPECT_TRUE(std::is_sorted(visited.begin(), visited.end()));
+}
+
+
+TEST(AVLSetTests, forEachWithPrefixVisitsMatchingStrings)
+{
+    AVLSet<std::string> a;
+    for (std::string word : {"CAR", "CART", "CARTON", "CARD", "CAT", "CA", "BOAT", "CB", "DOG"})
+    {
+        a.add(word);
+    }
+
+    std::vector<std::string> visited;
+    auto collect = [&](const std::string& e) { visited.push_back(e); };
+
+    EXPECT_EQ(4, a.forEachWithPrefix("CAR", collect));
+    EXPECT_EQ((std::vector<std::string>{"CAR", "CARD", "CART", "CARTON"}), visited);
+
+    visited.clear();
+    EXPECT_EQ(2, a.forEachWithPrefix("CA", collect, 2));
+    EXPECT_EQ((std::vector<std::string>{"CA", "CAR"}), visited);
+
+    visited.clear();
+    EXPECT_EQ(0, a.forEachWithPrefix("CAX", collect));
+    EXPECT_EQ(0, a.forEachWithPrefix("E", collect));
+    EXPECT_EQ(9, a.forEachWithPrefix("", collect));
+}
+
+
+TEST(AVLSetTests, rangeQueriesWorkWithoutBalancing)
+{
+    AVLSet<int> a{false};
+    for (int i = 0; i < 1000; i++)
+    {
+        a.add(i);
+    }
+
+    std::vector<int> visited;
+    EXPECT_EQ(10, a.forEachInRange(990, 2000, [&](const int& e) { visited.push_back(e); }));
+    EXPECT_EQ(990, visited.front());
+    EXPECT_EQ(999, visited.back());
+    EXPECT_EQ(999, *a.lowerBound(999));
+}
+
+
+TEST(AVLSetTests, iteratorVisitsElementsInAscendingOrder)
+{
+    AVLSet<int> a;
+    EXPECT_TRUE(a.begin() == a.end());
+
+    for (int i : {50, 20, 80, 10, 30, 70, 90, 60, 40})
+    {
+        a.add(i);
+    }
+
+    std::vector<int> visited;
+    for (const int& e : a)
+    {
+        visited.push_back(e);
+    }
+    EXPECT_EQ((std::vector<int>{10, 20, 30, 40, 50, 60, 70, 80, 90}), visited);
+
+    AVLSet<int>::ConstIterator i = a.begin();
+    EXPECT_EQ(10, *i);
+    EXPECT_EQ(10, *i++);
+    EXPECT_EQ(20, *i);
+    EXPECT_EQ(30, *++i);
+    EXPECT_TRUE(i != a.begin());
+    EXPECT_EQ(9, std::distance(a.begin(), a.end()));
+
+    AVLSet<std::string> s;
+    s.add("HELLO");
+    EXPECT_EQ(5, s.begin()->length());
+}
+
+
+TEST(AVLSetTests, traversalsAcceptAnyCallable)
+{
+    AVLSet<int> a{false};
+    a.add(10);
+    a.add(5);
+    a.add(13);
+    a.add(14);
+    a.add(7);
+    a.add(6);
+
+    std::vector<int> visited;
+    a.preorder([&](const int& e) { visited.push_back(e); });
+    EXPECT_EQ((std::vector<int>{10, 5, 7, 6, 13, 14}), visited);
+
+    visited.clear();
+    a.inorder([&](const int& e) { visited.push_back(e); });
+    EXPECT_EQ((std::vector<int>{5, 6, 7, 10, 13, 14}), visited);
+
+    visited.clear();
+    a.postorder([&](const int& e) { visited.push_back(e); });
+    EXPECT_EQ((std::vector<int>{6, 7, 5, 14, 13, 10}), visited);
+
+    // a std::function still works, and so does a callable with state
+    int sum = 0;
+    AVLSet<int>::VisitFunction add = [&](const int& e) { sum += e; };
+    a.inorder(add);
+    EXPECT_EQ(55, sum);
 
+    struct Counter
+    {
+        int count = 0;
+        void operator()(const int&) { count++; }
+    };
+
+    Counter counter;
+    a.postorder(counter);
+    EXPECT_EQ(6, counter.count);
+}
+
+
+TEST(AVLSetTests, traversalsOfTallUnbalancedTreeDoNotRecurse)
+{
+    AVLSet<int> a{false};
+    for (int i = 5000; i > 0; i--)
+    {
+        a.add(i);
+    }
+    EXPECT_EQ(4999, a.height());
+
+    int expected = 5000;
+    bool inOrder = true;
+    a.preorder([&](const int& e) { inOrder = inOrder && e == expected--; });
+    EXPECT_TRUE(inOrder);
+
+    expected = 1;
+    a.inorder([&](const int& e) { inOrder = inOrder && e == expected++; });
+    EXPECT_TRUE(inOrder);
+
+    expected = 1;
+    a.postorder([&](const int& e) { inOrder = inOrder && e == expected++; });
+    EXPECT_TRUE(inOrder);
+
+    EXPECT_EQ(5000, std::distance(a.begin(), a.end()));
+}
+
+
+TEST(AVLSetTests, copyInParallelKeepsShapeAndElements)
+{
+    for (bool usePool : {false, true})
+    {
+        AVLSet<int> a{true, usePool};
+        for (int i = 0; i < 100000; i++)
+        {
+            a.add((i * 7919) % 100000);
+        }
+
+        AVLSet<int> copy{a, 4};
+        EXPECT_EQ(100000, copy.size());
+        EXPECT_EQ(a.height(), copy.height());
+
+        std::vector<int> original;
+        std::vector<int> copied;
+        a.preorder([&](const int& e) { original.push_back(e); });
+        copy.preorder([&](const int& e) { copied.push_back(e); });
+        EXPECT_EQ(original, copied);
+
+        copy.add(-1);
+        EXPECT_TRUE(copy.contains(-1));
+        EXPECT_FALSE(a.contains(-1));
+    }
+}
+
+
+TEST(AVLSetTests, clearInParallelEmptiesTheSet)
+{
+    for (bool usePool : {false, true})
+    {
+        AVLSet<int> a{true, usePool};
+        for (int i = 0; i < 100000; i++)
+        {
+            a.add(i);
+        }
+
+        a.clear(4);
+        EXPECT_EQ(0, a.size());
+        EXPECT_EQ(-1, a.height());
+        EXPECT_FALSE(a.contains(0));
+        EXPECT_TRUE(a.begin() == a.end());
+
+        a.add(5);
+        a.add(3);
+        EXPECT_EQ(2, a.size());
+        EXPECT_TRUE(a.contains(3));
+    }
+}
+
+
+TEST(AVLSetTests, copyOfTallUnbalancedTreeDoesNotRecurse)
+{
+    AVLSet<int> a{false};
+    for (int i = 0; i < 5000; i++)
+    {
+        a.add(i);
+    }
+
+    AVLSet<int> copy{a};
+    EXPECT_EQ(5000, copy.size());
+    EXPECT_EQ(4999, copy.height());
+    EXPECT_TRUE(copy.contains(4999));
+
+    copy.clear();
+    EXPECT_EQ(0, copy.size());
+}
 
+
+TEST(AVLSetTests, stringsWithTheSamePrefixAreComparedInFull)
+{
+    // the first 8 characters of these are all the same, so comparing
+    // their nodes' prefixes can't tell them apart, while the others differ
+    // only in length or by a null character within the first 8
+    std::vector<std::string> words{
+        "abcdefgh", "abcdefghi", "abcdefgh" + std::string(1, '\0'), "abcdefghz",
+        "abcdefg", "abcdefg" + std::string(1, '\0'), "", "abc", "abcdefgha",
+        "ABCDEFGH", "\xff\xff"};
+
+    AVLSet<std::string> s;
+    for (const std::string& word : words)
+    {
+        s.add(word);
+    }
+    s.add("abcdefghi");
+
+    EXPECT_EQ(words.size(), s.size());
+
+    for (const std::string& word : words)
+    {
+        EXPECT_TRUE(s.contains(word));
+    }
+    EXPECT_FALSE(s.contains("abcdefghj"));
+    EXPECT_FALSE(s.contains(std::string_view{"abcdef"}));
+
+    std::sort(words.begin(), words.end());
+    std::vector<std::string> visited;
+    s.inorder([&](const std::string& e) { visited.push_back(e); });
+    EXPECT_EQ(words, visited);
+
+    EXPECT_EQ("abcdefgha", *s.lowerBound(std::string_view{"abcdefgh\x01"}));
+}
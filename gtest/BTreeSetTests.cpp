@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BTreeSet.hpp"
+
+
+TEST(BTreeSetTests, constructedSetIsEmpty)
+{
+    BTreeSet<int> s;
+    EXPECT_TRUE(s.isImplemented());
+    EXPECT_EQ(0, s.size());
+    EXPECT_EQ(-1, s.height());
+    EXPECT_EQ(0, s.nodeCount());
+    EXPECT_FALSE(s.contains(0));
+    EXPECT_TRUE(s.begin() == s.end());
+}
+
+
+TEST(BTreeSetTests, containsAddedElements)
+{
+    BTreeSet<int> s;
+    s.add(10);
+    s.add(5);
+    s.add(13);
+    s.add(5);
+
+    EXPECT_EQ(3, s.size());
+    EXPECT_EQ(0, s.height());
+    EXPECT_TRUE(s.contains(10));
+    EXPECT_TRUE(s.contains(5));
+    EXPECT_TRUE(s.contains(13));
+    EXPECT_FALSE(s.contains(7));
+}
+
+
+TEST(BTreeSetTests, nodesSplitAsTheTreeGrows)
+{
+    BTreeSet<int> s;
+    std::set<int> expected;
+    std::mt19937 random{46};
+
+    for (int i = 0; i < 100000; i++)
+    {
+        int value = static_cast<int>(random() % 200000);
+        s.add(value);
+        expected.insert(value);
+    }
+
+    ASSERT_EQ(expected.size(), s.size());
+    EXPECT_GE(s.height(), 2);
+
+    for (int i = 0; i < 200000; i++)
+    {
+        ASSERT_EQ(expected.count(i) == 1, s.contains(i));
+    }
+
+    std::vector<int> visited;
+    s.inorder([&](const int& e) { visited.push_back(e); });
+    EXPECT_TRUE(std::equal(visited.begin(), visited.end(), expected.begin(), expected.end()));
+}
+
+
+TEST(BTreeSetTests, ascendingAndDescendingAddsStayShallow)
+{
+    BTreeSet<int> ascending;
+    BTreeSet<int> descending;
+    for (int i = 0; i < 100000; i++)
+    {
+        ascending.add(i);
+        descending.add(-i);
+    }
+
+    // every node but the root is at least half full, so even adding in
+    // order leaves the tree no taller than log base MAX_KEYS / 2 of n
+    EXPECT_LE(ascending.height(), 6);
+    EXPECT_LE(descending.height(), 6);
+
+    int expected = 0;
+    for (int value : ascending)
+    {
+        ASSERT_EQ(expected++, value);
+    }
+    EXPECT_EQ(100000, expected);
+}
+
+
+TEST(BTreeSetTests, stringsWithTheSamePrefixAreComparedInFull)
+{
+    // these all have the same first 8 characters, so their prefixes are
+    // the same, and some differ only in length or by a null character
+    std::vector<std::string> words{
+        "abcdefgh", "abcdefghi", "abcdefgh" + std::string(1, '\0'), "abcdefghz",
+        "abcdefg", "abcdefg" + std::string(1, '\0'), "", "abc", "abcdefgha"};
+
+    BTreeSet<std::string> s;
+    for (int i = 0; i < 1000; i++)
+    {
+        s.add("abcdefgh" + std::to_string(i));
+    }
+    for (const std::string& word : words)
+    {
+        s.add(word);
+    }
+
+    EXPECT_EQ(1000 + words.size(), s.size());
+
+    for (const std::string& word : words)
+    {
+        EXPECT_TRUE(s.contains(word)) << word;
+    }
+    EXPECT_TRUE(s.contains("abcdefgh999"));
+    EXPECT_FALSE(s.contains("abcdefgh1000"));
+    EXPECT_FALSE(s.contains(std::string_view{"abcdefg"}.substr(0, 6)));
+
+    std::vector<std::string> visited{s.begin(), s.end()};
+    EXPECT_TRUE(std::is_sorted(visited.begin(), visited.end()));
+    EXPECT_EQ(s.size(), visited.size());
+}
+
+
+TEST(BTreeSetTests, rangeQueriesMatchAnOrderedSet)
+{
+    BTreeSet<int> s;
+    std::set<int> expected;
+    for (int i = 0; i < 5000; i += 3)
+    {
+        s.add(i);
+        expected.insert(i);
+    }
+
+    for (int lo = -5; lo < 5005; lo += 97)
+    {
+        const int* bound = s.lowerBound(lo);
+        auto expectedBound = expected.lower_bound(lo);
+
+        if (expectedBound == expected.end())
+        {
+            EXPECT_EQ(nullptr, bound);
+        }
+        else
+        {
+            ASSERT_NE(nullptr, bound);
+            EXPECT_EQ(*expectedBound, *bound);
+        }
+
+        std::vector<int> visited;
+        std::size_t count = s.forEachInRange(lo, lo + 50, [&](int e) { visited.push_back(e); });
+
+        std::vector<int> inRange{expectedBound, expected.lower_bound(lo + 50)};
+        EXPECT_EQ(inRange, visited);
+        EXPECT_EQ(inRange.size(), count);
+    }
+
+    std::vector<int> limited;
+    EXPECT_EQ(4, s.forEachInRange(0, 5000, [&](int e) { limited.push_back(e); }, 4));
+    EXPECT_EQ((std::vector<int>{0, 3, 6, 9}), limited);
+}
+
+
+TEST(BTreeSetTests, prefixQueriesVisitMatchingStringsInOrder)
+{
+    BTreeSet<std::string> s;
+    for (const char* word : {"car", "card", "care", "careful", "cart", "cat", "ca", "dog", "c"})
+    {
+        s.add(word);
+    }
+
+    std::vector<std::string> visited;
+    EXPECT_EQ(5, s.forEachWithPrefix("car", [&](const std::string& e) { visited.push_back(e); }));
+    EXPECT_EQ((std::vector<std::string>{"car", "card", "care", "careful", "cart"}), visited);
+
+    EXPECT_EQ(0, s.forEachWithPrefix("cb", [](const std::string&) { }));
+    EXPECT_EQ(9, s.forEachWithPrefix("", [](const std::string&) { }));
+    EXPECT_EQ("dog", *s.lowerBound(std::string_view{"cz"}));
+}
+
+
+TEST(BTreeSetTests, copiesAndMovesAreIndependent)
+{
+    BTreeSet<std::string> s;
+    for (int i = 0; i < 2000; i++)
+    {
+        s.add("word" + std::to_string(i));
+    }
+
+    BTreeSet<std::string> copy{s};
+    copy.add("extra");
+    EXPECT_EQ(2001, copy.size());
+    EXPECT_EQ(2000, s.size());
+    EXPECT_FALSE(s.contains("extra"));
+    EXPECT_EQ(s.nodeCount(), BTreeSet<std::string>{s}.nodeCount());
+
+    BTreeSet<std::string> moved{std::move(copy)};
+    EXPECT_EQ(2001, moved.size());
+    EXPECT_TRUE(moved.contains("word1999"));
+    EXPECT_EQ(0, copy.size());
+
+    copy = moved;
+    EXPECT_TRUE(copy.contains("extra"));
+    EXPECT_TRUE(std::equal(copy.begin(), copy.end(), moved.begin(), moved.end()));
+}
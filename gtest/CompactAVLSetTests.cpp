@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CompactAVLSet.hpp"
+
+
+TEST(CompactAVLSetTests, constructedSetIsEmpty)
+{
+    CompactAVLSet<int> s;
+    EXPECT_TRUE(s.isImplemented());
+    EXPECT_EQ(0, s.size());
+    EXPECT_EQ(-1, s.height());
+    EXPECT_EQ(0, s.capacity());
+    EXPECT_FALSE(s.contains(0));
+}
+
+
+TEST(CompactAVLSetTests, containsAddedElements)
+{
+    CompactAVLSet<int> s;
+    s.add(10);
+    s.add(5);
+    s.add(13);
+    s.add(5);
+
+    EXPECT_EQ(3, s.size());
+    EXPECT_TRUE(s.contains(10));
+    EXPECT_TRUE(s.contains(5));
+    EXPECT_TRUE(s.contains(13));
+    EXPECT_FALSE(s.contains(7));
+}
+
+
+TEST(CompactAVLSetTests, rotationsKeepTreeBalanced)
+{
+    // each of these orders needs a different rotation
+    std::vector<std::vector<int>> orders{{3, 2, 1}, {1, 2, 3}, {3, 1, 2}, {1, 3, 2}};
+
+    for (const std::vector<int>& order : orders)
+    {
+        CompactAVLSet<int> s;
+        for (int i : order)
+        {
+            s.add(i);
+        }
+
+        EXPECT_EQ(1, s.height());
+
+        std::vector<int> visited;
+        s.inorder([&](const int& e) { visited.push_back(e); });
+        EXPECT_EQ((std::vector<int>{1, 2, 3}), visited);
+    }
+}
+
+
+TEST(CompactAVLSetTests, heightsBeyondThreeBitsArePackedCorrectly)
+{
+    CompactAVLSet<int> ascending;
+    CompactAVLSet<int> zigzag;
+    for (int i = 0; i < 100000; i++)
+    {
+        ascending.add(i);
+        zigzag.add((i % 2 == 0) ? i : -i);
+    }
+
+    // ascending order builds a nearly perfect tree; no AVL tree with this
+    // many nodes is taller than about 1.44 log2 n
+    EXPECT_EQ(16, ascending.height());
+    EXPECT_LE(zigzag.height(), 24);
+
+    for (int i = 0; i < 100000; i++)
+    {
+        ASSERT_TRUE(ascending.contains(i));
+        ASSERT_TRUE(zigzag.contains((i % 2 == 0) ? i : -i));
+    }
+    EXPECT_FALSE(ascending.contains(100000));
+}
+
+
+TEST(CompactAVLSetTests, arrayDoublesWhenFull)
+{
+    CompactAVLSet<int> s;
+    s.add(1);
+    EXPECT_EQ(CompactAVLSet<int>::DEFAULT_CAPACITY, s.capacity());
+
+    for (std::size_t i = 1; i <= CompactAVLSet<int>::DEFAULT_CAPACITY; i++)
+    {
+        s.add(static_cast<int>(i) + 1);
+    }
+    EXPECT_EQ(2 * CompactAVLSet<int>::DEFAULT_CAPACITY, s.capacity());
+
+    s.reserve(1000);
+    EXPECT_EQ(1000, s.capacity());
+    EXPECT_EQ(1000 * (sizeof(int) + 8), s.byteCount());
+}
+
+
+namespace
+{
+    // A Fragile element's move constructor might throw, as far as the set
+    // can tell, and its copy constructor throws once copiesLeft runs out.
+    struct Fragile
+    {
+        static int live;
+        static int copiesLeft;
+
+        explicit Fragile(int value) : value{value} { live++; }
+
+        Fragile(const Fragile& f) : value{f.value}
+        {
+            if (copiesLeft-- == 0) throw std::runtime_error{"copy failed"};
+            live++;
+        }
+
+        Fragile(Fragile&& f) : value{f.value} { live++; }
+
+        ~Fragile() noexcept { live--; }
+
+        bool operator<(const Fragile& f) const { return value < f.value; }
+
+        int value;
+    };
+
+    int Fragile::live = 0;
+    int Fragile::copiesLeft = -1;
+}
+
+
+TEST(CompactAVLSetTests, failedResizeLeavesTheSetAsItWas)
+{
+    {
+        CompactAVLSet<Fragile> s;
+        for (int i = 0; i < 10; i++)
+        {
+            s.add(Fragile{i});
+        }
+
+        Fragile::copiesLeft = 4;
+        EXPECT_THROW(s.reserve(100), std::runtime_error);
+        Fragile::copiesLeft = -1;
+
+        EXPECT_EQ(10, Fragile::live);
+        EXPECT_EQ(10, s.size());
+        EXPECT_EQ(CompactAVLSet<Fragile>::DEFAULT_CAPACITY, s.capacity());
+
+        for (int i = 0; i < 10; i++)
+        {
+            EXPECT_TRUE(s.contains(Fragile{i}));
+        }
+    }
+
+    EXPECT_EQ(0, Fragile::live);
+}
+
+
+TEST(CompactAVLSetTests, canCopyAndMove)
+{
+    CompactAVLSet<std::string> s;
+    s.add("BOO");
+    s.add("HOO");
+    s.add("ALPHA");
+
+    CompactAVLSet<std::string> copy{s};
+    copy.add("ZEBRA");
+    EXPECT_EQ(3, s.size());
+    EXPECT_EQ(4, copy.size());
+    EXPECT_FALSE(s.contains("ZEBRA"));
+    EXPECT_TRUE(copy.contains("ALPHA"));
+
+    CompactAVLSet<std::string> moved{std::move(copy)};
+    EXPECT_EQ(4, moved.size());
+    EXPECT_TRUE(moved.contains("ZEBRA"));
+    EXPECT_EQ(0, copy.size());
+
+    copy = s;
+    EXPECT_EQ(3, copy.size());
+    EXPECT_TRUE(copy.contains("HOO"));
+}
+
+
+TEST(CompactAVLSetTests, containsStringViews)
+{
+    CompactAVLSet<std::string> s;
+    s.add("HELLO");
+    s.add("THERE");
+
+    std::string text = "HELLO THERE";
+    EXPECT_TRUE(s.contains(std::string_view{text}.substr(0, 5)));
+    EXPECT_TRUE(s.contains(std::string_view{text}.substr(6)));
+    EXPECT_FALSE(s.contains(std::string_view{text}.substr(0, 4)));
+}
@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include "ConcurrentHashSet.hpp"
+#include "StringHashing.hpp"
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+TEST(ConcurrentHashSetTests, constructEmpty_SizeIsZero)
+{
+    ConcurrentHashSet<std::string> h{hashStringAsProduct};
+    EXPECT_TRUE(h.isImplemented());
+    EXPECT_EQ(0, h.size());
+    EXPECT_FALSE(h.contains("hello"));
+}
+
+
+TEST(ConcurrentHashSetTests, containsElementsAfterAdding)
+{
+    ConcurrentHashSet<std::string> h{hashStringAsSum};
+    h.add("hello");
+    h.add("kaylee");
+    h.add("hello");
+    EXPECT_EQ(2, h.size());
+    EXPECT_TRUE(h.contains("hello"));
+    EXPECT_TRUE(h.contains("kaylee"));
+    EXPECT_FALSE(h.contains("stan"));
+}
+
+
+TEST(ConcurrentHashSetTests, resizesAndKeepsEveryElement)
+{
+    ConcurrentHashSet<int> h{[](const int& i) { return static_cast<unsigned int>(i); }};
+    for (int i = 0; i < 1000; i++)
+    {
+        h.add(i);
+    }
+    EXPECT_EQ(1000, h.size());
+    EXPECT_GT(h.capacity() * 4, h.size() * 5);
+    for (int i = 0; i < 1000; i++)
+    {
+        EXPECT_TRUE(h.contains(i));
+    }
+    EXPECT_FALSE(h.contains(1000));
+}
+
+
+TEST(ConcurrentHashSetTests, copyAndMove)
+{
+    ConcurrentHashSet<std::string> h{hashStringAsProduct};
+    h.add("hello");
+    h.add("kaylee");
+
+    ConcurrentHashSet<std::string> h2{h};
+    h.add("stan");
+    EXPECT_EQ(2, h2.size());
+    EXPECT_TRUE(h2.contains("kaylee"));
+    EXPECT_FALSE(h2.contains("stan"));
+
+    ConcurrentHashSet<std::string> h3{std::move(h)};
+    EXPECT_EQ(3, h3.size());
+    EXPECT_EQ(0, h.size());
+    EXPECT_EQ(0, h.capacity());
+    EXPECT_FALSE(h.contains("stan"));
+
+    h = h3;
+    EXPECT_EQ(3, h.size());
+    EXPECT_TRUE(h.contains("stan"));
+
+    h.add("butters");
+    EXPECT_EQ(4, h.size());
+    EXPECT_TRUE(h.contains("butters"));
+    EXPECT_FALSE(h3.contains("butters"));
+}
+
+
+TEST(ConcurrentHashSetTests, readersAndWritersRunTogether)
+{
+    constexpr int WRITERS = 4;
+    constexpr int READERS = 4;
+    constexpr int PRELOADED = 2000;
+    constexpr int PER_WRITER = 5000;
+
+    ConcurrentHashSet<std::string> h{hashStringAsProduct};
+    for (int i = 0; i < PRELOADED; i++)
+    {
+        h.add("P" + std::to_string(i));
+    }
+
+    std::atomic<bool> writing{true};
+    std::atomic<int> missingPreloaded{0};
+    std::atomic<int> spurious{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++)
+    {
+        readers.emplace_back([&]()
+        {
+            do
+            {
+                for (int i = 0; i < PRELOADED; i++)
+                {
+                    if (!h.contains("P" + std::to_string(i))) missingPreloaded++;
+                    if (h.contains("X" + std::to_string(i))) spurious++;
+                }
+            } while (writing.load());
+        });
+    }
+
+    // every writer adds its own words, plus words shared with the others
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; w++)
+    {
+        writers.emplace_back([&h, w]()
+        {
+            for (int i = 0; i < PER_WRITER; i++)
+            {
+                h.add("W" + std::to_string(w) + "_" + std::to_string(i));
+                h.add("S" + std::to_string(i));
+            }
+        });
+    }
+
+    for (std::thread& t : writers)
+    {
+        t.join();
+    }
+    writing.store(false);
+    for (std::thread& t : readers)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(0, missingPreloaded.load());
+    EXPECT_EQ(0, spurious.load());
+    EXPECT_EQ(PRELOADED + WRITERS * PER_WRITER + PER_WRITER, h.size());
+    for (int w = 0; w < WRITERS; w++)
+    {
+        for (int i = 0; i < PER_WRITER; i++)
+        {
+            ASSERT_TRUE(h.contains("W" + std::to_string(w) + "_" + std::to_string(i)));
+        }
+    }
+    for (int i = 0; i < PER_WRITER; i++)
+    {
+        ASSERT_TRUE(h.contains("S" + std::to_string(i)));
+    }
+}
+
+
+TEST(ConcurrentHashSetTests, writersToOneBucketFromDifferentStripesLoseNothing)
+{
+    constexpr int THREADS = 8;
+    constexpr int PER_THREAD = 100;
+
+    ConcurrentHashSet<int> h{[](const int& i) { return static_cast<unsigned int>(i); }};
+    h.reserve(THREADS * PER_THREAD);
+
+    // every key is a multiple of the capacity, so they all land in the
+    // same bucket, but their hash values spread them across the stripes
+    int cap = static_cast<int>(h.capacity());
+    ASSERT_NE(0, cap % ConcurrentHashSet<int>::STRIPE_COUNT);
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; t++)
+    {
+        writers.emplace_back(
+            [&h, cap, t]()
+            {
+                for (int k = t; k < THREADS * PER_THREAD; k += THREADS)
+                {
+                    h.add(k * cap);
+                }
+            });
+    }
+
+    for (std::thread& writer : writers)
+    {
+        writer.join();
+    }
+
+    EXPECT_EQ(THREADS * PER_THREAD, h.size());
+    EXPECT_EQ(cap, h.capacity());
+    for (int k = 0; k < THREADS * PER_THREAD; k++)
+    {
+        ASSERT_TRUE(h.contains(k * cap)) << k;
+    }
+}
+
+
+TEST(ConcurrentHashSetTests, containsStringViews)
+{
+    ConcurrentHashSet<std::string, HashStringAsProduct> inlined{HashStringAsProduct{}};
+    ConcurrentHashSet<std::string> h{hashStringAsProduct};
+    inlined.add("hello");
+    h.add("hello");
+
+    std::string buffer = "say hello there";
+    std::string_view view = std::string_view{buffer}.substr(4, 5);
+    EXPECT_TRUE(inlined.contains(view));
+    EXPECT_TRUE(h.contains(view));
+    EXPECT_FALSE(inlined.contains(view.substr(0, 4)));
+    EXPECT_FALSE(h.contains(view.substr(0, 4)));
+
+    const Set<std::string>& s = inlined;
+    EXPECT_TRUE(s.contains(view));
+    EXPECT_TRUE(s.contains("hello"));
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "CuckooHashSet.hpp"
+#include <string>
+#include <vector>
+
+
+TEST(CuckooHashSetTests, constructEmptyCuckooHashSet_SizeIsZero)
+{
+    CuckooHashSet<std::string> c;
+    ASSERT_TRUE(c.isImplemented());
+    ASSERT_EQ(0, c.size());
+    EXPECT_EQ(16, c.capacity());
+    EXPECT_FALSE(c.contains("hello"));
+}
+
+
+TEST(CuckooHashSetTests, containsTheGivenElements)
+{
+    CuckooHashSet<std::string> c;
+    c.add("hello");
+    c.add("kaylee");
+    c.add("a");
+    c.add("b");
+    c.add("hello");
+    EXPECT_EQ(4, c.size());
+    EXPECT_TRUE(c.contains("hello"));
+    EXPECT_TRUE(c.contains("kaylee"));
+    EXPECT_TRUE(c.contains("a"));
+    EXPECT_TRUE(c.contains("b"));
+    EXPECT_FALSE(c.contains("stan"));
+}
+
+
+TEST(CuckooHashSetTests, growsToHoldManyElements)
+{
+    CuckooHashSet<std::string> c;
+    for (int i = 0; i < 20000; i++)
+    {
+        c.add("word" + std::to_string(i));
+    }
+
+    EXPECT_EQ(20000, c.size());
+    EXPECT_LE(20000 * 10, c.capacity() * 9);
+    for (int i = 0; i < 20000; i++)
+    {
+        ASSERT_TRUE(c.contains("word" + std::to_string(i)));
+    }
+    for (int i = 20000; i < 21000; i++)
+    {
+        EXPECT_FALSE(c.contains("word" + std::to_string(i)));
+    }
+}
+
+
+TEST(CuckooHashSetTests, reserveMakesRoomUpFront)
+{
+    CuckooHashSet<std::string> c;
+    c.add("alex");
+    c.reserve(1000);
+    unsigned int capacity = c.capacity();
+    EXPECT_LE(1000 * 10, capacity * 9);
+    EXPECT_TRUE(c.contains("alex"));
+
+    for (int i = 0; i < 999; i++)
+    {
+        c.add(std::to_string(i));
+    }
+    EXPECT_EQ(1000, c.size());
+}
+
+
+struct WeakSeededHash
+{
+    std::uint64_t operator()(const std::string& word, std::uint64_t seed) const noexcept
+    {
+        // only the first seed is weak, putting every word in the same
+        // buckets, so the set has to rehash to hold more than eight
+        return seed == 0 ? 0 : HashStringSeeded{}(word, seed);
+    }
+};
+
+
+TEST(CuckooHashSetTests, rehashesWhenBucketsOverflow)
+{
+    CuckooHashSet<std::string, WeakSeededHash> c;
+    for (int i = 0; i < 12; i++)
+    {
+        c.add(std::to_string(i));
+    }
+
+    EXPECT_EQ(12, c.size());
+    for (int i = 0; i < 12; i++)
+    {
+        EXPECT_TRUE(c.contains(std::to_string(i)));
+    }
+    EXPECT_FALSE(c.contains("12"));
+}
+
+
+TEST(CuckooHashSetTests, containsStringViews)
+{
+    CuckooHashSet<std::string> c;
+    c.add("boo");
+    std::string buffer = "booth";
+    std::string_view view{buffer};
+    EXPECT_TRUE(c.contains(view.substr(0, 3)));
+    EXPECT_FALSE(c.contains(view));
+}
+
+
+TEST(CuckooHashSetTests, canBeCopiedAndMoved)
+{
+    CuckooHashSet<std::string> c;
+    c.add("alex");
+    c.add("boo");
+
+    CuckooHashSet<std::string> copy{c};
+    copy.add("cal");
+    EXPECT_EQ(3, copy.size());
+    EXPECT_EQ(2, c.size());
+    EXPECT_FALSE(c.contains("cal"));
+
+    CuckooHashSet<std::string> moved{std::move(copy)};
+    EXPECT_TRUE(moved.contains("cal"));
+    EXPECT_EQ(0, copy.size());
+    EXPECT_FALSE(copy.contains("cal"));
+    EXPECT_EQ(0, copy.capacity());
+    copy.add("dee");
+    EXPECT_TRUE(copy.contains("dee"));
+
+    CuckooHashSet<std::string> reserved{std::move(copy)};
+    copy.reserve(100);
+    EXPECT_LE(100 * 10, copy.capacity() * 9);
+    EXPECT_FALSE(copy.contains("dee"));
+
+    c = moved;
+    EXPECT_EQ(3, c.size());
+    EXPECT_TRUE(c.contains("boo"));
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include "FlatHashSet.hpp"
+#include "StringHashing.hpp"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+
+unsigned int flatHashZero(const int& a) {return 0;}
+
+
+TEST(FlatHashSetTests, constructEmptyFlatHashSet_SizeIsZero)
+{
+    FlatHashSet<int> h{flatHashZero};
+    ASSERT_TRUE(h.isImplemented());
+    ASSERT_EQ(0, h.size());
+    EXPECT_FALSE(h.contains(0));
+}
+
+
+TEST(FlatHashSetTests, containsTheGivenElements)
+{
+    FlatHashSet<std::string> h{hashStringAsProduct};
+    h.add("hello");
+    h.add("kaylee");
+    h.add("a");
+    h.add("b");
+    EXPECT_EQ(4, h.size());
+    EXPECT_TRUE(h.contains("hello"));
+    EXPECT_TRUE(h.contains("kaylee"));
+    EXPECT_TRUE(h.contains("b"));
+    EXPECT_FALSE(h.contains("stan"));
+}
+
+
+TEST(FlatHashSetTests, addExistElement_NoEffect)
+{
+    FlatHashSet<std::string> h{hashStringAsProduct};
+    h.add("hello");
+    h.add("hello");
+    h.add("kaylee");
+    EXPECT_EQ(2, h.size());
+}
+
+
+TEST(FlatHashSetTests, growsAndKeepsAllElements)
+{
+    FlatHashSet<int> h{[](const int& i) { return static_cast<unsigned int>(i); }};
+    for (int i = 0; i < 1000; i++)
+    {
+        h.add(i);
+    }
+    EXPECT_EQ(1000, h.size());
+    EXPECT_GE(h.capacity() * 7, h.size() * 8);
+    for (int i = 0; i < 1000; i++)
+    {
+        EXPECT_TRUE(h.contains(i));
+    }
+    EXPECT_FALSE(h.contains(1000));
+    EXPECT_FALSE(h.contains(-1));
+}
+
+
+TEST(FlatHashSetTests, allElementsCollide_StillFound)
+{
+    FlatHashSet<int> h{flatHashZero};
+    for (int i = 0; i < 100; i++)
+    {
+        h.add(i);
+    }
+    EXPECT_EQ(100, h.size());
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_TRUE(h.contains(i));
+    }
+    EXPECT_FALSE(h.contains(100));
+}
+
+
+TEST(FlatHashSetTests, copyExistingFlatHashSet)
+{
+    FlatHashSet<std::string> h{hashStringAsSum};
+    h.add("hello");
+    h.add("kaylee");
+    h.add("stan");
+
+    FlatHashSet<std::string> h2 = h;
+    h.add("nihap");
+    EXPECT_EQ(3, h2.size());
+    EXPECT_TRUE(h2.contains("kaylee"));
+    EXPECT_FALSE(h2.contains("nihap"));
+}
+
+
+namespace
+{
+    // A Counted element keeps track of how many Counted objects exist, and
+    // its copy constructor throws once copiesLeft copies have been made.
+    struct Counted
+    {
+        static int live;
+        static int copiesLeft;
+
+        explicit Counted(int value) : value{value} { live++; }
+
+        Counted(const Counted& c) : value{c.value}
+        {
+            if (copiesLeft-- == 0) throw std::runtime_error{"copy failed"};
+            live++;
+        }
+
+        Counted(Counted&& c) noexcept : value{c.value} { live++; }
+
+        ~Counted() noexcept { live--; }
+
+        bool operator==(const Counted& c) const { return value == c.value; }
+
+        int value;
+    };
+
+    int Counted::live = 0;
+    int Counted::copiesLeft = -1;
+}
+
+
+TEST(FlatHashSetTests, failedCopyDestroysTheElementsItCopied)
+{
+    {
+        FlatHashSet<Counted> h{[](const Counted& c) { return static_cast<unsigned int>(c.value); }};
+        for (int i = 0; i < 100; i++)
+        {
+            h.add(Counted{i});
+        }
+
+        int liveBefore = Counted::live;
+        Counted::copiesLeft = 50;
+        EXPECT_THROW(FlatHashSet<Counted>{h}, std::runtime_error);
+        Counted::copiesLeft = -1;
+
+        EXPECT_EQ(liveBefore, Counted::live);
+        EXPECT_EQ(100, h.size());
+    }
+
+    EXPECT_EQ(0, Counted::live);
+}
+
+
+TEST(FlatHashSetTests, moveExpiringFlatHashSet)
+{
+    FlatHashSet<std::string> h{hashStringAsProduct};
+    h.add("hello");
+    h.add("kaylee");
+
+    FlatHashSet<std::string> h2 = std::move(h);
+    EXPECT_EQ(2, h2.size());
+    EXPECT_TRUE(h2.contains("hello"));
+    EXPECT_EQ(0, h.size());
+    EXPECT_FALSE(h.contains("hello"));
+}
+
+
+TEST(FlatHashSetTests, movedFromFlatHashSetCanBeAddedToAndSearched)
+{
+    FlatHashSet<std::string> h{hashStringAsProduct};
+    h.add("hello");
+
+    FlatHashSet<std::string> h2{std::move(h)};
+    EXPECT_EQ(0, h.capacity());
+    EXPECT_FALSE(h.contains("hello"));
+
+    for (int i = 0; i < 100; i++)
+    {
+        h.add(std::to_string(i));
+    }
+    EXPECT_EQ(100, h.size());
+    EXPECT_TRUE(h.contains("99"));
+    EXPECT_FALSE(h.contains("hello"));
+    EXPECT_TRUE(h2.contains("hello"));
+
+    FlatHashSet<std::string> h3{std::move(h2)};
+    h2.reserve(10);
+    EXPECT_EQ(FlatHashSet<std::string>::DEFAULT_CAPACITY, h2.capacity());
+    h2.add("boo");
+    EXPECT_TRUE(h2.contains("boo"));
+    EXPECT_EQ(1, h3.size());
+}
+
+
+TEST(FlatHashSetTests, assignExistingAndExpiringFlatHashSet)
+{
+    FlatHashSet<std::string> h{hashStringAsProduct};
+    h.add("hello");
+    h.add("kaylee");
+
+    FlatHashSet<std::string> h2{hashStringAsZero};
+    h2.add("boo");
+    h2 = h;
+    EXPECT_EQ(2, h2.size());
+    EXPECT_FALSE(h2.contains("boo"));
+    EXPECT_TRUE(h2.contains("kaylee"));
+
+    FlatHashSet<std::string> h3{hashStringAsZero};
+    h3 = std::move(h2);
+    EXPECT_EQ(2, h3.size());
+    EXPECT_TRUE(h3.contains("hello"));
+}
+
+
+TEST(FlatHashSetTests, containsStringViews)
+{
+    FlatHashSet<std::string, HashStringAsProduct> inlined{HashStringAsProduct{}};
+    FlatHashSet<std::string> h{hashStringAsProduct};
+    inlined.add("hello");
+    h.add("hello");
+
+    std::string buffer = "say hello there";
+    std::string_view view = std::string_view{buffer}.substr(4, 5);
+    EXPECT_TRUE(inlined.contains(view));
+    EXPECT_TRUE(h.contains(view));
+    EXPECT_FALSE(inlined.contains(view.substr(0, 4)));
+    EXPECT_FALSE(h.contains(view.substr(0, 4)));
+
+    const Set<std::string>& s = inlined;
+    EXPECT_TRUE(s.contains(view));
+    EXPECT_TRUE(s.contains("hello"));
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "HashSet.hpp"
 #include "StringHashing.hpp"
+#include <cstdint>
 
 
 unsigned int hashZero(const int& a) {return 0;}
@@ -280,3 +281,530 @@ TEST(HashSetTests, assignExpiringHashSet)
     EXPECT_EQ(3, h.size());
 }
 
+
+
+TEST(HashSetTests, reserveAvoidsRehashingWhileAdding)
+{
+    HashSet<std::string> h{hashStringAsSum};
+    h.reserve(11);
+    h.add("qwert");
+    unsigned int index = hashStringAsSum("qwert") % 21;
+    EXPECT_TRUE(h.isElementAtIndex("qwert", index));
+
+    h.add("hello");
+    h.add("kaylee");
+    h.add("a");
+    h.add("b");
+    h.add("d");
+    h.add("e");
+    h.add("f");
+    h.add("g");
+    h.add("stan");
+    h.add("nihap");
+    EXPECT_EQ(11, h.size());
+    EXPECT_TRUE(h.isElementAtIndex("qwert", index));
+    EXPECT_TRUE(h.contains("kaylee"));
+}
+
+
+TEST(HashSetTests, reserveWithEnoughRoom_NoEffect)
+{
+    HashSet<std::string> h{hashStringAsZero};
+    h.add("hello");
+    h.add("kaylee");
+    h.reserve(5);
+    EXPECT_EQ(2, h.elementsAtIndex(0));
+    EXPECT_EQ(2, h.size());
+}
+
+
+TEST(HashSetTests, rehashingKeepsEveryElement)
+{
+    HashSet<int> h{[](const int& i) { return static_cast<unsigned int>(i); }};
+    for (int i = 0; i < 1000; i++)
+    {
+        h.add(i);
+    }
+    EXPECT_EQ(1000, h.size());
+    for (int i = 0; i < 1000; i++)
+    {
+        EXPECT_TRUE(h.contains(i));
+    }
+    EXPECT_FALSE(h.contains(1000));
+}
+
+
+TEST(HashSetTests, incrementalGrowthKeepsEveryElement)
+{
+    HashSet<int> h{[](const int& i) { return static_cast<unsigned int>(i); }, true};
+    for (int i = 0; i < 1000; i++)
+    {
+        h.add(i);
+        EXPECT_TRUE(h.contains(i));
+        EXPECT_TRUE(h.contains(i / 2));
+    }
+    EXPECT_EQ(1000, h.size());
+    for (int i = 0; i < 1000; i++)
+    {
+        EXPECT_TRUE(h.contains(i));
+    }
+    EXPECT_FALSE(h.contains(1000));
+}
+
+
+TEST(HashSetTests, incrementalGrowth_ElementAtIndexDuringMigration)
+{
+    HashSet<std::string> h{hashStringAsSum, true};
+    h.add("hello");
+    h.add("kaylee");
+    h.add("a");
+    h.add("b");
+    h.add("qwert");
+    h.add("d");
+    h.add("e");
+    h.add("f");
+
+    // the ninth element starts growing into an array of capacity 21
+    h.add("g");
+    unsigned int index = hashStringAsSum("qwert") % 21;
+    EXPECT_TRUE(h.isElementAtIndex("qwert", index));
+    EXPECT_EQ(9, h.size());
+
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < 21; i++)
+    {
+        total += h.elementsAtIndex(i);
+    }
+    EXPECT_EQ(9, total);
+}
+
+
+TEST(HashSetTests, incrementalGrowth_CopyAndMoveDuringMigration)
+{
+    HashSet<int> h{[](const int& i) { return static_cast<unsigned int>(i); }, true};
+    for (int i = 0; i < 9; i++)
+    {
+        h.add(i);
+    }
+
+    HashSet<int> h2 = h;
+    HashSet<int> h3{[](const int& i) { return 0u; }};
+    h3 = h;
+    HashSet<int> h4 = std::move(h);
+    for (int i = 0; i < 9; i++)
+    {
+        EXPECT_TRUE(h2.contains(i));
+        EXPECT_TRUE(h3.contains(i));
+        EXPECT_TRUE(h4.contains(i));
+    }
+
+    for (int i = 9; i < 100; i++)
+    {
+        h2.add(i);
+    }
+    EXPECT_EQ(100, h2.size());
+    EXPECT_TRUE(h2.contains(0));
+    EXPECT_TRUE(h2.contains(99));
+}
+
+
+TEST(HashSetTests, functorHashWithDefaultRange_SameIndicesAsFunction)
+{
+    HashSet<std::string, HashStringAsSum> h{HashStringAsSum{}};
+    h.add("qwert");
+    h.add("hello");
+    EXPECT_TRUE(h.isElementAtIndex("qwert", hashStringAsSum("qwert") % 10));
+    EXPECT_TRUE(h.contains("hello"));
+    EXPECT_FALSE(h.contains("stan"));
+}
+
+
+TEST(HashSetTests, primeRangeGrowsThroughPrimes)
+{
+    HashSet<std::string, HashStringAsSum, PrimeModuloRange> h{HashStringAsSum{}};
+    h.reserve(10);
+    h.add("qwert");
+    EXPECT_TRUE(h.isElementAtIndex("qwert", hashStringAsSum("qwert") % 23));
+}
+
+
+TEST(HashSetTests, powerOfTwoRangeMasksLowBits)
+{
+    HashSet<std::string, HashStringAsProduct, PowerOfTwoRange> h{HashStringAsProduct{}};
+    h.add("qwert");
+    EXPECT_TRUE(h.isElementAtIndex("qwert", hashStringAsProduct("qwert") & 15));
+    EXPECT_EQ(0, h.elementsAtIndex(16));
+}
+
+
+TEST(HashSetTests, rangePoliciesGrowPastFourBillion)
+{
+    EXPECT_EQ(6000000001ULL, ModuloRange::nextCapacity(3000000000ULL));
+    EXPECT_EQ(6743036717ULL, PrimeModuloRange::nextCapacity(3371518343ULL));
+    EXPECT_EQ(1ULL << 33, PowerOfTwoRange::nextCapacity(1ULL << 32));
+    EXPECT_EQ(1ULL << 33, FibonacciRange::nextCapacity(1ULL << 32));
+}
+
+
+TEST(HashSetTests, highBitsOf64BitHashValuesAreUsed)
+{
+    // each of these hash values differs only above the low 32 bits, so they
+    // would all land in the same bucket if the hash values were truncated
+    auto identity = [](const std::uint64_t& i) { return static_cast<std::size_t>(i); };
+    HashSet<std::uint64_t, decltype(identity), FibonacciRange> h{identity};
+    for (std::uint64_t i = 0; i < 64; i++)
+    {
+        h.add(i << 32);
+    }
+
+    EXPECT_EQ(64, h.size());
+    EXPECT_LT(h.elementsAtIndex(0), 64);
+    for (std::uint64_t i = 0; i < 64; i++)
+    {
+        EXPECT_TRUE(h.contains(i << 32));
+    }
+    EXPECT_FALSE(h.contains(1));
+}
+
+
+TEST(HashSetTests, canUseA64BitStringHash)
+{
+    HashSet<std::string, HashStringAs64Bits> h{HashStringAs64Bits{}};
+    h.add("hello");
+    h.add("kaylee");
+    EXPECT_EQ(2, h.size());
+    EXPECT_TRUE(h.contains("hello"));
+    EXPECT_TRUE(h.contains(std::string_view{"kaylee"}));
+    EXPECT_FALSE(h.contains("stan"));
+}
+
+
+TEST(HashSetTests, everyRangePolicyKeepsEveryElement)
+{
+    auto identity = [](const int& i) { return static_cast<unsigned int>(i); };
+    HashSet<int, decltype(identity), PrimeModuloRange> prime{identity};
+    HashSet<int, decltype(identity), PowerOfTwoRange> mask{identity};
+    HashSet<int, decltype(identity), FibonacciRange> fibonacci{identity};
+    for (int i = 0; i < 1000; i++)
+    {
+        prime.add(i * 16);
+        mask.add(i * 16);
+        fibonacci.add(i * 16);
+    }
+    EXPECT_EQ(1000, prime.size());
+    EXPECT_EQ(1000, mask.size());
+    EXPECT_EQ(1000, fibonacci.size());
+    for (int i = 0; i < 1000; i++)
+    {
+        EXPECT_TRUE(prime.contains(i * 16));
+        EXPECT_TRUE(mask.contains(i * 16));
+        EXPECT_TRUE(fibonacci.contains(i * 16));
+    }
+    EXPECT_FALSE(fibonacci.contains(1));
+}
+
+
+TEST(HashSetTests, collidingHashValuesStillCompareElements)
+{
+    HashSet<std::string> h{hashStringAsSum};
+    h.add("ab");
+    h.add("ba");
+    EXPECT_EQ(hashStringAsSum("ab"), hashStringAsSum("ba"));
+    EXPECT_EQ(2, h.size());
+    EXPECT_TRUE(h.contains("ab"));
+    EXPECT_TRUE(h.contains("ba"));
+    EXPECT_FALSE(h.contains("aa"));
+    EXPECT_FALSE(h.contains("ca"));
+}
+
+
+TEST(HashSetTests, containsStringViews)
+{
+    HashSet<std::string, HashStringAsProduct> inlined{HashStringAsProduct{}};
+    HashSet<std::string> h{hashStringAsProduct};
+    inlined.add("hello");
+    h.add("hello");
+
+    std::string buffer = "say hello there";
+    std::string_view view = std::string_view{buffer}.substr(4, 5);
+    EXPECT_TRUE(inlined.contains(view));
+    EXPECT_TRUE(h.contains(view));
+    EXPECT_FALSE(inlined.contains(view.substr(0, 4)));
+    EXPECT_FALSE(h.contains(view.substr(0, 4)));
+
+    const Set<std::string>& s = inlined;
+    EXPECT_TRUE(s.contains(view));
+    EXPECT_TRUE(s.contains("hello"));
+}
+
+
+TEST(HashSetTests, longChainsAreTreeifiedButStillCounted)
+{
+    HashSet<std::string> h{hashStringAsZero};
+    for (int i = 0; i < 2000; i++)
+    {
+        h.add(std::to_string(i));
+    }
+    h.add("7");
+
+    EXPECT_EQ(2000, h.size());
+    EXPECT_EQ(2000, h.elementsAtIndex(0));
+    EXPECT_TRUE(h.isElementAtIndex("1999", 0));
+    for (int i = 0; i < 2000; i++)
+    {
+        ASSERT_TRUE(h.contains(std::to_string(i)));
+    }
+    EXPECT_FALSE(h.contains("2000"));
+    EXPECT_FALSE(h.contains(std::string_view{"-1"}));
+}
+
+
+TEST(HashSetTests, treeifiedBucketsSurviveCopiesAndIncrementalGrowth)
+{
+    HashSet<std::string> h{hashStringAsZero, true};
+    for (int i = 0; i < 500; i++)
+    {
+        h.add(std::to_string(i));
+        ASSERT_TRUE(h.contains(std::to_string(i / 2)));
+    }
+
+    HashSet<std::string> copy{h};
+    HashSet<std::string> assigned{hashStringAsSum};
+    assigned = h;
+    for (int i = 0; i < 500; i++)
+    {
+        ASSERT_TRUE(copy.contains(std::to_string(i)));
+        ASSERT_TRUE(assigned.contains(std::to_string(i)));
+    }
+    EXPECT_FALSE(copy.contains("500"));
+    EXPECT_EQ(500, copy.elementsAtIndex(0));
+}
+
+
+namespace
+{
+    struct Unordered
+    {
+        int value;
+
+        bool operator==(const Unordered& other) const
+        {
+            return value == other.value;
+        }
+    };
+}
+
+
+TEST(HashSetTests, elementsThatCannotBeOrderedAreNeverTreeified)
+{
+    HashSet<Unordered> h{[](const Unordered&) { return 0u; }};
+    for (int i = 0; i < 100; i++)
+    {
+        h.add(Unordered{i});
+    }
+    EXPECT_EQ(100, h.size());
+    EXPECT_TRUE(h.contains(Unordered{99}));
+    EXPECT_FALSE(h.contains(Unordered{100}));
+}
+
+
+TEST(HashSetTests, selfOrganizingChainsMoveFoundElementsToTheFront)
+{
+    HashSet<std::string> h{hashStringAsZero, false, false, true};
+    h.add("ab");
+    h.add("ba");
+    h.add("cc");
+    h.countNodesVisited(true);
+
+    // all three are in the same chain, with "cc" at the front and "ab"
+    // at the back
+    unsigned long long before = h.nodesVisited();
+    EXPECT_TRUE(h.contains("ab"));
+    EXPECT_EQ(3, h.nodesVisited() - before);
+
+    before = h.nodesVisited();
+    EXPECT_TRUE(h.contains("ab"));
+    EXPECT_EQ(1, h.nodesVisited() - before);
+
+    EXPECT_EQ(3, h.size());
+    EXPECT_TRUE(h.contains("ba"));
+    EXPECT_TRUE(h.contains("cc"));
+    EXPECT_FALSE(h.contains("ca"));
+    EXPECT_EQ(3, h.elementsAtIndex(0));
+}
+
+
+TEST(HashSetTests, nodesVisitedAreNotCountedByDefault)
+{
+    HashSet<std::string> h{hashStringAsZero};
+    h.add("ab");
+    h.add("ba");
+    h.contains("ab");
+    EXPECT_EQ(0, h.nodesVisited());
+}
+
+
+TEST(HashSetTests, chainsKeepTheirOrderByDefault)
+{
+    HashSet<std::string> h{hashStringAsSum};
+    h.add("ab");
+    h.add("ba");
+    h.countNodesVisited(true);
+
+    unsigned long long before = h.nodesVisited();
+    h.contains("ab");
+    h.contains("ab");
+    EXPECT_EQ(4, h.nodesVisited() - before);
+}
+
+
+namespace
+{
+    std::vector<std::string> numberedWords(unsigned int first, unsigned int last)
+    {
+        std::vector<std::string> words;
+        for (unsigned int i = first; i < last; i++)
+        {
+            words.push_back("w" + std::to_string(i));
+        }
+        return words;
+    }
+}
+
+
+TEST(HashSetTests, addAllInParallelAddsEveryElementOnce)
+{
+    HashSet<std::string> h{hashStringAsProduct};
+    h.add("w5");
+
+    std::vector<std::string> words = numberedWords(0, 100000);
+    words.push_back("w17");
+    h.addAll(words, 4);
+
+    EXPECT_EQ(100000, h.size());
+    for (const std::string& word : words)
+    {
+        ASSERT_TRUE(h.contains(word));
+    }
+    EXPECT_FALSE(h.contains("w100000"));
+}
+
+
+TEST(HashSetTests, addAllInParallelWorksWithAPool)
+{
+    HashSet<std::string> h{hashStringAsProduct, false, true};
+    h.addAll(numberedWords(0, 80000), 4);
+    h.add("extra");
+
+    EXPECT_EQ(80001, h.size());
+    EXPECT_TRUE(h.contains("w79999"));
+    EXPECT_TRUE(h.contains("extra"));
+}
+
+
+TEST(HashSetTests, addAllInParallelRehashesInParallel)
+{
+    HashSet<std::string> h{hashStringAsProduct};
+    h.addAll(numberedWords(0, 70000), 4);
+    h.addAll(numberedWords(70000, 200000), 4);
+
+    EXPECT_EQ(200000, h.size());
+    EXPECT_TRUE(h.contains("w0"));
+    EXPECT_TRUE(h.contains("w69999"));
+    EXPECT_TRUE(h.contains("w199999"));
+    EXPECT_FALSE(h.contains("w200000"));
+}
+
+
+TEST(HashSetTests, addAllInParallelTreeifiesLongChains)
+{
+    HashSet<std::string> h{hashStringAsZero};
+    h.addAll(numberedWords(0, 70000), 4);
+
+    EXPECT_EQ(70000, h.size());
+    EXPECT_EQ(70000, h.elementsAtIndex(0));
+
+    unsigned long long before = h.nodesVisited();
+    EXPECT_TRUE(h.contains("w12345"));
+    EXPECT_LT(h.nodesVisited() - before, 40);
+}
+
+
+TEST(HashSetTests, addAllWithFewElementsAddsThemOneAtATime)
+{
+    HashSet<std::string> h{hashStringAsSum};
+    h.addAll(std::vector<std::string>{"ab", "ba", "ab"});
+
+    EXPECT_EQ(2, h.size());
+    EXPECT_TRUE(h.contains("ab"));
+    EXPECT_TRUE(h.contains("ba"));
+}
+
+
+TEST(HashSetTests, copyInParallelKeepsEveryElement)
+{
+    for (bool usePool : {false, true})
+    {
+        HashSet<std::string> h{hashStringAsProduct, false, usePool};
+        h.addAll(numberedWords(0, 100000), 4);
+
+        HashSet<std::string> copy{h, 4};
+        EXPECT_EQ(100000, copy.size());
+        for (std::size_t i = 0; i < 1000; i++)
+        {
+            ASSERT_EQ(h.elementsAtIndex(i), copy.elementsAtIndex(i));
+        }
+        EXPECT_TRUE(copy.contains("w0"));
+        EXPECT_TRUE(copy.contains("w99999"));
+
+        copy.add("extra");
+        EXPECT_TRUE(copy.contains("extra"));
+        EXPECT_FALSE(h.contains("extra"));
+        EXPECT_EQ(100000, h.size());
+    }
+}
+
+
+TEST(HashSetTests, copyInParallelWhileGrowingIncrementally)
+{
+    HashSet<int> h{[](const int& i) { return static_cast<unsigned int>(i); }, true};
+    for (int i = 0; i < 100000; i++)
+    {
+        h.add(i);
+    }
+
+    HashSet<int> copy{h, 4};
+    EXPECT_EQ(100000, copy.size());
+    for (int i = 0; i < 100000; i++)
+    {
+        ASSERT_TRUE(copy.contains(i));
+    }
+
+    for (int i = 100000; i < 110000; i++)
+    {
+        copy.add(i);
+    }
+    EXPECT_EQ(110000, copy.size());
+    EXPECT_TRUE(copy.contains(0));
+}
+
+
+TEST(HashSetTests, clearRemovesEveryElementAndKeepsTheSetUsable)
+{
+    for (bool usePool : {false, true})
+    {
+        HashSet<std::string> h{hashStringAsProduct, false, usePool};
+        h.addAll(numberedWords(0, 100000), 4);
+
+        h.clear(4);
+        EXPECT_EQ(0, h.size());
+        EXPECT_FALSE(h.contains("w0"));
+        EXPECT_EQ(0, h.elementsAtIndex(0));
+
+        h.add("w0");
+        h.addAll(numberedWords(1, 50000), 4);
+        EXPECT_EQ(50000, h.size());
+        EXPECT_TRUE(h.contains("w49999"));
+        EXPECT_FALSE(h.contains("w50000"));
+    }
+}
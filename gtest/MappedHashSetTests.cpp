@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "MappedHashSet.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    const std::string INDEX_PATH = "MappedHashSetTests.idx";
+
+
+    struct IndexFile
+    {
+        ~IndexFile()
+        {
+            std::remove(INDEX_PATH.c_str());
+        }
+    };
+}
+
+
+TEST(MappedHashSetTests, unopenedSetIsEmpty)
+{
+    MappedHashSet s;
+    EXPECT_TRUE(s.isImplemented());
+    EXPECT_EQ(0, s.size());
+    EXPECT_FALSE(s.contains("hello"));
+}
+
+
+TEST(MappedHashSetTests, containsTheWordsThatWereWritten)
+{
+    IndexFile file;
+    MappedHashSet::write({"hello", "kaylee", "hello", "", "boo"}, INDEX_PATH);
+
+    MappedHashSet s{INDEX_PATH};
+    EXPECT_EQ(4, s.size());
+    EXPECT_TRUE(s.contains("hello"));
+    EXPECT_TRUE(s.contains("kaylee"));
+    EXPECT_TRUE(s.contains(""));
+    EXPECT_TRUE(s.contains(std::string_view{"boo!"}.substr(0, 3)));
+    EXPECT_FALSE(s.contains("hell"));
+    EXPECT_FALSE(s.contains("helloo"));
+    EXPECT_FALSE(s.contains("stan"));
+}
+
+
+TEST(MappedHashSetTests, containsEveryWordOfALargeIndex)
+{
+    IndexFile file;
+    std::vector<std::string> words;
+    for (unsigned int i = 0; i < 20000; i++)
+    {
+        words.push_back(std::to_string(i * 7));
+    }
+    MappedHashSet::write(words, INDEX_PATH);
+
+    MappedHashSet s{INDEX_PATH};
+    EXPECT_EQ(20000, s.size());
+    for (unsigned int i = 0; i < 20000 * 7; i++)
+    {
+        ASSERT_EQ(i % 7 == 0, s.contains(std::to_string(i)));
+    }
+}
+
+
+TEST(MappedHashSetTests, emptyIndexContainsNothing)
+{
+    IndexFile file;
+    MappedHashSet::write({}, INDEX_PATH);
+
+    MappedHashSet s{INDEX_PATH};
+    EXPECT_EQ(0, s.size());
+    EXPECT_FALSE(s.contains(""));
+}
+
+
+TEST(MappedHashSetTests, addingOnlyWorksForWordsAlreadyThere)
+{
+    IndexFile file;
+    MappedHashSet::write({"hello"}, INDEX_PATH);
+
+    MappedHashSet s{INDEX_PATH};
+    s.add("hello");
+    EXPECT_EQ(1, s.size());
+    EXPECT_THROW(s.add("kaylee"), MappedHashSet::IndexException);
+}
+
+
+TEST(MappedHashSetTests, movedSetTakesOverTheMapping)
+{
+    IndexFile file;
+    MappedHashSet::write({"hello"}, INDEX_PATH);
+
+    MappedHashSet s{INDEX_PATH};
+    MappedHashSet s2{std::move(s)};
+    EXPECT_TRUE(s2.contains("hello"));
+    EXPECT_EQ(0, s.size());
+
+    s2.close();
+    EXPECT_FALSE(s2.contains("hello"));
+}
+
+
+TEST(MappedHashSetTests, openingSomethingOtherThanAnIndexFails)
+{
+    IndexFile file;
+    {
+        std::ofstream out{INDEX_PATH};
+        out << "hello\nkaylee\nstan\nboo\nthese words are not an index\n";
+    }
+
+    MappedHashSet s;
+    EXPECT_THROW(s.open(INDEX_PATH), MappedHashSet::IndexException);
+    EXPECT_THROW(s.open("no-such-index.idx"), MappedHashSet::IndexException);
+    EXPECT_EQ(0, s.size());
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include "NodePool.hpp"
+#include "AVLSet.hpp"
+#include "HashSet.hpp"
+#include "StringHashing.hpp"
+#include <string>
+
+
+namespace
+{
+    struct TestNode
+    {
+        std::string value;
+        TestNode* next;
+    };
+}
+
+
+TEST(NodePoolTests, emptyPoolHasNoSlabs)
+{
+    NodePool<TestNode> p;
+    EXPECT_EQ(0, p.stats().nodes);
+    EXPECT_EQ(0, p.stats().slabs);
+    EXPECT_EQ(0, p.stats().bytes);
+}
+
+
+TEST(NodePoolTests, createdNodesKeepTheirValues)
+{
+    NodePool<TestNode> p;
+    TestNode* first = p.create("a string too long to fit in the small buffer", nullptr);
+    TestNode* second = p.create("b", first);
+    EXPECT_EQ("a string too long to fit in the small buffer", first->value);
+    EXPECT_EQ("b", second->value);
+    EXPECT_EQ(first, second->next);
+    EXPECT_EQ(2, p.stats().nodes);
+    EXPECT_EQ(1, p.stats().slabs);
+}
+
+
+TEST(NodePoolTests, slabsGrowAndClearReleasesThem)
+{
+    NodePool<TestNode> p;
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        p.create(std::to_string(i), nullptr);
+    }
+    EXPECT_EQ(1000, p.stats().nodes);
+    EXPECT_LT(p.stats().slabs, 10);
+    EXPECT_GE(p.stats().bytes, 1000 * sizeof(TestNode));
+
+    p.clear();
+    EXPECT_EQ(0, p.stats().nodes);
+    EXPECT_EQ(0, p.stats().slabs);
+}
+
+
+TEST(NodePoolTests, movedPoolTakesOverNodes)
+{
+    NodePool<TestNode> p;
+    TestNode* n = p.create("hello", nullptr);
+    NodePool<TestNode> p2{std::move(p)};
+    EXPECT_EQ(0, p.stats().nodes);
+    EXPECT_EQ(1, p2.stats().nodes);
+    EXPECT_EQ("hello", n->value);
+}
+
+
+TEST(NodePoolTests, mergedPoolTakesOverTheOtherPoolsNodes)
+{
+    NodePool<TestNode> p;
+    NodePool<TestNode> p2;
+    TestNode* n = p.create("hello", nullptr);
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        p2.create(std::to_string(i), nullptr);
+    }
+
+    p.merge(std::move(p2));
+    EXPECT_EQ(1001, p.stats().nodes);
+    EXPECT_EQ(0, p2.stats().nodes);
+    EXPECT_EQ(0, p2.stats().slabs);
+    EXPECT_EQ("hello", n->value);
+
+    p.create("goodbye", nullptr);
+    EXPECT_EQ(1002, p.stats().nodes);
+}
+
+
+TEST(NodePoolTests, pooledHashSetBehavesLikeHashSet)
+{
+    HashSet<std::string> h{hashStringAsProduct, false, true};
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        h.add(std::to_string(i));
+    }
+    EXPECT_EQ(100, h.size());
+    EXPECT_EQ(100, h.poolStats().nodes);
+
+    HashSet<std::string> h2{hashStringAsZero};
+    h2.add("boo");
+    h2 = h;
+    HashSet<std::string> h3 = std::move(h);
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        EXPECT_TRUE(h2.contains(std::to_string(i)));
+        EXPECT_TRUE(h3.contains(std::to_string(i)));
+    }
+    EXPECT_FALSE(h2.contains("boo"));
+    EXPECT_EQ(100, h2.poolStats().nodes);
+}
+
+
+TEST(NodePoolTests, pooledAVLSetBehavesLikeAVLSet)
+{
+    AVLSet<int> a{true, true};
+    for (int i = 0; i < 100; i++)
+    {
+        a.add(i);
+    }
+    EXPECT_EQ(100, a.size());
+    EXPECT_EQ(6, a.height());
+    EXPECT_EQ(100, a.poolStats().nodes);
+
+    AVLSet<int> a2;
+    a2.add(1000);
+    a2 = a;
+    AVLSet<int> a3 = std::move(a);
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_TRUE(a2.contains(i));
+        EXPECT_TRUE(a3.contains(i));
+    }
+    EXPECT_FALSE(a2.contains(1000));
+    EXPECT_EQ(0, AVLSet<int>{}.poolStats().nodes);
+}
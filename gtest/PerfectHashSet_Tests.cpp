@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+#include "PerfectHashSet.hpp"
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+TEST(PerfectHashSetTests, constructEmptyPerfectHashSet_SizeIsZero)
+{
+    PerfectHashSet<std::string> p;
+    ASSERT_TRUE(p.isImplemented());
+    ASSERT_EQ(0, p.size());
+    EXPECT_FALSE(p.contains("hello"));
+}
+
+
+TEST(PerfectHashSetTests, containsTheGivenElements)
+{
+    PerfectHashSet<std::string> p{std::vector<std::string>{"hello", "kaylee", "a", "b"}};
+    EXPECT_EQ(4, p.size());
+    EXPECT_TRUE(p.contains("hello"));
+    EXPECT_TRUE(p.contains("kaylee"));
+    EXPECT_TRUE(p.contains("a"));
+    EXPECT_TRUE(p.contains("b"));
+    EXPECT_FALSE(p.contains("stan"));
+    EXPECT_FALSE(p.contains(""));
+}
+
+
+TEST(PerfectHashSetTests, duplicatesAreIgnored)
+{
+    PerfectHashSet<std::string> p;
+    p.add("hello");
+    p.add("hello");
+    EXPECT_EQ(1, p.size());
+    EXPECT_TRUE(p.contains("hello"));
+
+    p.add("hello");
+    EXPECT_EQ(1, p.size());
+}
+
+
+TEST(PerfectHashSetTests, stagedElementsAreFoundBeforeAndAfterBuilding)
+{
+    PerfectHashSet<std::string> p;
+    p.add("alex");
+    EXPECT_TRUE(p.contains("alex"));
+    EXPECT_FALSE(p.contains("boo"));
+
+    p.build();
+    p.add("boo");
+    p.add("cal");
+    EXPECT_EQ(3, p.size());
+    EXPECT_TRUE(p.contains("alex"));
+    EXPECT_TRUE(p.contains("boo"));
+    EXPECT_TRUE(p.contains(std::string_view{"cal"}));
+
+    p.build();
+    EXPECT_EQ(3, p.size());
+    EXPECT_TRUE(p.contains("alex"));
+    EXPECT_TRUE(p.contains("boo"));
+    EXPECT_TRUE(p.contains("cal"));
+    EXPECT_FALSE(p.contains("dee"));
+}
+
+
+TEST(PerfectHashSetTests, addAllBuildsRightAway)
+{
+    PerfectHashSet<std::string> p;
+    p.add("alex");
+    p.addAll(std::vector<std::string>{"boo", "cal"});
+
+    // once built, the elements are all in the perfect hash's array
+    EXPECT_EQ(3, p.size());
+    EXPECT_GE(p.byteCount(), 3 * sizeof(std::string));
+    EXPECT_TRUE(p.contains("alex"));
+    EXPECT_TRUE(p.contains("cal"));
+}
+
+
+TEST(PerfectHashSetTests, manyElementsAreAllFound)
+{
+    std::vector<std::string> words;
+    for (int i = 0; i < 20000; i++)
+    {
+        words.push_back("word" + std::to_string(i));
+    }
+
+    PerfectHashSet<std::string> p{words};
+    EXPECT_EQ(20000, p.size());
+
+    for (const std::string& word : words)
+    {
+        ASSERT_TRUE(p.contains(word));
+    }
+    for (int i = 20000; i < 21000; i++)
+    {
+        EXPECT_FALSE(p.contains("word" + std::to_string(i)));
+    }
+}
+
+
+TEST(PerfectHashSetTests, usesFewerThanOneByteOfDisplacementsPerElement)
+{
+    std::vector<std::string> words;
+    for (int i = 0; i < 10000; i++)
+    {
+        words.push_back(std::to_string(i));
+    }
+
+    PerfectHashSet<std::string> p{words};
+    unsigned long long displacementBytes = p.byteCount() - 10000 * sizeof(std::string);
+    EXPECT_LT(displacementBytes, 10000);
+}
+
+
+struct CollidingSeededHash
+{
+    std::uint64_t operator()(const std::string& word, std::uint64_t seed) const noexcept
+    {
+        // every word collides until the seed changes
+        return seed == 0 ? 42 : HashStringSeeded{}(word, seed);
+    }
+};
+
+
+TEST(PerfectHashSetTests, reseedsWhenHashValuesCollide)
+{
+    PerfectHashSet<std::string, CollidingSeededHash> p{
+        std::vector<std::string>{"alex", "boo", "cal", "dee", "eve"}};
+
+    EXPECT_EQ(5, p.size());
+    EXPECT_TRUE(p.contains("alex"));
+    EXPECT_TRUE(p.contains("eve"));
+    EXPECT_FALSE(p.contains("fred"));
+}
+
+
+TEST(PerfectHashSetTests, canBeCopiedAndMoved)
+{
+    PerfectHashSet<std::string> p{std::vector<std::string>{"alex", "boo"}};
+    p.add("cal");
+
+    PerfectHashSet<std::string> copy{p};
+    EXPECT_EQ(3, copy.size());
+    EXPECT_TRUE(copy.contains("alex"));
+    EXPECT_TRUE(copy.contains("cal"));
+
+    PerfectHashSet<std::string> moved{std::move(copy)};
+    EXPECT_EQ(3, moved.size());
+    EXPECT_TRUE(moved.contains("boo"));
+    EXPECT_EQ(0, copy.size());
+
+    PerfectHashSet<std::string> assigned;
+    assigned = moved;
+    EXPECT_TRUE(assigned.contains("boo"));
+    EXPECT_TRUE(p.contains("cal"));
+}
+
+
+TEST(PerfectHashSetTests, containsStringViews)
+{
+    PerfectHashSet<std::string> p{std::vector<std::string>{"alex", "boo"}};
+    std::string buffer = "booth";
+    std::string_view view{buffer};
+    EXPECT_TRUE(p.contains(view.substr(0, 3)));
+    EXPECT_FALSE(p.contains(view));
+}
+
+
+namespace
+{
+    // A Fragile element's copy assignment throws while failing is true,
+    // and its move assignment (which isn't noexcept) copies.
+    struct Fragile
+    {
+        static bool failing;
+
+        Fragile() = default;
+        Fragile(const char* s) : s{s} { }
+        Fragile(const Fragile&) = default;
+        Fragile(Fragile&&) noexcept = default;
+
+        Fragile& operator=(const Fragile& f)
+        {
+            if (failing) throw std::bad_alloc{};
+            s = f.s;
+            return *this;
+        }
+
+        Fragile& operator=(Fragile&& f)
+        {
+            return *this = static_cast<const Fragile&>(f);
+        }
+
+        bool operator==(const Fragile& f) const
+        {
+            return s == f.s;
+        }
+
+        std::string s;
+    };
+
+    bool Fragile::failing = false;
+
+
+    struct FragileHash
+    {
+        std::uint64_t operator()(const Fragile& f, std::uint64_t seed) const noexcept
+        {
+            return HashStringSeeded{}(f.s, seed);
+        }
+    };
+}
+
+
+TEST(PerfectHashSetTests, failedBuildLeavesTheSetAsItWas)
+{
+    PerfectHashSet<Fragile, FragileHash> p{std::vector<Fragile>{"alex", "boo"}};
+    p.add("cal");
+
+    Fragile::failing = true;
+    EXPECT_THROW(p.build(), std::bad_alloc);
+    Fragile::failing = false;
+
+    EXPECT_EQ(3, p.size());
+    EXPECT_TRUE(p.contains("alex"));
+    EXPECT_TRUE(p.contains("boo"));
+    EXPECT_TRUE(p.contains("cal"));
+
+    p.build();
+    EXPECT_EQ(3, p.size());
+    EXPECT_TRUE(p.contains("alex"));
+    EXPECT_TRUE(p.contains("cal"));
+    EXPECT_FALSE(p.contains("dee"));
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PersistentAVLSet.hpp"
+
+
+TEST(PersistentAVLSetTests, constructedSetIsEmpty)
+{
+    PersistentAVLSet<int> s;
+    EXPECT_TRUE(s.isImplemented());
+    EXPECT_EQ(0, s.size());
+    EXPECT_EQ(-1, s.height());
+    EXPECT_FALSE(s.contains(0));
+    EXPECT_EQ(0, s.snapshot().size());
+}
+
+
+TEST(PersistentAVLSetTests, addedElementsStayBalancedAndInOrder)
+{
+    PersistentAVLSet<int> s;
+    for (int i = 0; i < 1000; i++)
+    {
+        s.add(i);
+        s.add(-i);
+    }
+    s.add(0);
+
+    EXPECT_EQ(1999, s.size());
+    EXPECT_LE(s.height(), 14);
+
+    std::vector<int> visited;
+    s.inorder([&](int e) { visited.push_back(e); });
+    EXPECT_EQ(1999, visited.size());
+    EXPECT_TRUE(std::is_sorted(visited.begin(), visited.end()));
+
+    for (int i = -999; i < 1000; i++)
+    {
+        ASSERT_TRUE(s.contains(i));
+    }
+    EXPECT_FALSE(s.contains(1000));
+}
+
+
+TEST(PersistentAVLSetTests, snapshotsAreUnaffectedByLaterAdds)
+{
+    PersistentAVLSet<std::string> s;
+    s.add("boo");
+    s.add("alex");
+
+    PersistentAVLSet<std::string>::Snapshot before = s.snapshot();
+
+    // enough to rotate the nodes the snapshot's root shares
+    for (const char* word : {"cat", "dog", "emu", "fox", "gnu", "a", "aa"})
+    {
+        s.add(word);
+    }
+
+    EXPECT_EQ(9, s.size());
+    EXPECT_TRUE(s.contains("fox"));
+
+    EXPECT_EQ(2, before.size());
+    EXPECT_EQ(1, before.height());
+    EXPECT_TRUE(before.contains("boo"));
+    EXPECT_TRUE(before.contains("alex"));
+    EXPECT_FALSE(before.contains("fox"));
+
+    std::vector<std::string> visited;
+    before.inorder([&](const std::string& e) { visited.push_back(e); });
+    EXPECT_EQ((std::vector<std::string>{"alex", "boo"}), visited);
+}
+
+
+TEST(PersistentAVLSetTests, snapshotsOutliveTheirSet)
+{
+    PersistentAVLSet<int>::Snapshot snapshot;
+
+    {
+        PersistentAVLSet<int> s;
+        for (int i = 0; i < 10000; i++)
+        {
+            s.add(i);
+        }
+        snapshot = s.snapshot();
+    }
+
+    EXPECT_EQ(10000, snapshot.size());
+    EXPECT_TRUE(snapshot.contains(9999));
+    EXPECT_FALSE(snapshot.contains(10000));
+}
+
+
+TEST(PersistentAVLSetTests, copiesShareNodesButNotLaterAdds)
+{
+    PersistentAVLSet<int> s;
+    for (int i = 0; i < 100; i++)
+    {
+        s.add(i);
+    }
+
+    PersistentAVLSet<int> copy{s};
+    copy.add(100);
+    s.add(-1);
+
+    EXPECT_EQ(101, copy.size());
+    EXPECT_EQ(101, s.size());
+    EXPECT_TRUE(copy.contains(100));
+    EXPECT_FALSE(copy.contains(-1));
+    EXPECT_TRUE(s.contains(-1));
+    EXPECT_FALSE(s.contains(100));
+
+    copy = s;
+    EXPECT_TRUE(copy.contains(-1));
+    EXPECT_FALSE(copy.contains(100));
+}
+
+
+TEST(PersistentAVLSetTests, readersSeeConsistentSnapshotsWhileWriterAdds)
+{
+    constexpr int COUNT = 20000;
+
+    PersistentAVLSet<int> s;
+    std::atomic<bool> done{false};
+    std::atomic<unsigned int> inconsistencies{0};
+
+    // the writer adds 0, 1, 2, ... in order, so every snapshot a reader
+    // takes must hold exactly the elements less than its size
+    auto read = [&]()
+    {
+        while (!done)
+        {
+            PersistentAVLSet<int>::Snapshot snapshot = s.snapshot();
+            int expected = 0;
+            snapshot.inorder([&](int e) { if (e != expected++) inconsistencies++; });
+
+            if (static_cast<std::size_t>(expected) != snapshot.size()
+                || (expected > 0 && !snapshot.contains(expected - 1))
+                || snapshot.contains(expected))
+            {
+                inconsistencies++;
+            }
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; i++)
+    {
+        readers.emplace_back(read);
+    }
+
+    for (int i = 0; i < COUNT; i++)
+    {
+        s.add(i);
+    }
+
+    done = true;
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(0, inconsistencies);
+    EXPECT_EQ(COUNT, s.size());
+}
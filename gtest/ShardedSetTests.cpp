@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "AVLSet.hpp"
+#include "HashSet.hpp"
+#include "ShardedSet.hpp"
+#include "StringHashing.hpp"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    std::unique_ptr<Set<std::string>> makeHashShard()
+    {
+        return std::make_unique<HashSet<std::string>>(hashStringAsProduct);
+    }
+
+
+    std::unique_ptr<Set<std::string>> makeAVLShard()
+    {
+        return std::make_unique<AVLSet<std::string>>();
+    }
+}
+
+
+TEST(ShardedSetTests, constructEmpty_SizeIsZero)
+{
+    ShardedSet<std::string> s{hashStringAsProduct, makeHashShard};
+    EXPECT_TRUE(s.isImplemented());
+    EXPECT_EQ(0, s.size());
+    EXPECT_EQ(ShardedSet<std::string>::DEFAULT_SHARD_COUNT, s.shardCount());
+    EXPECT_FALSE(s.contains("hello"));
+}
+
+
+TEST(ShardedSetTests, containsElementsAfterAdding)
+{
+    ShardedSet<std::string> s{hashStringAsProduct, makeAVLShard, 4};
+    s.add("hello");
+    s.add("kaylee");
+    s.add("hello");
+
+    EXPECT_EQ(2, s.size());
+    EXPECT_TRUE(s.contains("hello"));
+    EXPECT_TRUE(s.contains("kaylee"));
+    EXPECT_TRUE(s.contains(std::string_view{"kaylee"}));
+    EXPECT_FALSE(s.contains("stan"));
+}
+
+
+TEST(ShardedSetTests, elementsAreSpreadAcrossShards)
+{
+    // even a hash function that uses few bits spreads elements out, since
+    // its values are mixed before choosing a shard
+    ShardedSet<std::string> s{hashStringAsSum, makeHashShard, 8};
+    for (unsigned int i = 0; i < 8000; i++)
+    {
+        s.add(std::to_string(i));
+    }
+
+    EXPECT_EQ(8000, s.size());
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        EXPECT_GT(s.shardSize(i), 0);
+    }
+}
+
+
+TEST(ShardedSetTests, addAllLoadsEveryShard)
+{
+    ShardedSet<std::string, HashStringAsProduct> s{HashStringAsProduct{}, makeHashShard, 8};
+
+    std::vector<std::string> words;
+    for (unsigned int i = 0; i < 50000; i++)
+    {
+        words.push_back("w" + std::to_string(i));
+    }
+    words.push_back("w0");
+
+    s.reserve(words.size());
+    s.addAll(words);
+
+    EXPECT_EQ(50000, s.size());
+    for (const std::string& word : words)
+    {
+        ASSERT_TRUE(s.contains(word));
+    }
+    EXPECT_FALSE(s.contains("w50000"));
+}
+
+
+TEST(ShardedSetTests, canAddFromManyThreadsAtOnce)
+{
+    ShardedSet<std::string> s{hashStringAsProduct, makeAVLShard};
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < 4; t++)
+    {
+        threads.emplace_back(
+            [&s, t]()
+            {
+                for (unsigned int i = 0; i < 2000; i++)
+                {
+                    s.add(std::to_string(i * 4 + t));
+                    s.contains(std::to_string(i));
+                }
+            });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(8000, s.size());
+    for (unsigned int i = 0; i < 8000; i++)
+    {
+        ASSERT_TRUE(s.contains(std::to_string(i)));
+    }
+}
+
+
+TEST(ShardedSetTests, selfOrganizingShardsCanBeSearchedFromManyThreads)
+{
+    // a self-organizing HashSet's contains() moves nodes around, so its
+    // shards have to be locked exclusively even to search them
+    ShardedSet<std::string> s{
+        hashStringAsZero,
+        []() { return std::make_unique<HashSet<std::string>>(hashStringAsZero, false, false, true); },
+        4, false};
+
+    for (unsigned int i = 0; i < 500; i++)
+    {
+        s.add(std::to_string(i));
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<unsigned int> found(4, 0);
+    for (unsigned int t = 0; t < 4; t++)
+    {
+        threads.emplace_back(
+            [&s, &found, t]()
+            {
+                for (unsigned int i = 0; i < 1000; i++)
+                {
+                    if (s.contains(std::to_string((i * 7 + t) % 500))) found[t]++;
+                }
+            });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (unsigned int t = 0; t < 4; t++)
+    {
+        EXPECT_EQ(1000, found[t]);
+    }
+}
+
+
+TEST(ShardedSetTests, movedSetTakesOverShards)
+{
+    ShardedSet<std::string> s{hashStringAsProduct, makeHashShard, 4};
+    s.add("hello");
+
+    ShardedSet<std::string> s2{std::move(s)};
+    EXPECT_EQ(1, s2.size());
+    EXPECT_TRUE(s2.contains("hello"));
+    EXPECT_EQ(4, s2.shardCount());
+}
+
+
+TEST(ShardedSetTests, shardsToFitDividesUpTheBytes)
+{
+    EXPECT_EQ(1, ShardedSet<std::string>::shardsToFit(0, 64));
+    EXPECT_EQ(1, ShardedSet<std::string>::shardsToFit(100, 64));
+    EXPECT_EQ(4, ShardedSet<std::string>::shardsToFit(4096, 64, 65536));
+    EXPECT_EQ(5, ShardedSet<std::string>::shardsToFit(4097, 64, 65536));
+}
@@ -21,8 +21,10 @@ class EmptySet : public Set<ElementType>
 public:
     bool isImplemented() const noexcept override;
     void add(const ElementType& element) override;
+    using Set<ElementType>::contains;
     bool contains(const ElementType& element) const override;
-    unsigned int size() const noexcept override;
+    bool contains(SetKeyType<ElementType> key) const override;
+    std::size_t size() const noexcept override;
 };
 
 
@@ -47,7 +49,14 @@ bool EmptySet<ElementType>::contains(const ElementType& element) const
 
 
 template <typename ElementType>
-unsigned int EmptySet<ElementType>::size() const noexcept
+bool EmptySet<ElementType>::contains(SetKeyType<ElementType> key) const
+{
+    return false;
+}
+
+
+template <typename ElementType>
+std::size_t EmptySet<ElementType>::size() const noexcept
 {
     return 0;
 }
@@ -11,6 +11,53 @@
 #ifndef SET_HPP
 #define SET_HPP
 
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace impl_
+{
+    // SetKey<ElementType> describes the "key" type that contains() can
+    // search for in place of an ElementType.  For sets of strings, that's a
+    // std::string_view, so that a string can be searched for without first
+    // allocating a std::string to hold it.  For everything else, it's just
+    // a reference to an ElementType.  get() turns a key into something
+    // that compares (and, with a suitable hash function, hashes) the same
+    // as the element it stands for.
+
+    template <typename ElementType>
+    struct SetKey
+    {
+        using type = std::reference_wrapper<const ElementType>;
+
+        static const ElementType& get(type key) noexcept
+        {
+            return key.get();
+        }
+    };
+
+
+    template <>
+    struct SetKey<std::string>
+    {
+        using type = std::string_view;
+
+        static std::string_view get(type key) noexcept
+        {
+            return key;
+        }
+    };
+}
+
+
+template <typename ElementType>
+using SetKeyType = typename impl_::SetKey<ElementType>::type;
+
 
 
 template <typename ElementType>
@@ -39,8 +86,51 @@ public:
     virtual bool contains(const ElementType& element) const = 0;
 
 
+    // contains() can also search for a key (see SetKeyType above) rather
+    // than an element.  By default, it makes an element out of the key and
+    // searches for that; implementations that can compare keys with their
+    // elements directly override it to avoid the copy.
+    virtual bool contains(SetKeyType<ElementType> key) const
+    {
+        return contains(ElementType{impl_::SetKey<ElementType>::get(key)});
+    }
+
+
+    // A string literal converts just as well to a std::string as to a
+    // std::string_view, so sets of strings search for one as a key.
+    template <
+        typename E = ElementType,
+        typename = std::enable_if_t<std::is_same_v<E, std::string>>>
+    bool contains(const char* element) const
+    {
+        return contains(std::string_view{element});
+    }
+
+
+    // addAll() adds every element in a vector to the set.  By default, it
+    // reserves room for them and then adds them one at a time, but an
+    // implementation can do better (e.g., by adding them in parallel).
+    virtual void addAll(const std::vector<ElementType>& elements)
+    {
+        reserve(size() + elements.size());
+
+        for (const ElementType& element : elements)
+        {
+            add(element);
+        }
+    }
+
+
+    // reserve() is a hint that at least n elements are about to be in the
+    // set, so implementations that grow as elements are added can size
+    // themselves once up front.  By default, it has no effect.
+    virtual void reserve(std::size_t n)
+    {
+    }
+
+
     // size() returns the number of elements in the set.
-    virtual unsigned int size() const noexcept = 0;
+    virtual std::size_t size() const noexcept = 0;
 };
 
 
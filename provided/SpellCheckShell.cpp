@@ -3,6 +3,7 @@
 // ICS 46 Winter 2022
 // Project #4: Set the Controls for the Heart of the Sun
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -10,10 +11,19 @@
 #include <vector>
 #include "SpellCheckShell.hpp"
 #include "AVLSet.hpp"
+#include "BTreeSet.hpp"
+#include "CompactAVLSet.hpp"
+#include "ConcurrentHashSet.hpp"
+#include "CuckooHashSet.hpp"
 #include "EmptySet.hpp"
+#include "FlatHashSet.hpp"
 #include "HashSet.hpp"
+#include "MappedHashSet.hpp"
 #include "OutputSpellCheckerListener.hpp"
+#include "PerfectHashSet.hpp"
+#include "PersistentAVLSet.hpp"
 #include "Set.hpp"
+#include "ShardedSet.hpp"
 #include "SkipListSet.hpp"
 #include "SpellChecker.hpp"
 #include "Stopwatch.hpp"
@@ -48,12 +58,69 @@ namespace
     }
 
 
-    std::unique_ptr<Set<std::string>> makeWordSet(const std::string& setType)
+    // The number of bytes a word takes up in a shard of a ShardedSet, which
+    // is roughly what the memory experiment measures for an AVLSet.
+    constexpr unsigned int BYTES_PER_SHARDED_WORD = 64;
+
+
+    // makeWordSet() makes an empty set of the given type, which will hold
+    // about wordCount words (or an unknown number, if it's zero).  A type
+    // beginning with "SHARDED " is a ShardedSet whose shards are sets of
+    // the type that follows it (e.g., "SHARDED HASH PRODUCT"), with enough
+    // shards that each fits in a cache, or the default number when the
+    // word count isn't known.  A "MAPPED HASH" is a MappedHashSet, which is
+    // given the path to an index (written by the experiment program's
+    // WRITE INDEX tool) in place of a word file.
+    std::unique_ptr<Set<std::string>> makeWordSet(
+        const std::string& setType, std::size_t wordCount = 0)
     {
-        if (setType == "AVL")
+        const std::string sharded = "SHARDED ";
+
+        if (setType.compare(0, sharded.length(), sharded) == 0)
+        {
+            std::string shardType = setType.substr(sharded.length());
+
+            // a MappedHashSet's words come from an index, not from add()
+            if (shardType == "MAPPED HASH")
+            {
+                throw SpellCheckShell::ShellException{"Invalid search structure type: " + setType};
+            }
+
+            // a self-organizing shard is modified by contains(), so it can't
+            // be searched by more than one thread at a time
+            bool sharedReads = shardType.find("SELF ORGANIZING") == std::string::npos;
+
+            using WordShardedSet = ShardedSet<std::string, HashStringAsProduct>;
+
+            unsigned int shardCount = wordCount == 0
+                ? WordShardedSet::DEFAULT_SHARD_COUNT
+                : WordShardedSet::shardsToFit(wordCount, BYTES_PER_SHARDED_WORD);
+
+            return std::make_unique<WordShardedSet>(
+                HashStringAsProduct{},
+                [shardType]() { return makeWordSet(shardType); },
+                shardCount, sharedReads);
+        }
+        else if (setType == "AVL")
         {
             return std::make_unique<AVLSet<std::string>>();
         }
+        else if (setType == "AVL POOLED")
+        {
+            return std::make_unique<AVLSet<std::string>>(true, true);
+        }
+        else if (setType == "AVL COMPACT")
+        {
+            return std::make_unique<CompactAVLSet<std::string>>();
+        }
+        else if (setType == "AVL PERSISTENT")
+        {
+            return std::make_unique<PersistentAVLSet<std::string>>();
+        }
+        else if (setType == "BTREE")
+        {
+            return std::make_unique<BTreeSet<std::string>>();
+        }
         else if (setType == "EMPTY")
         {
             return std::make_unique<EmptySet<std::string>>();
@@ -70,6 +137,70 @@ namespace
         {
             return std::make_unique<HashSet<std::string>>(hashStringAsProduct);
         }
+        else if (setType == "HASH 64 BIT")
+        {
+            return std::make_unique<HashSet<std::string, HashStringAs64Bits>>(
+                HashStringAs64Bits{});
+        }
+        else if (setType == "HASH PRODUCT INLINE")
+        {
+            return std::make_unique<HashSet<std::string, HashStringAsProduct>>(
+                HashStringAsProduct{});
+        }
+        else if (setType == "HASH PRODUCT PRIME")
+        {
+            return std::make_unique<HashSet<std::string, HashStringAsProduct, PrimeModuloRange>>(
+                HashStringAsProduct{});
+        }
+        else if (setType == "HASH PRODUCT MASK")
+        {
+            return std::make_unique<HashSet<std::string, HashStringAsProduct, PowerOfTwoRange>>(
+                HashStringAsProduct{});
+        }
+        else if (setType == "HASH PRODUCT FIBONACCI")
+        {
+            return std::make_unique<HashSet<std::string, HashStringAsProduct, FibonacciRange>>(
+                HashStringAsProduct{});
+        }
+        else if (setType == "HASH PRODUCT POOLED")
+        {
+            return std::make_unique<HashSet<std::string>>(hashStringAsProduct, false, true);
+        }
+        else if (setType == "HASH PRODUCT INCREMENTAL")
+        {
+            return std::make_unique<HashSet<std::string>>(hashStringAsProduct, true);
+        }
+        else if (setType == "HASH PRODUCT SELF ORGANIZING")
+        {
+            return std::make_unique<HashSet<std::string>>(hashStringAsProduct, false, false, true);
+        }
+        else if (setType == "CONCURRENT HASH PRODUCT")
+        {
+            return std::make_unique<ConcurrentHashSet<std::string, HashStringAsProduct>>(
+                HashStringAsProduct{});
+        }
+        else if (setType == "CUCKOO HASH")
+        {
+            return std::make_unique<CuckooHashSet<std::string>>();
+        }
+        else if (setType == "FLAT HASH SUM")
+        {
+            return std::make_unique<FlatHashSet<std::string, HashStringAsSum>>(
+                HashStringAsSum{});
+        }
+        else if (setType == "FLAT HASH PRODUCT")
+        {
+            return std::make_unique<FlatHashSet<std::string, HashStringAsProduct>>(
+                HashStringAsProduct{});
+        }
+        else if (setType == "MAPPED HASH")
+        {
+            return std::make_unique<MappedHashSet>();
+        }
+        else if (setType == "PERFECT HASH")
+        {
+            return std::make_unique<PerfectHashSet<std::string>>();
+        }
         else if (setType == "VECTOR")
         {
             return std::make_unique<VectorSet<std::string>>();
@@ -112,7 +243,8 @@ namespace
     enum class OutputType
     {
         Display,
-        TimeOnly
+        TimeOnly,
+        TimeBulk
     };
 
 
@@ -126,6 +258,10 @@ namespace
         {
             return OutputType::TimeOnly;
         }
+        else if (outputType == "TIME BULK")
+        {
+            return OutputType::TimeBulk;
+        }
         else
         {
             throw SpellCheckShell::ShellException{"Invalid output type: " + outputType};
@@ -133,9 +269,64 @@ namespace
     }
 
 
+    // isOrdered() returns true if sets of the given type keep their
+    // elements in order (the AVL trees and the B-tree), which is when
+    // loading words that are already sorted can make a difference.
+    bool isOrdered(const std::string& setType)
+    {
+        return setType.compare(0, 3, "AVL") == 0 || setType == "BTREE";
+    }
+
+
+    // A LoadMode says how the words get into the word set: added one at a
+    // time, added with one call to addAll(), or (for a MappedHashSet) not
+    // added at all, because the set opens an index of them instead.  A
+    // PerfectHashSet is always loaded with addAll(), which builds its
+    // perfect hash; words added one at a time would only be staged.
+    enum class LoadMode
+    {
+        OneAtATime,
+        Bulk,
+        Mapped
+    };
+
+
+    LoadMode makeLoadMode(const std::string& setType, OutputType outputType)
+    {
+        if (setType == "MAPPED HASH")
+        {
+            return LoadMode::Mapped;
+        }
+        else if (outputType == OutputType::TimeOnly && setType != "PERFECT HASH")
+        {
+            return LoadMode::OneAtATime;
+        }
+        else
+        {
+            return LoadMode::Bulk;
+        }
+    }
+
+
+    // openIndex() opens the index at the given path in a word set that's
+    // known to be a MappedHashSet.
+    void openIndex(Set<std::string>& wordSet, const std::string& indexPath)
+    {
+        try
+        {
+            static_cast<MappedHashSet&>(wordSet).open(indexPath);
+        }
+        catch (MappedHashSet::IndexException& e)
+        {
+            throw SpellCheckShell::ShellException{e.reason()};
+        }
+    }
+
+
     void runWithDisplay(
-        Set<std::string>& wordSet,
-        const std::string& wordFilePath, const std::string& textFilePath)
+        const std::string& setType,
+        const std::string& wordFilePath, const std::string& textFilePath,
+        LoadMode loadMode)
     {
         SpellChecker spellChecker;
 
@@ -147,28 +338,77 @@ namespace
         std::cout << std::endl;
         std::cout << "Loading word set from " << wordFilePath << " ..." << std::endl;
 
-        for (const std::string& word : WordSetLoader{}.load(wordFilePath))
+        std::unique_ptr<Set<std::string>> wordSet;
+
+        if (loadMode == LoadMode::Mapped)
         {
-            wordSet.add(word);
+            wordSet = makeWordSet(setType);
+            openIndex(*wordSet, wordFilePath);
+        }
+        else
+        {
+            std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+            wordSet = makeWordSet(setType, words.size());
+            wordSet->addAll(words);
         }
 
         std::cout << "Checking spelling in " << textFilePath << " ..." << std::endl;
 
-        WordChecker wordChecker{wordSet};
+        WordChecker wordChecker{*wordSet};
         TextFileReader reader{textFilePath};
 
         spellChecker.run(wordChecker, reader);
     }
 
 
+    // maxAddDuration() adds every word to the set, timing each add()
+    // individually, and returns the duration of the slowest one (in
+    // microseconds).  No room is reserved first, so the set resizes itself
+    // along the way, as often as it needs to.
+    double maxAddDuration(Set<std::string>& wordSet, const std::vector<std::string>& words)
+    {
+        Stopwatch addStopwatch;
+        double maxAddDuration = 0.0;
+
+        for (const std::string& word : words)
+        {
+            addStopwatch.start();
+            wordSet.add(word);
+            addStopwatch.stop();
+
+            maxAddDuration = std::max(maxAddDuration, addStopwatch.lastDuration());
+        }
+
+        return maxAddDuration;
+    }
+
+
+    // runTimingTest() loads the words into the set one add() at a time or
+    // with a single call to addAll(), which some sets can do faster (e.g.,
+    // in parallel).  When they're added one at a time, it then adds them
+    // to another set of the same type, timing each add() to find the
+    // slowest.  A MappedHashSet instead opens its index, in which case
+    // nothing is loaded into the empty set either.  When words are added
+    // one at a time into an ordered set (an AVL tree or B-tree) and turn
+    // out to be sorted, it also times loading another set of the same type
+    // with addAll(), which some of them (e.g., an AVLSet) can build from
+    // sorted words in linear time.
     void runTimingTest(
-        Set<std::string>& wordSet,
-        const std::string& wordFilePath, const std::string& textFilePath)
+        const std::string& setType,
+        const std::string& wordFilePath, const std::string& textFilePath,
+        LoadMode loadMode)
     {
         std::cout << std::endl;
-        std::cout << "Loading words from " << wordFilePath << " ..." << std::endl;
 
-        std::vector<std::string> words = WordSetLoader{}.load(wordFilePath);
+        std::vector<std::string> words;
+
+        if (loadMode != LoadMode::Mapped)
+        {
+            std::cout << "Loading words from " << wordFilePath << " ..." << std::endl;
+            words = WordSetLoader{}.load(wordFilePath);
+        }
+
+        std::unique_ptr<Set<std::string>> wordSet = makeWordSet(setType, words.size());
 
         SpellChecker spellChecker;
         Stopwatch stopwatch;
@@ -178,9 +418,22 @@ namespace
         {
             stopwatch.start();
 
-            for (const std::string& word : words)
+            if (loadMode == LoadMode::Mapped)
+            {
+                openIndex(*wordSet, wordFilePath);
+            }
+            else if (loadMode == LoadMode::Bulk)
+            {
+                wordSet->addAll(words);
+            }
+            else
             {
-                wordSet.add(word);
+                wordSet->reserve(words.size());
+
+                for (const std::string& word : words)
+                {
+                    wordSet->add(word);
+                }
             }
 
             stopwatch.stop();
@@ -193,7 +446,7 @@ namespace
 
         {
             stopwatch.start();
-            WordChecker wordChecker{wordSet};
+            WordChecker wordChecker{*wordSet};
             TextFileReader reader{textFilePath};
             spellChecker.run(wordChecker, reader);
             stopwatch.stop();
@@ -204,12 +457,22 @@ namespace
         EmptySet<std::string> emptySet;
         
         std::cout << "Storing words into empty set ..." << std::endl;
+
         {
             stopwatch.start();
 
-            for (const std::string& word : words)
+            if (loadMode != LoadMode::OneAtATime)
             {
-                emptySet.add(word);
+                emptySet.addAll(words);
+            }
+            else
+            {
+                emptySet.reserve(words.size());
+
+                for (const std::string& word : words)
+                {
+                    emptySet.add(word);
+                }
             }
 
             stopwatch.stop();
@@ -275,6 +538,75 @@ namespace
                      - (emptySetLoadDuration + emptySetSpellCheckDuration) << "usec";
 
         std::cout << std::endl;
+
+        if (loadMode != LoadMode::OneAtATime)
+        {
+            return;
+        }
+
+        std::cout << std::endl;
+        std::cout << "Storing words into another search structure and empty set, timing each add() ..."
+                  << std::endl;
+
+        double wordSetMaxAddDuration = maxAddDuration(*makeWordSet(setType, words.size()), words);
+
+        EmptySet<std::string> maxAddEmptySet;
+        double emptySetMaxAddDuration = maxAddDuration(maxAddEmptySet, words);
+
+        std::cout << std::endl;
+        std::cout << "                MaxAddTime" << std::endl;
+
+        std::cout << std::left << std::setw(12) << "Everything";
+
+        std::cout << std::right << std::fixed << std::setprecision(1) << std::setw(12)
+                  << wordSetMaxAddDuration << "usec";
+
+        std::cout << std::endl;
+
+        std::cout << std::left << std::setw(12) << "Empty Set";
+
+        std::cout << std::right << std::fixed << std::setprecision(1) << std::setw(12)
+                  << emptySetMaxAddDuration << "usec";
+
+        std::cout << std::endl;
+
+        if (!isOrdered(setType) || !std::is_sorted(words.begin(), words.end()))
+        {
+            return;
+        }
+
+        std::cout << std::endl;
+        std::cout << "Words are sorted; storing them into another search structure with addAll() ..."
+                  << std::endl;
+
+        double sortedLoadDuration = 0.0;
+
+        {
+            std::unique_ptr<Set<std::string>> sortedWordSet = makeWordSet(setType, words.size());
+
+            stopwatch.start();
+            sortedWordSet->addAll(words);
+            stopwatch.stop();
+
+            sortedLoadDuration = stopwatch.lastDuration();
+        }
+
+        std::cout << std::endl;
+        std::cout << "                LoadTime" << std::endl;
+
+        std::cout << std::left << std::setw(12) << "Sorted";
+
+        std::cout << std::right << std::fixed << std::setprecision(0) << std::setw(12)
+                  << sortedLoadDuration << "usec";
+
+        std::cout << std::endl;
+
+        std::cout << std::left << std::setw(12) << "Difference";
+
+        std::cout << std::right << std::fixed << std::setprecision(0) << std::setw(12)
+                  << (wordSetLoadDuration - sortedLoadDuration) << "usec";
+
+        std::cout << std::endl;
     }
 }
 
@@ -282,9 +614,12 @@ namespace
 
 void SpellCheckShell::run()
 {
-    std::unique_ptr<Set<std::string>> wordSet = makeWordSet(readString());
+    std::string setType = readString();
 
-    if (!wordSet->isImplemented())
+    // the word set itself isn't made until the words have been loaded,
+    // since how it's made (e.g., how many shards it has) can depend on
+    // how many words there are
+    if (!makeWordSet(setType)->isImplemented())
     {
         throw SpellCheckShell::ShellException{
             "Search structure type not implemented (did you change isImplemented() to return true?)"};
@@ -297,15 +632,17 @@ void SpellCheckShell::run()
     requireNonEmptyFileExists(textFilePath);
 
     OutputType outputType = makeOutputType(readString());
+    LoadMode loadMode = makeLoadMode(setType, outputType);
 
     switch (outputType)
     {
     case OutputType::Display:
-        runWithDisplay(*wordSet, wordFilePath, textFilePath);
+        runWithDisplay(setType, wordFilePath, textFilePath, loadMode);
         break;
 
     case OutputType::TimeOnly:
-        runTimingTest(*wordSet, wordFilePath, textFilePath);
+    case OutputType::TimeBulk:
+        runTimingTest(setType, wordFilePath, textFilePath, loadMode);
         break;
     }
 }
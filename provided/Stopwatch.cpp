@@ -34,7 +34,7 @@ void Stopwatch::stop()
         stopTime = std::chrono::high_resolution_clock::now();
 
         duration = 
-            std::chrono::duration_cast<std::chrono::microseconds>(stopTime - startTime)
+            std::chrono::duration<double, std::micro>(stopTime - startTime)
             .count();
 
         running = false;
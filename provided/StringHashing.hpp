@@ -4,17 +4,113 @@
 // Project #4: Set the Controls for the Heart of the Sun
 //
 // A collection of hash functions that are capable of hashing strings.
+// They take a std::string_view, so they hash a std::string and a view of
+// the same characters alike, and a view can be hashed without copying it
+// into a std::string.
 
 #ifndef STRINGHASHING_HPP
 #define STRINGHASHING_HPP
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 
 
-unsigned int hashStringAsZero(const std::string& word);
-unsigned int hashStringAsSum(const std::string& word);
-unsigned int hashStringAsProduct(const std::string& word);
+unsigned int hashStringAsZero(std::string_view word);
+unsigned int hashStringAsSum(std::string_view word);
+unsigned int hashStringAsProduct(std::string_view word);
+
+
+
+// The same hash functions, as functor types.  Their calls can be inlined
+// when they're used as the Hash type of a HashSet, unlike calls through a
+// function pointer or a std::function.
+
+struct HashStringAsZero
+{
+    unsigned int operator()(std::string_view word) const noexcept
+    {
+        return 0;
+    }
+};
+
+
+struct HashStringAsSum
+{
+    unsigned int operator()(std::string_view word) const noexcept
+    {
+        unsigned int hash = 0;
+
+        for (size_t i = 0; i < word.length(); ++i)
+        {
+            hash += static_cast<unsigned int>(word[i]);
+        }
+
+        return hash;
+    }
+};
+
+
+struct HashStringAsProduct
+{
+    unsigned int operator()(std::string_view word) const noexcept
+    {
+        unsigned int hash = 0;
+
+        for (size_t i = 0; i < word.length(); ++i)
+        {
+            hash *= 37;
+            hash += static_cast<unsigned int>(word[i]);
+        }
+
+        return hash;
+    }
+};
+
+
+
+// A seeded, 64-bit hash function, for structures that need a family of
+// strong, independent hash functions rather than just one (e.g., to build
+// a perfect hash, or to re-seed when too many elements collide).  It is
+// FNV-1a, with the seed folded into the starting state, followed by a
+// finalizer that mixes every input bit into every output bit.
+
+struct HashStringSeeded
+{
+    std::uint64_t operator()(std::string_view word, std::uint64_t seed) const noexcept
+    {
+        std::uint64_t hash = 0xCBF29CE484222325ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+
+        for (size_t i = 0; i < word.length(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(word[i]);
+            hash *= 0x100000001B3ULL;
+        }
+
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+};
+
+
+
+// A 64-bit hash function, for sets so large that a 32-bit hash value
+// couldn't give every element its own bucket (e.g., a HashSet with more
+// than 2^32 buckets).  It's HashStringSeeded with a fixed seed.
+
+struct HashStringAs64Bits
+{
+    std::uint64_t operator()(std::string_view word) const noexcept
+    {
+        return HashStringSeeded{}(word, 0);
+    }
+};
 
 
 
@@ -28,11 +28,16 @@ public:
 
     bool isImplemented() const noexcept override;
     void add(const ElementType& element) override;
+    using Set<ElementType>::contains;
     bool contains(const ElementType& element) const override;
-    unsigned int size() const noexcept override;
+    bool contains(SetKeyType<ElementType> key) const override;
+    std::size_t size() const noexcept override;
 
 private:
     std::vector<ElementType> elements;
+
+    template <typename Key>
+    bool containsKey(const Key& key) const;
 };
 
 
@@ -98,15 +103,30 @@ void VectorSet<ElementType>::add(const ElementType& element)
 
 template <typename ElementType>
 bool VectorSet<ElementType>::contains(const ElementType& element) const
+{
+    return containsKey(element);
+}
+
+
+template <typename ElementType>
+bool VectorSet<ElementType>::contains(SetKeyType<ElementType> key) const
+{
+    return containsKey(impl_::SetKey<ElementType>::get(key));
+}
+
+
+template <typename ElementType>
+template <typename Key>
+bool VectorSet<ElementType>::containsKey(const Key& key) const
 {
     return std::any_of(
         elements.begin(), elements.end(),
-        [&](ElementType e) { return e == element; });
+        [&](const ElementType& e) { return e == key; });
 }
 
 
 template <typename ElementType>
-unsigned int VectorSet<ElementType>::size() const noexcept
+std::size_t VectorSet<ElementType>::size() const noexcept
 {
     return elements.size();
 }